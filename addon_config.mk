@@ -96,6 +96,8 @@ linux64:
 	ADDON_LDFLAGS += -lboost_regex 
 	ADDON_LDFLAGS += -lnlopt
 	ADDON_LDFLAGS += -lm
+	# shm_open for the state bus, part of libc from glibc 2.34
+	ADDON_LDFLAGS += -lrt
 vs:
 	# After compiling copy the following dynamic libraries to the executable directory
 	# only windows visual studio
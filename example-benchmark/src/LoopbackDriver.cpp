@@ -0,0 +1,141 @@
+#include "LoopbackDriver.h"
+
+LoopbackDriver::LoopbackDriver(){
+    lastSentTick = -1;
+}
+
+LoopbackDriver::~LoopbackDriver(){
+    stopThread();
+}
+
+void LoopbackDriver::setup(vector<double> pose, int maxTicks, int port){
+    numJoints = pose.size();
+    initPose = pose;
+    currentPoseRadian = pose;
+    calculatedSpeed.assign(numJoints, 0);
+    currentSpeed.assign(numJoints, 0);
+    poseRaw.setup(pose);
+    toolPoseRaw.setup(pose);
+    poseProcessed.setup(pose);
+    packet.assign(numJoints + 1, 0);
+
+    setPoseMicros.assign(maxTicks, 0);
+    wakeMicros.assign(maxTicks, 0);
+    sentMicros.assign(maxTicks, 0);
+
+    receiver.Create();
+    receiver.Bind(port);
+    receiver.SetNonBlocking(true);
+    sender.Create();
+    sender.Connect("127.0.0.1", port);
+    sender.SetNonBlocking(true);
+}
+
+void LoopbackDriver::start(){
+    startThread();
+}
+
+void LoopbackDriver::disconnect(){
+    stopThread();
+}
+
+void LoopbackDriver::stopThread(){
+    if(isThreadRunning()){
+        ofThread::stopThread();
+        poseCond.notify_all();
+        waitForThread(false);
+    }
+}
+
+vector<double> LoopbackDriver::getInitPose(){
+    return initPose;
+}
+
+void LoopbackDriver::setTick(int tick){
+    std::unique_lock<std::mutex> locker(poseMutex);
+    pendingTick = tick;
+}
+
+void LoopbackDriver::setPose(vector<double> pose){
+    uint64_t now = ofGetElapsedTimeMicros();
+    std::unique_lock<std::mutex> locker(poseMutex);
+    if(pendingTick >= 0 && pendingTick < (int)setPoseMicros.size()){
+        setPoseMicros[pendingTick] = now;
+    }
+    currentPose = pose;
+    currentTick = pendingTick;
+    bMove = true;
+    bMoveWithPos = true;
+    deccelCount = numDeccelSteps + 4;
+    bNewPose = true;
+    locker.unlock();
+    poseCond.notify_one();
+}
+
+vector<double> LoopbackDriver::getCurrentPose(){
+    vector<double> ret;
+    lock();
+    poseRaw.swapFront();
+    ret = poseRaw.getFront();
+    unlock();
+    return ret;
+}
+
+bool LoopbackDriver::waitForTick(int tick, int timeoutMs){
+    uint64_t deadline = ofGetElapsedTimeMillis() + timeoutMs;
+    while(lastSentTick.load() < tick){
+        if(ofGetElapsedTimeMillis() > deadline){
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+int LoopbackDriver::drain(){
+    char buffer[512];
+    int total = 0;
+    int ret;
+    while((ret = receiver.Receive(buffer, sizeof(buffer))) > 0){
+        total += ret;
+    }
+    return total;
+}
+
+void LoopbackDriver::threadedFunction(){
+    vector<double> target;
+    while(isThreadRunning()){
+        int tick;
+        {
+            std::unique_lock<std::mutex> locker(poseMutex);
+            poseCond.wait(locker, [this]{ return bNewPose || !isThreadRunning(); });
+            if(!isThreadRunning()){
+                break;
+            }
+            bNewPose = false;
+            target = currentPose;
+            tick = currentTick;
+        }
+        uint64_t wake = ofGetElapsedTimeMicros();
+
+        target = getAchievablePosition(target);
+        bMove = false;
+        packet[0] = htonl(1);
+        for(int i = 0; i < numJoints; i++){
+            packet[i + 1] = htonl((int32_t)(target[i] * 1000000.0));
+        }
+        sender.Send((const char *)packet.data(), packet.size() * sizeof(int32_t));
+        uint64_t sent = ofGetElapsedTimeMicros();
+
+        // echo the command back as the measured pose, like a perfect servo
+        currentPoseRadian = target;
+        poseRaw.getBack() = target;
+        poseRaw.swapBack();
+
+        if(tick >= 0 && tick < (int)sentMicros.size()){
+            wakeMicros[tick] = wake;
+            sentMicros[tick] = sent;
+            lastSentTick = tick;
+        }
+    }
+}
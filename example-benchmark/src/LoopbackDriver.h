@@ -0,0 +1,62 @@
+//
+//  LoopbackDriver.h
+//  example-benchmark
+//
+//  Stands in for a real arm: consumes setPose on its own thread, runs the
+//  same getAchievablePosition step the real drivers do, packs the joints
+//  like the UR reverse interface (int32 * 1e6, network order) and sends
+//  them over a UDP socket on localhost.
+//
+#pragma once
+#include "ofMain.h"
+#include "ofxNetwork.h"
+#include "RobotDriver.h"
+
+class LoopbackDriver : public ofxRobotArm::RobotDriver{
+public:
+    LoopbackDriver();
+    ~LoopbackDriver();
+
+    void setup(vector<double> initPose, int maxTicks, int port = 30099);
+
+    void setAllowReconnect(bool bDoReconnect){};
+    void setup(){};
+    void setup(string ipAddress, int port, double minPayload = 0.0, double maxPayload = 1.0){};
+    void setup(string ipAddress, double minPayload = 0.0, double maxPayload = 1.0){};
+    void setup(int port, double minPayload = 0.0, double maxPayload = 1.0){};
+    void start();
+    bool isConnected(){ return isThreadRunning(); };
+    void disconnect();
+    void stopThread();
+    void toggleTeachMode(){};
+    void setTeachMode(bool enabled){};
+    void threadedFunction();
+    vector<double> getInitPose();
+
+    void setPose(vector<double> pose);
+    vector<double> getCurrentPose();
+
+    /// \brief tags the next setPose with a tick id, -1 disables timing
+    void setTick(int tick);
+    /// \brief blocks until the driver has sent the pose for tick, false on timeout
+    bool waitForTick(int tick, int timeoutMs = 100);
+    /// \brief drains the receiving end of the loopback socket, returns bytes read
+    int drain();
+
+    // host time (us) per tick, filled by setPose and the driver thread
+    vector<uint64_t> setPoseMicros;
+    vector<uint64_t> wakeMicros;
+    vector<uint64_t> sentMicros;
+
+protected:
+    std::mutex poseMutex;
+    std::condition_variable poseCond;
+    bool bNewPose = false;
+    int pendingTick = -1;
+    int currentTick = -1;
+    std::atomic<int> lastSentTick;
+
+    ofxUDPManager sender;
+    ofxUDPManager receiver;
+    vector<int32_t> packet;
+};
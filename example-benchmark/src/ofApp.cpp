@@ -0,0 +1,217 @@
+#include "ofApp.h"
+#include <time.h>
+#include <numeric>
+#include <iomanip>
+
+using namespace ofxRobotArm;
+
+// count every heap allocation in the process, the driver thread included
+static std::atomic<uint64_t> allocationCount(0);
+
+void * operator new(size_t size){
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void * p = malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void * p) noexcept{
+    free(p);
+}
+void operator delete(void * p, size_t) noexcept{
+    free(p);
+}
+
+static uint64_t threadCpuMicros(){
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+    ofSetLogLevel(OF_LOG_WARNING);
+    parseArgs();
+    for(auto & run : runs){
+        runBenchmark(run);
+    }
+    bDone = true;
+}
+
+//--------------------------------------------------------------
+void ofApp::parseArgs(){
+    struct RobotEntry{ string name; RobotType type; string urdf; };
+    vector<RobotEntry> robots = {
+        {"UR5", UR5, "ur5.urdf"},
+        {"UR10", UR10, "ur10.urdf"},
+        {"IRB120", IRB120, "irb120.urdf"},
+        {"IRB4600", IRB4600, "irb4600_60_205.urdf"},
+        {"IRB6700", IRB6700, "irb6700_235_265.urdf"},
+        {"XARM7", XARM7, "xarm7.urdf"},
+    };
+    map<string, IKType> iks = {{"SW", SW}, {"HK", HK}, {"RELAXED", RELAXED}};
+
+    vector<string> robotNames = {"UR5", "UR10", "IRB120", "IRB4600", "IRB6700"};
+    vector<string> ikNames = {"HK", "SW"};
+    for(size_t i = 1; i + 1 < args.size(); i += 2){
+        string key = args[i];
+        string value = args[i + 1];
+        if(key == "--robot") robotNames = ofSplitString(value, ",", true, true);
+        else if(key == "--ik") ikNames = ofSplitString(value, ",", true, true);
+        else if(key == "--ticks") numTicks = ofToInt(value);
+        else if(key == "--warmup") numWarmup = ofToInt(value);
+        else if(key == "--label") label = value;
+        else if(key == "--out") outPath = value;
+        else ofLogWarning("benchmark") << "unknown argument " << key;
+    }
+
+    for(auto & robotName : robotNames){
+        for(auto & ikName : ikNames){
+            auto robot = std::find_if(robots.begin(), robots.end(), [&](const RobotEntry & e){ return e.name == robotName; });
+            if(robot == robots.end() || iks.find(ikName) == iks.end()){
+                ofLogWarning("benchmark") << "skipping unknown robot/ik " << robotName << "/" << ikName;
+                continue;
+            }
+            Run run;
+            run.robotType = robot->type;
+            run.ikType = iks[ikName];
+            run.robotName = robotName;
+            run.ikName = ikName;
+            run.urdf = "relaxed_ik_core/config/urdfs/" + robot->urdf;
+            runs.push_back(run);
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::runBenchmark(const Run & run){
+    // offline setup builds the model and IK without opening a socket,
+    // then the real driver is swapped for the loopback one.
+    // The offline driver is left alone, some destructors assume a connection.
+    LegacyRobotController * controller = new LegacyRobotController();
+    controller->setup("127.0.0.1", 0, ofToDataPath(run.urdf), run.robotType, run.ikType, true);
+
+    int totalTicks = numWarmup + numTicks;
+    LoopbackDriver driver;
+    driver.setup(controller->robot->getInitPose(), totalTicks);
+    controller->robot = &driver;
+    controller->setEnableMovement(true);
+    driver.start();
+
+    ofNode home = controller->getForwardNode();
+    ofVec3f center = home.getGlobalPosition() * 1000.0;
+    ofQuaternion orientation = home.getGlobalOrientation();
+
+    vector<double> robotData, ik, smoothing, handoff, driverSend, endToEnd, cpu, allocations;
+    int dropped = 0;
+
+    for(int tick = 0; tick < totalTicks; tick++){
+        // deterministic lissajous around the home TCP, 50mm amplitude
+        double t = tick / 125.0;
+        ofNode target;
+        target.setGlobalPosition(center + ofVec3f(50 * sin(t * 1.3), 50 * sin(t * 1.7), 30 * sin(t * 0.9)));
+        target.setGlobalOrientation(orientation);
+
+        uint64_t allocStart = allocationCount.load();
+        uint64_t cpuStart = threadCpuMicros();
+        uint64_t t0 = ofGetElapsedTimeMicros();
+
+        driver.setTick(tick);
+        controller->setDesiredPose(target);
+        controller->updateRobotData();
+        uint64_t t1 = ofGetElapsedTimeMicros();
+        controller->updateIK(controller->desiredModel.getModifiedTCPPose());
+        uint64_t t2 = ofGetElapsedTimeMicros();
+        controller->updateMovement();
+        uint64_t cpuEnd = threadCpuMicros();
+
+        if(!driver.waitForTick(tick)){
+            dropped++;
+            continue;
+        }
+        uint64_t allocEnd = allocationCount.load();
+        driver.drain();
+
+        if(tick < numWarmup){
+            continue;
+        }
+        robotData.push_back(t1 - t0);
+        ik.push_back(t2 - t1);
+        smoothing.push_back(driver.setPoseMicros[tick] - t2);
+        handoff.push_back(driver.wakeMicros[tick] - driver.setPoseMicros[tick]);
+        driverSend.push_back(driver.sentMicros[tick] - driver.wakeMicros[tick]);
+        endToEnd.push_back(driver.sentMicros[tick] - t0);
+        cpu.push_back(cpuEnd - cpuStart);
+        allocations.push_back(allocEnd - allocStart);
+    }
+
+    driver.stopThread();
+    controller->robot = nullptr;
+    delete controller;
+
+    if(dropped > 0){
+        ofLogWarning("benchmark") << run.robotName << "/" << run.ikName << ": " << dropped << " ticks never reached the socket";
+    }
+
+    vector<Stats> stats;
+    stats.push_back(summarize("robot_data_us", robotData));
+    stats.push_back(summarize("ik_us", ik));
+    stats.push_back(summarize("smoothing_us", smoothing));
+    stats.push_back(summarize("handoff_us", handoff));
+    stats.push_back(summarize("driver_send_us", driverSend));
+    stats.push_back(summarize("end_to_end_us", endToEnd));
+    stats.push_back(summarize("cpu_per_tick_us", cpu));
+    stats.push_back(summarize("allocs_per_tick", allocations));
+    report(run, stats);
+}
+
+//--------------------------------------------------------------
+ofApp::Stats ofApp::summarize(string stage, vector<double> values){
+    Stats s;
+    s.stage = stage;
+    s.p50 = s.p90 = s.p99 = s.max = s.mean = 0;
+    if(values.empty()){
+        return s;
+    }
+    std::sort(values.begin(), values.end());
+    auto at = [&](double q){ return values[std::min(values.size() - 1, (size_t)(q * (values.size() - 1) + 0.5))]; };
+    s.p50 = at(0.50);
+    s.p90 = at(0.90);
+    s.p99 = at(0.99);
+    s.max = values.back();
+    s.mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    return s;
+}
+
+//--------------------------------------------------------------
+void ofApp::report(const Run & run, const vector<Stats> & stats){
+    cout << endl << "== " << run.robotName << " / " << run.ikName << " (" << numTicks << " ticks, label " << label << ")" << endl;
+    cout << setw(18) << left << "stage" << right
+         << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "max" << setw(10) << "mean" << endl;
+    for(auto & s : stats){
+        cout << setw(18) << left << s.stage << right << fixed << setprecision(1)
+             << setw(10) << s.p50 << setw(10) << s.p90 << setw(10) << s.p99 << setw(10) << s.max << setw(10) << s.mean << endl;
+    }
+
+    string path = ofToDataPath(outPath);
+    bool bHeader = !ofFile::doesFileExist(path);
+    ofFile file(path, ofFile::Append);
+    if(bHeader){
+        file << "label,robot,ik,ticks,stage,p50,p90,p99,max,mean" << endl;
+    }
+    for(auto & s : stats){
+        file << label << "," << run.robotName << "," << run.ikName << "," << numTicks << "," << s.stage << ","
+             << s.p50 << "," << s.p90 << "," << s.p99 << "," << s.max << "," << s.mean << endl;
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+    if(bDone){
+        ofExit(0);
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+
+}
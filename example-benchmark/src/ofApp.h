@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ofMain.h"
+#include "LegacyRobotController.h"
+#include "LoopbackDriver.h"
+
+class ofApp : public ofBaseApp{
+
+    public:
+        struct Run{
+            ofxRobotArm::RobotType robotType;
+            ofxRobotArm::IKType ikType;
+            string robotName;
+            string ikName;
+            string urdf;
+        };
+
+        struct Stats{
+            string stage;
+            double p50, p90, p99, max, mean;
+        };
+
+        void setup();
+        void update();
+        void draw();
+
+        void parseArgs();
+        void runBenchmark(const Run & run);
+        Stats summarize(string stage, vector<double> values);
+        void report(const Run & run, const vector<Stats> & stats);
+
+        vector<string> args;
+        vector<Run> runs;
+        int numTicks = 2000;
+        int numWarmup = 200;
+        string label = "local";
+        string outPath = "benchmark.csv";
+        bool bDone = false;
+};
@@ -0,0 +1,150 @@
+#include "EgmEmulator.h"
+
+using namespace abb::egm;
+
+EgmEmulator::EgmEmulator(){
+    resumeMicros = 0;
+    numSent = 0;
+    numReplies = 0;
+    numSessions = 0;
+}
+
+EgmEmulator::~EgmEmulator(){
+    stop();
+}
+
+void EgmEmulator::setup(int port, vector<double> initPoseDeg, int rate){
+    this->rate = rate;
+    joints = initPoseDeg;
+    inBuffer.assign(4096, 0);
+    latencies.reserve(rate * 60);
+
+    socket.Create();
+    socket.Connect("127.0.0.1", port);
+    socket.SetNonBlocking(true);
+
+    // everything but the joints and the header stays the same for the whole run
+    message.mutable_header()->set_mtype(EgmHeader_MessageType_MSGTYPE_DATA);
+    EgmPose * poses[] = {message.mutable_feedback()->mutable_cartesian(), message.mutable_planned()->mutable_cartesian()};
+    for(auto pose : poses){
+        pose->mutable_pos()->set_x(0);
+        pose->mutable_pos()->set_y(0);
+        pose->mutable_pos()->set_z(0);
+        pose->mutable_orient()->set_u0(1);
+        pose->mutable_orient()->set_u1(0);
+        pose->mutable_orient()->set_u2(0);
+        pose->mutable_orient()->set_u3(0);
+    }
+    for(size_t i = 0; i < joints.size(); i++){
+        message.mutable_feedback()->mutable_joints()->add_joints(joints[i]);
+        message.mutable_planned()->mutable_joints()->add_joints(joints[i]);
+    }
+    message.mutable_motorstate()->set_state(EgmMotorState_MotorStateType_MOTORS_ON);
+    message.mutable_mcistate()->set_state(EgmMCIState_MCIStateType_MCI_RUNNING);
+    message.mutable_rapidexecstate()->set_state(EgmRapidCtrlExecState_RapidCtrlExecStateType_RAPID_RUNNING);
+    message.set_mciconvergencemet(true);
+}
+
+void EgmEmulator::start(){
+    startThread();
+}
+
+void EgmEmulator::stop(){
+    if(isThreadRunning()){
+        ofThread::stopThread();
+        waitForThread(false);
+    }
+}
+
+void EgmEmulator::pause(double seconds){
+    resumeMicros = ofGetElapsedTimeMicros() + (uint64_t)(seconds * 1000000);
+}
+
+bool EgmEmulator::isPaused(){
+    return ofGetElapsedTimeMicros() < resumeMicros.load();
+}
+
+void EgmEmulator::collectLatencies(vector<double> & out){
+    out.clear();
+    std::unique_lock<std::mutex> lock(latencyMutex);
+    std::swap(out, latencies);
+}
+
+void EgmEmulator::threadedFunction(){
+    uint64_t period = 1000000 / rate;
+    uint64_t next = ofGetElapsedTimeMicros();
+    uint32_t seqno = 0;
+    bool bWasPaused = true;
+
+    while(isThreadRunning()){
+        uint64_t now = ofGetElapsedTimeMicros();
+        if(now < resumeMicros.load()){
+            bWasPaused = true;
+            ofSleepMillis(10);
+            next = ofGetElapsedTimeMicros();
+            continue;
+        }
+        if(bWasPaused){
+            seqno = 0;
+            bWasPaused = false;
+            numSessions++;
+        }
+
+        send(seqno++, now);
+        // a reply that misses its cycle is picked up by the next one, so late replies show up as latency
+        if(receive(next + period)){
+            uint64_t latency = ofGetElapsedTimeMicros() - now;
+            std::unique_lock<std::mutex> lock(latencyMutex);
+            latencies.push_back(latency);
+        }
+
+        next += period;
+        now = ofGetElapsedTimeMicros();
+        if(next > now){
+            std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+        }else if(now - next > period * 10){
+            // fell far behind (suspended, overloaded), don't burst to catch up
+            next = now;
+        }
+    }
+}
+
+void EgmEmulator::send(uint32_t seqno, uint64_t nowMicros){
+    message.mutable_header()->set_seqno(seqno);
+    message.mutable_header()->set_tm(nowMicros / 1000);
+    EgmClock * clocks[] = {message.mutable_feedback()->mutable_time(), message.mutable_planned()->mutable_time()};
+    for(auto clock : clocks){
+        clock->set_sec(nowMicros / 1000000);
+        clock->set_usec(nowMicros % 1000000);
+    }
+    for(size_t i = 0; i < joints.size(); i++){
+        message.mutable_feedback()->mutable_joints()->set_joints(i, joints[i]);
+        message.mutable_planned()->mutable_joints()->set_joints(i, joints[i]);
+    }
+    message.SerializeToString(&outBuffer);
+    if(socket.Send(outBuffer.data(), outBuffer.size()) > 0){
+        numSent++;
+    }
+}
+
+bool EgmEmulator::receive(uint64_t deadlineMicros){
+    while(isThreadRunning() && ofGetElapsedTimeMicros() < deadlineMicros){
+        int bytes = socket.Receive(inBuffer.data(), inBuffer.size());
+        if(bytes <= 0){
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        if(!reply.ParseFromArray(inBuffer.data(), bytes)){
+            continue;
+        }
+        numReplies++;
+        const EgmJoints & commanded = reply.planned().joints();
+        if(commanded.joints_size() == (int)joints.size()){
+            for(size_t i = 0; i < joints.size(); i++){
+                joints[i] = commanded.joints(i);
+            }
+        }
+        return true;
+    }
+    return false;
+}
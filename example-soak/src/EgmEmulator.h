@@ -0,0 +1,57 @@
+//
+//  EgmEmulator.h
+//  example-soak
+//
+//  Stands in for an ABB controller running EGMActJoint: sends EgmRobot
+//  messages at 250Hz to the driver's UDP port, reads the EgmSensor replies
+//  and follows the commanded joints. The robot tracks the commands exactly,
+//  so the feedback is the last reference it got.
+//
+//  pause() stops sending for a while, like the RAPID program leaving EGM.
+//  When it resumes the sequence number restarts at 0, as a new EGM session.
+//
+#pragma once
+#include "ofMain.h"
+#include "ofxNetwork.h"
+#include <abb_libegm/egm_common_auxiliary.h>
+
+class EgmEmulator : public ofThread{
+public:
+    EgmEmulator();
+    ~EgmEmulator();
+
+    void setup(int port, vector<double> initPoseDeg, int rate = 250);
+    void start();
+    void stop();
+    void threadedFunction();
+
+    /// \brief stop sending for seconds, then start a new session
+    void pause(double seconds);
+    bool isPaused();
+
+    /// \brief reply latencies (us) since the last call, the buffer is swapped, not copied
+    void collectLatencies(vector<double> & out);
+    uint64_t getNumSent(){ return numSent.load(); }
+    uint64_t getNumReplies(){ return numReplies.load(); }
+    uint64_t getNumSessions(){ return numSessions.load(); }
+
+protected:
+    void send(uint32_t seqno, uint64_t nowMicros);
+    bool receive(uint64_t deadlineMicros);
+
+    ofxUDPManager socket;
+    int rate = 250;
+    vector<double> joints;
+    abb::egm::EgmRobot message;
+    abb::egm::EgmSensor reply;
+    string outBuffer;
+    vector<char> inBuffer;
+
+    std::atomic<uint64_t> resumeMicros;
+    std::atomic<uint64_t> numSent;
+    std::atomic<uint64_t> numReplies;
+    std::atomic<uint64_t> numSessions;
+
+    std::mutex latencyMutex;
+    vector<double> latencies;
+};
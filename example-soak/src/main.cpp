@@ -0,0 +1,16 @@
+#include "ofMain.h"
+#include "ofApp.h"
+
+//========================================================================
+int main(int argc, char *argv[]){
+    // a hidden window, RobotModel still wants a GL context for its meshes
+    ofGLFWWindowSettings settings;
+    settings.setSize(320, 240);
+    settings.visible = false;
+    auto window = ofCreateWindow(settings);
+
+    auto app = make_shared<ofApp>();
+    app->args = vector<string>(argv, argv + argc);
+    ofRunApp(window, app);
+    return ofRunMainLoop();
+}
@@ -0,0 +1,330 @@
+#include "ofApp.h"
+#include <dirent.h>
+#include <functional>
+#include <iomanip>
+#ifdef __APPLE__
+#include <mach/mach.h>
+#endif
+
+using namespace ofxRobotArm;
+
+// count every heap allocation in the process, driver and emulator threads included
+static std::atomic<uint64_t> allocationCount(0);
+
+void * operator new(size_t size){
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void * p = malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void * p) noexcept{
+    free(p);
+}
+void operator delete(void * p, size_t) noexcept{
+    free(p);
+}
+
+static double residentMB(){
+#ifdef __APPLE__
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS){
+        return 0;
+    }
+    return info.resident_size / (1024.0 * 1024.0);
+#else
+    long pages = 0, resident = 0;
+    FILE * f = fopen("/proc/self/statm", "r");
+    if(!f){
+        return 0;
+    }
+    if(fscanf(f, "%ld %ld", &pages, &resident) != 2){
+        resident = 0;
+    }
+    fclose(f);
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+#endif
+}
+
+static int openFileCount(){
+    // /dev/fd lists the calling process' descriptors on linux and osx,
+    // the one opendir holds is included, that offset is constant
+    DIR * dir = opendir("/dev/fd");
+    if(!dir){
+        return -1;
+    }
+    int count = 0;
+    while(dirent * entry = readdir(dir)){
+        if(entry->d_name[0] != '.'){
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static double percentile(vector<double> & sorted, double q){
+    if(sorted.empty()){
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, (size_t)(q * (sorted.size() - 1) + 0.5))];
+}
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+    ofSetLogLevel(OF_LOG_WARNING);
+    parseArgs();
+    runSoak();
+    bDone = true;
+}
+
+//--------------------------------------------------------------
+void ofApp::parseArgs(){
+    for(size_t i = 1; i + 1 < args.size(); i += 2){
+        string key = args[i];
+        string value = args[i + 1];
+        if(key == "--duration") duration = ofToDouble(value);
+        else if(key == "--interval") interval = ofToDouble(value);
+        else if(key == "--warmup") warmup = ofToDouble(value);
+        else if(key == "--disconnect-every") disconnectEvery = ofToDouble(value);
+        else if(key == "--disconnect-for") disconnectFor = ofToDouble(value);
+        else if(key == "--port") port = ofToInt(value);
+        else if(key == "--out") outPath = value;
+        else if(key == "--max-rss-growth") maxRssGrowthMB = ofToDouble(value);
+        else if(key == "--max-fd-growth") maxFdGrowth = ofToInt(value);
+        else if(key == "--max-alloc-growth") maxAllocGrowth = ofToDouble(value);
+        else if(key == "--max-p99-growth") maxP99Growth = ofToDouble(value);
+        else if(key == "--min-reply-ratio") minReplyRatio = ofToDouble(value);
+        else ofLogWarning("soak") << "unknown argument " << key;
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::runSoak(){
+    // offline setup builds the model and IK without opening a socket,
+    // the ABB driver is then created against the emulator
+    controller = new LegacyRobotController();
+    controller->setup("127.0.0.1", port, ofToDataPath("relaxed_ik_core/config/urdfs/irb120.urdf"), IRB120, SW, true);
+    ofxRobotArm::RobotDriver * offlineDriver = controller->robot;
+
+    vector<double> initPose = offlineDriver->getInitPose();
+    vector<double> initPoseDeg;
+    for(auto q : initPose){
+        initPoseDeg.push_back(ofRadToDeg(q));
+    }
+    emulator.setup(port, initPoseDeg);
+    emulator.start();
+    startDriver();
+    controller->setEnableMovement(true);
+
+    ofNode home = controller->getForwardNode();
+    ofVec3f center = home.getGlobalPosition() * 1000.0;
+    ofQuaternion orientation = home.getGlobalOrientation();
+
+    ofFile file(ofToDataPath(outPath), ofFile::WriteOnly);
+    file << "elapsed_s,rss_mb,fds,allocs_per_s,tick_p50_us,tick_p99_us,tick_max_us,egm_p50_us,egm_p99_us,reply_ratio,events" << endl;
+    cout << "soak: " << duration << "s, sampling every " << interval << "s, disconnect every " << disconnectEvery << "s" << endl;
+
+    const uint64_t period = 1000000 / 125;
+    vector<double> tickMicros;
+    tickMicros.reserve((size_t)(interval * 125 * 2));
+
+    uint64_t start = ofGetElapsedTimeMicros();
+    uint64_t next = start;
+    double nextSample = interval;
+    double nextEvent = disconnectEvery > 0 ? disconnectEvery : duration + 1;
+    int numEvents = 0;
+    int tick = 0;
+    lastAllocations = allocationCount.load();
+
+    while(true){
+        double elapsed = (ofGetElapsedTimeMicros() - start) / 1000000.0;
+        if(elapsed >= duration){
+            break;
+        }
+
+        if(elapsed >= nextEvent){
+            // alternate between a dropped EGM session and a full driver restart
+            if(numEvents % 2 == 0){
+                emulator.pause(disconnectFor);
+            }else{
+                stopDriver();
+                ofSleepMillis(disconnectFor * 1000);
+                startDriver();
+            }
+            numEvents++;
+            events++;
+            nextEvent += disconnectEvery;
+            next = ofGetElapsedTimeMicros();
+        }
+
+        // same lissajous as the benchmark, 50mm around the home TCP
+        double t = tick++ / 125.0;
+        ofNode target;
+        target.setGlobalPosition(center + ofVec3f(50 * sin(t * 1.3), 50 * sin(t * 1.7), 30 * sin(t * 0.9)));
+        target.setGlobalOrientation(orientation);
+
+        uint64_t t0 = ofGetElapsedTimeMicros();
+        controller->setDesiredPose(target);
+        controller->updateRobotData();
+        controller->updateIK(controller->desiredModel.getModifiedTCPPose());
+        controller->updateMovement();
+        tickMicros.push_back(ofGetElapsedTimeMicros() - t0);
+
+        if(elapsed >= nextSample){
+            Sample s = takeSample(elapsed, tickMicros);
+            samples.push_back(s);
+            writeSample(s);
+            file << s.elapsed << "," << s.rssMB << "," << s.fds << "," << s.allocsPerSec << ","
+                 << s.tickP50 << "," << s.tickP99 << "," << s.tickMax << ","
+                 << s.egmP50 << "," << s.egmP99 << "," << s.replyRatio << "," << s.events << endl;
+            nextSample += interval;
+        }
+
+        next += period;
+        uint64_t now = ofGetElapsedTimeMicros();
+        if(next > now){
+            std::this_thread::sleep_for(std::chrono::microseconds(next - now));
+        }
+    }
+
+    stopDriver();
+    emulator.stop();
+    controller->robot = nullptr;
+    delete controller;
+    delete offlineDriver;
+
+    if(checkDrift()){
+        cout << "soak: PASS" << endl;
+    }else{
+        for(auto & f : failures){
+            cout << "soak: FAIL " << f << endl;
+        }
+        exitCode = 1;
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::startDriver(){
+    driver = new ABBDriver();
+    driver->setup(port);
+    driver->start();
+    controller->robot = driver;
+}
+
+//--------------------------------------------------------------
+void ofApp::stopDriver(){
+    if(driver){
+        driver->disconnect();
+        delete driver;
+        driver = nullptr;
+    }
+}
+
+//--------------------------------------------------------------
+ofApp::Sample ofApp::takeSample(double elapsed, vector<double> & tickMicros){
+    Sample s;
+    s.elapsed = elapsed;
+    s.rssMB = residentMB();
+    s.fds = openFileCount();
+
+    uint64_t allocations = allocationCount.load();
+    s.allocsPerSec = (allocations - lastAllocations) / interval;
+    lastAllocations = allocations;
+
+    std::sort(tickMicros.begin(), tickMicros.end());
+    s.tickP50 = percentile(tickMicros, 0.50);
+    s.tickP99 = percentile(tickMicros, 0.99);
+    s.tickMax = tickMicros.empty() ? 0 : tickMicros.back();
+    tickMicros.clear();
+
+    vector<double> egm;
+    emulator.collectLatencies(egm);
+    std::sort(egm.begin(), egm.end());
+    s.egmP50 = percentile(egm, 0.50);
+    s.egmP99 = percentile(egm, 0.99);
+
+    uint64_t sent = emulator.getNumSent();
+    uint64_t replies = emulator.getNumReplies();
+    s.replyRatio = sent > lastSent ? (double)(replies - lastReplies) / (sent - lastSent) : 0;
+    lastSent = sent;
+    lastReplies = replies;
+
+    // a window that saw a disconnect is kept out of the drift check
+    s.events = events + (emulator.isPaused() ? 1 : 0);
+    events = 0;
+    return s;
+}
+
+//--------------------------------------------------------------
+void ofApp::writeSample(const Sample & s){
+    cout << fixed << setprecision(1)
+         << setw(8) << s.elapsed << "s"
+         << "  rss " << setw(7) << s.rssMB << "MB"
+         << "  fds " << setw(4) << s.fds
+         << "  allocs/s " << setw(9) << s.allocsPerSec
+         << "  tick p99 " << setw(7) << s.tickP99 << "us"
+         << "  egm p99 " << setw(7) << s.egmP99 << "us"
+         << "  replies " << setprecision(3) << s.replyRatio
+         << (s.events ? "  *" : "") << endl;
+}
+
+//--------------------------------------------------------------
+bool ofApp::checkDrift(){
+    vector<Sample> quiet;
+    for(auto & s : samples){
+        if(s.elapsed >= warmup && s.events == 0){
+            quiet.push_back(s);
+        }
+    }
+    // medians of three windows at each end, so one noisy window doesn't fail the run
+    const size_t n = 3;
+    if(quiet.size() < 2 * n){
+        failures.push_back("only " + ofToString(quiet.size()) + " quiet windows after warmup, run longer");
+        return false;
+    }
+    auto median = [&](size_t from, std::function<double(const Sample &)> field){
+        vector<double> v;
+        for(size_t i = from; i < from + n; i++){
+            v.push_back(field(quiet[i]));
+        }
+        std::sort(v.begin(), v.end());
+        return v[n / 2];
+    };
+    auto check = [&](string name, std::function<double(const Sample &)> field, std::function<bool(double, double)> ok){
+        double first = median(0, field);
+        double last = median(quiet.size() - n, field);
+        cout << "soak: " << name << " " << first << " -> " << last << endl;
+        if(!ok(first, last)){
+            failures.push_back(name + " drifted from " + ofToString(first) + " to " + ofToString(last));
+        }
+    };
+
+    check("rss_mb", [](const Sample & s){ return s.rssMB; },
+          [&](double a, double b){ return b - a <= maxRssGrowthMB; });
+    check("fds", [](const Sample & s){ return (double)s.fds; },
+          [&](double a, double b){ return b - a <= maxFdGrowth; });
+    // the small absolute slack keeps a near zero baseline from failing on a handful of allocations
+    check("allocs_per_s", [](const Sample & s){ return s.allocsPerSec; },
+          [&](double a, double b){ return b <= a * (1 + maxAllocGrowth) + 50; });
+    check("tick_p99_us", [](const Sample & s){ return s.tickP99; },
+          [&](double a, double b){ return b <= a * (1 + maxP99Growth) + 100; });
+    check("egm_p99_us", [](const Sample & s){ return s.egmP99; },
+          [&](double a, double b){ return b <= a * (1 + maxP99Growth) + 100; });
+    check("reply_ratio", [](const Sample & s){ return s.replyRatio; },
+          [&](double a, double b){ return b >= minReplyRatio; });
+
+    return failures.empty();
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+    if(bDone){
+        ofExit(exitCode);
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ofMain.h"
+#include "LegacyRobotController.h"
+#include "ABBDriver.h"
+#include "EgmEmulator.h"
+
+class ofApp : public ofBaseApp{
+
+    public:
+        /// \brief one row of the time series, everything measured over the last interval
+        struct Sample{
+            double elapsed;
+            double rssMB;
+            int fds;
+            double allocsPerSec;
+            double tickP50, tickP99, tickMax;
+            double egmP50, egmP99;
+            double replyRatio;
+            int events;
+        };
+
+        void setup();
+        void update();
+        void draw();
+
+        void parseArgs();
+        void runSoak();
+        void startDriver();
+        void stopDriver();
+        Sample takeSample(double elapsed, vector<double> & tickMicros);
+        void writeSample(const Sample & s);
+        bool checkDrift();
+
+        vector<string> args;
+        double duration = 4 * 60 * 60;
+        double interval = 10;
+        double warmup = 60;
+        double disconnectEvery = 120;
+        double disconnectFor = 5;
+        int port = 6511;
+        string outPath = "soak.csv";
+
+        // drift limits, last windows against the first windows after warmup
+        double maxRssGrowthMB = 32;
+        int maxFdGrowth = 4;
+        double maxAllocGrowth = 0.5;
+        double maxP99Growth = 1.0;
+        double minReplyRatio = 0.9;
+
+        LegacyRobotController * controller = nullptr;
+        ofxRobotArm::ABBDriver * driver = nullptr;
+        EgmEmulator emulator;
+
+        vector<Sample> samples;
+        vector<string> failures;
+        uint64_t lastSent = 0, lastReplies = 0, lastAllocations = 0;
+        int events = 0;
+        int exitCode = 0;
+        bool bDone = false;
+};
@@ -17,22 +17,43 @@
  */
 
 #include "do_output.h"
+#include "AsyncLog.h"
 
 #define DONT_KILL_ON_FATAL
 
+// these are called from the UR communication threads, hand them to the async logger.
+// debug output is rate limited, everything else goes out in full.
+namespace{
+    const int DEBUG_SITES = 64;
+    ofxRobotArm::asynclog::Site debugSites[DEBUG_SITES];
+
+    // messages come in already formatted, so hash without the digits to get
+    // one rate limit per format rather than one per value
+    ofxRobotArm::asynclog::Site & debugSite(const string & inp){
+        uint32_t hash = 2166136261u;
+        for(char c : inp){
+            if(c < '0' || c > '9'){
+                hash = (hash ^ (unsigned char)c) * 16777619u;
+            }
+        }
+        return debugSites[hash % DEBUG_SITES];
+    }
+}
+
 void print_debug(string inp) {
-    ofLog(OF_LOG_VERBOSE)<<"DEBUG: "<<inp<<endl;
+    ofxRobotArm::asynclog::log(debugSite(inp), RA_LOG_RATE_MS, OF_LOG_VERBOSE, "urDriver", "DEBUG: %s", inp);
 }
 void print_info(std::string inp) {
-    ofLog(OF_LOG_NOTICE)<<"INFO: "<<inp<<endl;
+    RA_LOG_RATE(0, OF_LOG_NOTICE, "urDriver", "INFO: %s", inp);
 }
 void print_warning(std::string inp) {
-    ofLog(OF_LOG_WARNING)<<"WARNING: "<<inp<<endl;
+    RA_LOG_RATE(0, OF_LOG_WARNING, "urDriver", "WARNING: %s", inp);
 }
 void print_error(std::string inp) {
-    ofLog(OF_LOG_ERROR)<<"ERROR: "<<inp<<endl;
+    RA_LOG_RATE(0, OF_LOG_ERROR, "urDriver", "ERROR: %s", inp);
 }
 void print_fatal(std::string inp) {
+    ofxRobotArm::asynclog::flush();
     ofLog(OF_LOG_FATAL_ERROR)<<"FATAL: "<<inp<<endl;
     #ifndef DONT_KILL_ON_FATAL
         ofExit();
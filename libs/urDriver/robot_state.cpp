@@ -22,10 +22,20 @@
 RobotState::RobotState(std::condition_variable& msg_cond) {
 	version_msg_.major_version = 0;
 	version_msg_.minor_version = 0;
+	version_msg_.svn_revision = 0;
+	version_ = 0.;
+	memset(&robot_mode_, 0, sizeof(robot_mode_));
+	memset(&mb_data_, 0, sizeof(mb_data_));
+	memset(&snapshot_, 0, sizeof(snapshot_));
+	snapshot_seq_ = 0;
+	stream_buf_.resize(16384); //several times the largest secondary interface message
+	stream_len_ = 0;
 	new_data_available_ = false;
 	pMsg_cond_ = &msg_cond;
-	RobotState::setDisconnected();
 	robot_mode_running_ = robotStateTypeV30::ROBOT_MODE_RUNNING;
+	RobotState::setDisconnected();
+}
+RobotState::~RobotState() {
 }
 double RobotState::ntohd(uint64_t nf) {
 	double x;
@@ -33,24 +43,85 @@ double RobotState::ntohd(uint64_t nf) {
 	memcpy(&x, &nf, sizeof(x));
 	return x;
 }
+
+void RobotState::publishSnapshot() {
+	/* Sequence lock: an odd sequence tells readers a write is in progress */
+	uint64_t seq = snapshot_seq_.load(std::memory_order_relaxed);
+	snapshot_seq_.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	snapshot_.sequence = (seq + 2) / 2;
+	snapshot_.version = version_;
+	snapshot_.robot_mode_running = robot_mode_running_;
+	snapshot_.robot_mode = robot_mode_;
+	snapshot_.mb_data = mb_data_;
+	snapshot_seq_.store(seq + 2, std::memory_order_release);
+}
+
+robot_state_snapshot RobotState::getSnapshot() {
+	robot_state_snapshot snapshot;
+	uint64_t seq;
+	do {
+		seq = snapshot_seq_.load(std::memory_order_acquire);
+		memcpy(&snapshot, &snapshot_, sizeof(snapshot));
+		std::atomic_thread_fence(std::memory_order_acquire);
+	} while ((seq & 1) || seq != snapshot_seq_.load(std::memory_order_relaxed));
+	return snapshot;
+}
+
+uint8_t* RobotState::getStreamBuffer(unsigned int* available) {
+	*available = stream_buf_.size() - stream_len_;
+	return &stream_buf_[stream_len_];
+}
+
+void RobotState::commitStream(unsigned int bytes) {
+	stream_len_ += bytes;
+	unsigned int consumed = RobotState::unpackMessages(&stream_buf_[0], stream_len_);
+	if (consumed == 0 && stream_len_ == stream_buf_.size()) {
+		//a single message larger than the buffer means we lost framing, start over
+		consumed = stream_len_;
+	}
+	if (consumed > 0) {
+		//only the unparsed tail of a split message is ever moved
+		memmove(&stream_buf_[0], &stream_buf_[consumed], stream_len_ - consumed);
+		stream_len_ -= consumed;
+	}
+}
+
+void RobotState::resetStream() {
+	stream_len_ = 0;
+}
+
 void RobotState::unpack(uint8_t* buf, unsigned int buf_length) {
-	/* Returns missing bytes to unpack a message, or 0 if all data was parsed */
+	/* Parses all complete messages in buf, a trailing partial message is dropped */
+	RobotState::unpackMessages(buf, buf_length);
+}
+
+unsigned int RobotState::unpackMessages(uint8_t* buf, unsigned int buf_length) {
+	/* Returns the number of bytes parsed, i.e. the start of the first incomplete message */
 	unsigned int offset = 0;
-	while (buf_length > offset) {
+	bool updated = false;
+	while (buf_length - offset >= 5) {
 		int len;
 		unsigned char message_type;
 		memcpy(&len, &buf[offset], sizeof(len));
 		len = ntohl(len);
+		if (len < 5) {
+			//corrupt header, drop everything we have and resync on the next read
+			offset = buf_length;
+			break;
+		}
 		if (len + offset > buf_length) {
-			return;
+			break;
 		}
 		memcpy(&message_type, &buf[offset + sizeof(len)], sizeof(message_type));
 		switch (message_type) {
 		case messageType::ROBOT_MESSAGE:
 			RobotState::unpackRobotMessage(buf, offset, len); //'len' is inclusive the 5 bytes from messageSize and messageType
+			updated = true;
 			break;
 		case messageType::ROBOT_STATE:
 			RobotState::unpackRobotState(buf, offset, len); //'len' is inclusive the 5 bytes from messageSize and messageType
+			updated = true;
 			break;
 		case messageType::PROGRAM_STATE_MESSAGE:
 			//Don't do anything atm...
@@ -58,13 +129,18 @@ void RobotState::unpack(uint8_t* buf, unsigned int buf_length) {
 			break;
 		}
 		offset += len;
-
 	}
-	return;
+	if (updated) {
+		RobotState::publishSnapshot();
+		new_data_available_ = true;
+		pMsg_cond_->notify_all();
+	}
+	return offset;
 }
 
 void RobotState::unpackRobotMessage(uint8_t * buf, unsigned int offset,
 		uint32_t len) {
+	unsigned int end = offset + len;
 	offset += 5;
 	uint64_t timestamp;
 	int8_t source, robot_message_type;
@@ -76,12 +152,10 @@ void RobotState::unpackRobotMessage(uint8_t * buf, unsigned int offset,
 	offset += sizeof(robot_message_type);
 	switch (robot_message_type) {
 	case robotMessageType::ROBOT_MESSAGE_VERSION:
-		val_lock_.lock();
 		version_msg_.timestamp = timestamp;
 		version_msg_.source = source;
 		version_msg_.robot_message_type = robot_message_type;
-		RobotState::unpackRobotMessageVersion(buf, offset, len);
-		val_lock_.unlock();
+		RobotState::unpackRobotMessageVersion(buf, offset, end);
 		break;
 	default:
 		break;
@@ -91,41 +165,42 @@ void RobotState::unpackRobotMessage(uint8_t * buf, unsigned int offset,
 
 void RobotState::unpackRobotState(uint8_t * buf, unsigned int offset,
 		uint32_t len) {
+	unsigned int end = offset + len;
 	offset += 5;
-	while (offset < len) {
+	while (offset + 5 <= end) {
 		int32_t length;
 		uint8_t package_type;
 		memcpy(&length, &buf[offset], sizeof(length));
 		length = ntohl(length);
+		if (length < 5 || offset + length > end) {
+			break;
+		}
 		memcpy(&package_type, &buf[offset + sizeof(length)],
 				sizeof(package_type));
 		switch (package_type) {
 		case packageType::ROBOT_MODE_DATA:
-			val_lock_.lock();
 			RobotState::unpackRobotMode(buf, offset + 5);
-			val_lock_.unlock();
 			break;
 
 		case packageType::MASTERBOARD_DATA:
-			val_lock_.lock();
 			RobotState::unpackRobotStateMasterboard(buf, offset + 5);
-			val_lock_.unlock();
 			break;
 		default:
 			break;
 		}
 		offset += length;
 	}
-	new_data_available_ = true;
-	pMsg_cond_->notify_all();
-
 }
 
 void RobotState::unpackRobotMessageVersion(uint8_t * buf, unsigned int offset,
-		uint32_t len) {
+		uint32_t end) {
 	memcpy(&version_msg_.project_name_size, &buf[offset],
 			sizeof(version_msg_.project_name_size));
 	offset += sizeof(version_msg_.project_name_size);
+	if (version_msg_.project_name_size < 0
+			|| version_msg_.project_name_size >= (int8_t) sizeof(version_msg_.project_name)) {
+		return;
+	}
 	memcpy(&version_msg_.project_name, &buf[offset],
 			sizeof(char) * version_msg_.project_name_size);
 	offset += version_msg_.project_name_size;
@@ -140,8 +215,14 @@ void RobotState::unpackRobotMessageVersion(uint8_t * buf, unsigned int offset,
 			sizeof(version_msg_.svn_revision));
 	offset += sizeof(version_msg_.svn_revision);
 	version_msg_.svn_revision = ntohl(version_msg_.svn_revision);
-	memcpy(&version_msg_.build_date, &buf[offset], sizeof(char) * len - offset);
-	version_msg_.build_date[len - offset] = '\0';
+	unsigned int date_len = offset < end ? end - offset : 0;
+	if (date_len > sizeof(version_msg_.build_date) - 1) {
+		date_len = sizeof(version_msg_.build_date) - 1;
+	}
+	memcpy(&version_msg_.build_date, &buf[offset], sizeof(char) * date_len);
+	version_msg_.build_date[date_len] = '\0';
+	version_ = version_msg_.major_version + 0.1 * version_msg_.minor_version
+			+ .0000001 * version_msg_.svn_revision;
 	if (version_msg_.major_version < 2) {
 		robot_mode_running_ = robotStateTypeV18::ROBOT_RUNNING_MODE;
 	}
@@ -197,7 +278,7 @@ void RobotState::unpackRobotMode(uint8_t * buf, unsigned int offset) {
 	memcpy(&robot_mode_.robotMode, &buf[offset], sizeof(robot_mode_.robotMode));
 	offset += sizeof(robot_mode_.robotMode);
 	uint64_t temp;
-	if (RobotState::getVersion() > 2.) {
+	if (version_ > 2.) {
 		memcpy(&robot_mode_.controlMode, &buf[offset],
 				sizeof(robot_mode_.controlMode));
 		offset += sizeof(robot_mode_.controlMode);
@@ -212,7 +293,7 @@ void RobotState::unpackRobotMode(uint8_t * buf, unsigned int offset) {
 
 void RobotState::unpackRobotStateMasterboard(uint8_t * buf,
 		unsigned int offset) {
-	if (RobotState::getVersion() < 3.0) {
+	if (version_ < 3.0) {
 		int16_t digital_input_bits, digital_output_bits;
 		memcpy(&digital_input_bits, &buf[offset], sizeof(digital_input_bits));
 		offset += sizeof(digital_input_bits);
@@ -291,7 +372,7 @@ void RobotState::unpackRobotStateMasterboard(uint8_t * buf,
 				sizeof(mb_data_.euromapOutputBits));
 		offset += sizeof(mb_data_.euromapOutputBits);
 		mb_data_.euromapOutputBits = ntohl(mb_data_.euromapOutputBits);
-		if (RobotState::getVersion() < 3.0) {
+		if (version_ < 3.0) {
 			int16_t euromap_voltage, euromap_current;
 			memcpy(&euromap_voltage, &buf[offset], sizeof(euromap_voltage));
 			offset += sizeof(euromap_voltage);
@@ -314,13 +395,7 @@ void RobotState::unpackRobotStateMasterboard(uint8_t * buf,
 }
 
 double RobotState::getVersion() {
-	double ver;
-	val_lock_.lock();
-	ver = version_msg_.major_version + 0.1 * version_msg_.minor_version
-			+ .0000001 * version_msg_.svn_revision;
-	val_lock_.unlock();
-	return ver;
-
+	return getSnapshot().version;
 }
 
 void RobotState::finishedReading() {
@@ -332,50 +407,54 @@ bool RobotState::getNewDataAvailable() {
 }
 
 int RobotState::getDigitalInputBits() {
-	return mb_data_.digitalInputBits;
+	return getSnapshot().mb_data.digitalInputBits;
 }
 int RobotState::getDigitalOutputBits() {
-	return mb_data_.digitalOutputBits;
+	return getSnapshot().mb_data.digitalOutputBits;
 }
 double RobotState::getAnalogInput0() {
-	return mb_data_.analogInput0;
+	return getSnapshot().mb_data.analogInput0;
 }
 double RobotState::getAnalogInput1() {
-	return mb_data_.analogInput1;
+	return getSnapshot().mb_data.analogInput1;
 }
 double RobotState::getAnalogOutput0() {
-	return mb_data_.analogOutput0;
+	return getSnapshot().mb_data.analogOutput0;
 
 }
 double RobotState::getAnalogOutput1() {
-	return mb_data_.analogOutput1;
+	return getSnapshot().mb_data.analogOutput1;
+}
+unsigned char RobotState::getSafetyMode() {
+	return getSnapshot().mb_data.safetyMode;
 }
 bool RobotState::isRobotConnected() {
-	return robot_mode_.isRobotConnected;
+	return getSnapshot().robot_mode.isRobotConnected;
 }
 bool RobotState::isRealRobotEnabled() {
-	return robot_mode_.isRealRobotEnabled;
+	return getSnapshot().robot_mode.isRealRobotEnabled;
 }
 bool RobotState::isPowerOnRobot() {
-	return robot_mode_.isPowerOnRobot;
+	return getSnapshot().robot_mode.isPowerOnRobot;
 }
 bool RobotState::isEmergencyStopped() {
-	return robot_mode_.isEmergencyStopped;
+	return getSnapshot().robot_mode.isEmergencyStopped;
 }
 bool RobotState::isProtectiveStopped() {
-	return robot_mode_.isProtectiveStopped;
+	return getSnapshot().robot_mode.isProtectiveStopped;
 }
 bool RobotState::isProgramRunning() {
-	return robot_mode_.isProgramRunning;
+	return getSnapshot().robot_mode.isProgramRunning;
 }
 bool RobotState::isProgramPaused() {
-	return robot_mode_.isProgramPaused;
+	return getSnapshot().robot_mode.isProgramPaused;
 }
 unsigned char RobotState::getRobotMode() {
-	return robot_mode_.robotMode;
+	return getSnapshot().robot_mode.robotMode;
 }
 bool RobotState::isReady() {
-	if (robot_mode_.robotMode == robot_mode_running_) {
+	robot_state_snapshot snapshot = getSnapshot();
+	if (snapshot.robot_mode.robotMode == snapshot.robot_mode_running) {
 		return true;
 	}
 	return false;
@@ -385,4 +464,5 @@ void RobotState::setDisconnected() {
 	robot_mode_.isRobotConnected = false;
 	robot_mode_.isRealRobotEnabled = false;
 	robot_mode_.isPowerOnRobot = false;
+	RobotState::publishSnapshot();
 }
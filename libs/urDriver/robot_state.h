@@ -23,6 +23,7 @@
 #include <vector>
 #include <stdlib.h>
 #include <string.h>
+#include <atomic>
 #include <mutex>
 #include <condition_variable>
 #include <netinet/in.h>
@@ -148,19 +149,38 @@ struct robot_mode_data {
 	double speedScaling;
 };
 
+/* Consistent copy of the secondary interface state, published once per batch of parsed messages */
+struct robot_state_snapshot {
+	uint64_t sequence; //incremented every time a new snapshot is published
+	double version;
+	unsigned char robot_mode_running;
+	robot_mode_data robot_mode;
+	masterboard_data mb_data;
+};
+
 class RobotState {
 private:
+	// Parse-side state, only touched by the thread feeding unpack()/commitStream()
 	version_message version_msg_;
 	masterboard_data mb_data_;
 	robot_mode_data robot_mode_;
+	double version_;
+
+	// Published state, guarded by a sequence lock so readers never block the parser
+	robot_state_snapshot snapshot_;
+	std::atomic<uint64_t> snapshot_seq_;
 
-	std::recursive_mutex val_lock_; // Locks the variables while unpack parses data;
+	// Framing buffer: socket reads land here and complete messages are parsed in place
+	std::vector<uint8_t> stream_buf_;
+	unsigned int stream_len_;
 
 	std::condition_variable* pMsg_cond_; //Signals that new vars are available
-	bool new_data_available_; //to avoid spurious wakes
+	std::atomic<bool> new_data_available_; //to avoid spurious wakes
 	unsigned char robot_mode_running_;
 
 	double ntohd(uint64_t nf);
+	void publishSnapshot();
+	unsigned int unpackMessages(uint8_t * buf, unsigned int buf_length);
 
 public:
 	RobotState(std::condition_variable& msg_cond);
@@ -206,10 +226,19 @@ public:
 	bool getNewDataAvailable();
 	void finishedReading();
 
+	robot_state_snapshot getSnapshot();
+
+	/* Incremental framing for the secondary interface stream. Read straight into
+	 * getStreamBuffer() and hand the byte count to commitStream(), which parses
+	 * every complete message and keeps a split message until the rest arrives. */
+	uint8_t* getStreamBuffer(unsigned int* available);
+	void commitStream(unsigned int bytes);
+	void resetStream();
+
 	void unpack(uint8_t * buf, unsigned int buf_length);
 	void unpackRobotMessage(uint8_t * buf, unsigned int offset, uint32_t len);
 	void unpackRobotMessageVersion(uint8_t * buf, unsigned int offset,
-			uint32_t len);
+			uint32_t end);
 	void unpackRobotState(uint8_t * buf, unsigned int offset, uint32_t len);
 	void unpackRobotStateMasterboard(uint8_t * buf, unsigned int offset);
 	void unpackRobotMode(uint8_t * buf, unsigned int offset);
@@ -148,6 +148,11 @@ std::vector<double> RobotStateRT::getITarget() {
 	val_lock_.unlock();
 	return ret;
 }
+void RobotStateRT::getITarget(std::vector<double> & out) {
+	val_lock_.lock();
+	out.assign(i_target_.begin(), i_target_.end());
+	val_lock_.unlock();
+}
 std::vector<double> RobotStateRT::getMTarget() {
 	std::vector<double> ret;
 	val_lock_.lock();
@@ -162,6 +167,11 @@ std::vector<double> RobotStateRT::getQActual() {
 	val_lock_.unlock();
 	return ret;
 }
+void RobotStateRT::getQActual(std::vector<double> & out) {
+	val_lock_.lock();
+	out.assign(q_actual_.begin(), q_actual_.end());
+	val_lock_.unlock();
+}
 std::vector<double> RobotStateRT::getQdActual() {
 	std::vector<double> ret;
 	val_lock_.lock();
@@ -176,6 +186,11 @@ std::vector<double> RobotStateRT::getIActual() {
 	val_lock_.unlock();
 	return ret;
 }
+void RobotStateRT::getIActual(std::vector<double> & out) {
+	val_lock_.lock();
+	out.assign(i_actual_.begin(), i_actual_.end());
+	val_lock_.unlock();
+}
 std::vector<double> RobotStateRT::getIControl() {
 	std::vector<double> ret;
 	val_lock_.lock();
@@ -190,6 +205,11 @@ std::vector<double> RobotStateRT::getToolVectorActual() {
 	val_lock_.unlock();
 	return ret;
 }
+void RobotStateRT::getToolVectorActual(std::vector<double> & out) {
+	val_lock_.lock();
+	out.assign(tool_vector_actual_.begin(), tool_vector_actual_.end());
+	val_lock_.unlock();
+}
 std::vector<double> RobotStateRT::getTcpSpeedActual() {
 	std::vector<double> ret;
 	val_lock_.lock();
@@ -80,12 +80,16 @@ public:
 	std::vector<double> getQdTarget();
 	std::vector<double> getQddTarget();
 	std::vector<double> getITarget();
+	void getITarget(std::vector<double> & out);
 	std::vector<double> getMTarget();
 	std::vector<double> getQActual();
+	void getQActual(std::vector<double> & out); // copies into out, no allocation once sized
 	std::vector<double> getQdActual();
 	std::vector<double> getIActual();
+	void getIActual(std::vector<double> & out);
 	std::vector<double> getIControl();
 	std::vector<double> getToolVectorActual();
+	void getToolVectorActual(std::vector<double> & out);
 	std::vector<double> getTcpSpeedActual();
 	std::vector<double> getTcpForce();
 	std::vector<double> getToolVectorTarget();
@@ -113,9 +113,9 @@ void UrCommunication::halt() {
 }
 
 void UrCommunication::run() {
-	uint8_t buf[2048];
+	uint8_t* buf;
+	unsigned int available;
 	int bytes_read;
-	bzero(buf, 2048);
 	struct timeval timeout;
 	fd_set readfds;
 	FD_ZERO(&readfds);
@@ -126,13 +126,16 @@ void UrCommunication::run() {
 			timeout.tv_sec = 0; //do this each loop as selects modifies timeout
 			timeout.tv_usec = 500000; // timeout of 0.5 sec
 			select(sec_sockfd_ + 1, &readfds, NULL, NULL, &timeout);
-			bytes_read = read(sec_sockfd_, buf, 2048); // usually only up to 1295 bytes
+			//read straight into the framing buffer, messages may be split across reads
+			buf = robot_state_->getStreamBuffer(&available);
+			bytes_read = read(sec_sockfd_, buf, available); // usually only up to 1295 bytes
 			if (bytes_read > 0) {
 				setsockopt(sec_sockfd_, IPPROTO_TCP, TCP_NODELAY,
 						(char *) &flag_, sizeof(int));
-				robot_state_->unpack(buf, bytes_read);
+				robot_state_->commitStream(bytes_read);
 			} else {
 				connected_ = false;
+				robot_state_->resetStream();
 				robot_state_->setDisconnected();
 				close(sec_sockfd_);
 			}
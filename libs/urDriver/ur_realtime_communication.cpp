@@ -17,6 +17,7 @@
  */
 
 #include "ur_realtime_communication.h"
+#include "AsyncLog.h"
 
 UrRealtimeCommunication::UrRealtimeCommunication(
 		std::condition_variable& msg_cond, std::string host,
@@ -43,6 +44,9 @@ UrRealtimeCommunication::UrRealtimeCommunication(
 	keepalive_ = false;
 	safety_count_ = safety_count_max + 1;
 	safety_count_max_ = safety_count_max;
+	servoj_time_ = 0.08;
+	servoj_lookahead_ = 0.01;
+	servoj_gain_ = 0.;
 }
 
 bool UrRealtimeCommunication::start() {
@@ -95,20 +99,40 @@ void UrRealtimeCommunication::addCommandToQueue(std::string inp) {
 		print_error("Could not send command \"" +inp + "\". The robot is not connected! Command is discarded" );
 }
 
+void UrRealtimeCommunication::writeCommand(const char * cmd, size_t len) {
+	if (!connected_) {
+		RA_LOG_ERROR("urDriver", "Could not send command \"%s\". The robot is not connected! Command is discarded", cmd);
+		return;
+	}
+	// a short write leaves half a script line on the socket, send the rest
+	size_t sent = 0;
+	while (sent < len) {
+		ssize_t bytes_written = write(sockfd_, cmd + sent, len - sent);
+		if (bytes_written < 0) {
+			if (errno == EINTR)
+				continue;
+			RA_LOG_ERROR("urDriver", "Could not send command \"%s\", errno=%d, %zu of %zu bytes sent", cmd, errno, sent, len);
+			return;
+		}
+		sent += bytes_written;
+	}
+}
+
 void UrRealtimeCommunication::setSpeed(double q0, double q1, double q2,
 		double q3, double q4, double q5, double acc) {
 	char cmd[1024];
+	int len;
 	if( robot_state_->getVersion() >= 3.1 ) {
-		sprintf(cmd,
+		len = snprintf(cmd, sizeof(cmd),
 				"speedj([%1.5f, %1.5f, %1.5f, %1.5f, %1.5f, %1.5f], %f)\n",
 				q0, q1, q2, q3, q4, q5, acc);
 	}
 	else {
-		sprintf(cmd,
+		len = snprintf(cmd, sizeof(cmd),
 				"speedj([%1.5f, %1.5f, %1.5f, %1.5f, %1.5f, %1.5f], %f, 0.02)\n",
 				q0, q1, q2, q3, q4, q5, acc);		
 	}
-	addCommandToQueue((std::string) (cmd));
+	writeCommand(cmd, len);
 	if (q0 != 0. or q1 != 0. or q2 != 0. or q3 != 0. or q4 != 0. or q5 != 0.) {
 		//If a joint speed is set, make sure we stop it again after some time if the user doesn't
 		safety_count_ = 0;
@@ -160,12 +184,33 @@ void UrRealtimeCommunication::setPosition(double q0, double q1, double q2,
 
 */
     
-	sprintf(cmd,
-			"servoj([%1.5f, %1.5f, %1.5f, %1.5f, %1.5f, %1.5f], 0, 0, 0.08, 0.01)\n",
-			q0, q1, q2, q3, q4, q5);
+	double t, lookahead, gain;
+	{
+		std::lock_guard<std::recursive_mutex> lock(command_string_lock_);
+		t = servoj_time_;
+		lookahead = servoj_lookahead_;
+		gain = servoj_gain_;
+	}
+	int len;
+	if (gain > 0.) {
+		len = snprintf(cmd, sizeof(cmd),
+				"servoj([%1.5f, %1.5f, %1.5f, %1.5f, %1.5f, %1.5f], 0, 0, %1.4f, %1.4f, %1.1f)\n",
+				q0, q1, q2, q3, q4, q5, t, lookahead, gain);
+	} else {
+		len = snprintf(cmd, sizeof(cmd),
+				"servoj([%1.5f, %1.5f, %1.5f, %1.5f, %1.5f, %1.5f], 0, 0, %1.4f, %1.4f)\n",
+				q0, q1, q2, q3, q4, q5, t, lookahead);
+	}
     
     //cout << " Sending command " << cmd << endl;
-	addCommandToQueue((std::string) (cmd));
+	writeCommand(cmd, len);
+}
+
+void UrRealtimeCommunication::setServoParams(double time, double lookahead, double gain) {
+	std::lock_guard<std::recursive_mutex> lock(command_string_lock_);
+	servoj_time_ = time;
+	servoj_lookahead_ = lookahead;
+	servoj_gain_ = gain;
 }
 
 void UrRealtimeCommunication::run() {
@@ -54,6 +54,9 @@ private:
 	std::recursive_mutex command_string_lock_;
 	std::string command_;
 	unsigned int safety_count_;
+	double servoj_time_;
+	double servoj_lookahead_;
+	double servoj_gain_;
 	void run();
 
 
@@ -71,8 +74,10 @@ public:
 			double q5, double acc = 100.);
     void setPosition(double q0, double q1, double q2,
 		double q3, double q4, double q5);
+	void setServoParams(double time, double lookahead, double gain = 0.); // gain 0 leaves the controller default
 
 	void addCommandToQueue(std::string inp);
+	void writeCommand(const char * cmd, size_t len); // for the per tick commands, no string copy
 	void setSafetyCountMax(uint inp);
 	std::string getLocalIp();
 
@@ -8,6 +8,7 @@
 #ifndef CORE_INSTRUCTION_UXBUS_CMD_TCP_H_
 #define CORE_INSTRUCTION_UXBUS_CMD_TCP_H_
 
+#include <vector>
 #include "xarm/core/instruction/uxbus_cmd.h"
 #include "xarm/core/port/socket.h"
 
@@ -30,6 +31,9 @@ private:
 	int TX2_PROT_HEAT_ = 1;        // tcp heat prot
 	int TX2_BUS_FLAG_MIN_ = 1;     // the min cmd num
 	int TX2_BUS_FLAG_MAX_ = 5000;  // the max cmd num
+	// reused frame buffers, callers hold mutex_
+	std::vector<unsigned char> tx_buf_;
+	std::vector<unsigned char> rx_buf_;
 };
 
 #endif
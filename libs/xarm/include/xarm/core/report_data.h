@@ -8,6 +8,7 @@
 #define XARM_REPORT_DATA_H_
 
 #include <string>
+#include <atomic>
 #include "xarm/core/common/data_type.h"
 
 
@@ -113,6 +114,45 @@ class ReportDataRich {
   float rot_msg_[2];
 };
 
+/*
+ * Typed, fixed-size view of one report packet. Filled in a single pass
+ * straight from the receive buffer and published by XArmReportData through
+ * a double buffer, so readers on other threads always get a whole packet.
+ * Units are the raw report units (radian, mm).
+ */
+struct XArmReportFrame {
+  unsigned long long seq;    // publish counter, 0 means nothing received yet
+  int total_num;
+  int level;                 // 0: dev, 1: normal, 2: rich (fields below valid up to level)
+  int state;
+  int mode;
+  int cmdnum;
+  float angle[7];
+  float pose[6];
+  float tau[7];
+
+  // normal/rich
+  int mt_brake;
+  int mt_able;
+  int err;
+  int war;
+  float tcp_offset[6];
+  float tcp_load[4];
+  int collis_sens;
+  int teach_sens;
+  float gravity_dir[3];
+
+  // rich (only the realtime part, filled when total_num is long enough)
+  int temperatures[7];
+  float rt_tcp_spd;
+  float rt_joint_spds[7];
+  int count;
+  float voltages[7];
+  float currents[7];
+};
+
+typedef void (*XArmReportFrameCallback)(const XArmReportFrame *frame, void *arg);
+
 class XArmReportData {
 public:
   XArmReportData(std::string report_type = "normal");
@@ -121,7 +161,15 @@ public:
   int flush_data(unsigned char *rx_data);
   void print_data(void);
 
+  /*
+   * Copy the latest published frame, lock free, safe from any thread.
+   * return: 0 on success, -1 if nothing has been published yet
+   */
+  int get_frame(XArmReportFrame *frame) const;
+  unsigned long long frame_seq(void) const { return frame_seq_.load(std::memory_order_acquire); }
+
 private:
+  void __publish_frame(int level);
   int __flush_common_data(unsigned char *rx_data);
   void __print_common_data(void);
   int _flush_dev_data(unsigned char *rx_data);
@@ -202,9 +250,15 @@ public:
 private:
   std::string report_type;
   unsigned char *data_fp;
+  int debug_capacity_;
   float trs_msg_[5];
   float p2p_msg_[5];
   float rot_msg_[2];
+
+  // frame double buffer, slot (seq & 1) holds the latest frame
+  XArmReportFrame frames_[2];
+  std::atomic<unsigned int> frame_guard_[2];
+  std::atomic<unsigned long long> frame_seq_;
 };
 
 #endif // XARM_REPORT_DATA_H_
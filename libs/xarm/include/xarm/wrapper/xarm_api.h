@@ -15,6 +15,7 @@
 #include <functional>
 #include <algorithm>
 #include <thread>
+#include <atomic>
 #include <vector>
 #include <assert.h>
 #include <cmath>
@@ -274,6 +275,15 @@ public:
 	*/
 	int get_servo_angle(fp32 angles[7]);
 
+	/*
+	* Get the latest report packet without a request to the controller
+	* @param frame: filled with a consistent copy of the last report, the values are
+		always in radians/mm regardless of default_is_radian
+	* return: 0 on success, API_CODE::NOT_CONNECTED if no report has been received yet
+		(e.g. is_old_protocol or the report socket is down)
+	*/
+	int get_report_frame(XArmReportFrame *frame);
+
 	/*
 	* Motion enable
 	* @param enable: enable or not
@@ -832,6 +842,24 @@ public:
 	int register_count_changed_callback(void(*callback)(int count));
 	int register_count_changed_callback(std::function<void (int)> callback);
 
+	/*
+	* Register an inline report frame callback
+	* Called on the report thread right after each packet is decoded, never through the
+		callback thread pool, and with no allocation on the way. Keep it short, it
+		delays the next report.
+	* @param callback: receives the decoded frame and the registered arg
+	* @param arg: user pointer passed back to the callback
+	* return: 0 on success, 1 if already registered, -1 if all slots are in use
+	*/
+	int register_report_frame_callback(XArmReportFrameCallback callback, void *arg = NULL);
+
+	/*
+	* Coalesce the per-packet report data/location callbacks
+	* @param batch: only every batch-th report packet fires them, 1 (default) means every packet.
+		Changed-event callbacks (state, mode, error, ...) are not affected.
+	*/
+	int set_report_callback_batch(int batch);
+
 	/*
 	* Release the report data callback
 	* @param callback: NULL means to release all callbacks;
@@ -839,6 +867,13 @@ public:
 	int release_report_data_callback(void(*callback)(XArmReportData *report_data_ptr) = NULL);
 	int release_report_data_callback(bool clear_all);
 
+	/*
+	* Release the inline report frame callback
+	* Returns once no frame callback is running, so don't call it from one
+	* @param callback: NULL means to release all inline frame callbacks
+	*/
+	int release_report_frame_callback(XArmReportFrameCallback callback = NULL, void *arg = NULL);
+
 	/*
 	* Release the location report callback
 	* @param callback: NULL means to release all callbacks;
@@ -1569,6 +1604,7 @@ private:
 	template<typename CallableVector, typename FunctionVector>
 	int _clear_event_callback(CallableVector&& callbacks, FunctionVector&& functions, bool clear_all = true);
 
+	void _report_frame_callback(void);
 	void _report_data_callback(void);
 	void _report_location_callback(void);
 	void _report_connect_changed_callback(void);
@@ -1687,6 +1723,15 @@ private:
 	std::vector<void(*)(int)> cmdnum_changed_callbacks_;
 	std::vector<void(*)(const fp32*)> temperature_changed_callbacks_;
 	std::vector<void(*)(int)> count_changed_callbacks_;
+
+	static const int MAX_FRAME_CALLBACKS = 8;
+	std::mutex frame_callback_mutex_;
+	std::atomic<XArmReportFrameCallback> frame_callbacks_[MAX_FRAME_CALLBACKS];
+	std::atomic<void *> frame_callback_args_[MAX_FRAME_CALLBACKS];
+	std::atomic<int> frame_callbacks_running_;
+	// set from the app thread, read on the report thread
+	std::atomic<int> report_batch_size_;
+	std::atomic<int> report_batch_count_;
 };
 
 #endif
@@ -99,12 +99,14 @@ int UxbusCmd::get_nu16(int funcode, int *rx_data, int num) {
 }
 
 int UxbusCmd::set_nfp32(int funcode, float *datas, int num) {
-	unsigned char *send_data = new unsigned char[num * 4];
+	// servo commands go through here every control tick, keep them off the heap
+	unsigned char stack_data[64];
+	unsigned char *send_data = num * 4 <= (int)sizeof(stack_data) ? stack_data : new unsigned char[num * 4];
 	nfp32_to_hex(datas, send_data, num);
 
 	std::lock_guard<std::mutex> locker(mutex_);
 	int ret = send_xbus(funcode, send_data, num * 4);
-	delete[] send_data;
+	if (send_data != stack_data) { delete[] send_data; }
 	if (0 != ret) { return UXBUS_STATE::ERR_NOTTCP; }
 	ret = send_pend(funcode, 0, SET_TIMEOUT_, NULL);
 	return ret;
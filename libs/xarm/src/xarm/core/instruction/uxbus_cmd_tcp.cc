@@ -61,7 +61,8 @@ int UxbusCmdTcp::send_pend(int funcode, int num, int timeout, unsigned char *ret
 	int ret = UXBUS_STATE::ERR_TOUT;
 	int ret2;
 	// unsigned char rx_data[arm_port_->que_maxlen_] = {0};
-	unsigned char *rx_data = new unsigned char[arm_port_->que_maxlen_];
+	if (rx_buf_.size() < (size_t)arm_port_->que_maxlen_) { rx_buf_.resize(arm_port_->que_maxlen_); }
+	unsigned char *rx_data = rx_buf_.data();
 	long long expired = get_system_time() + (long long)timeout;
 	while (get_system_time() < expired) {
 		ret2 = arm_port_->read_frame(rx_data);
@@ -83,14 +84,14 @@ int UxbusCmdTcp::send_pend(int funcode, int num, int timeout, unsigned char *ret
 		}
 		sleep_milliseconds(1);
 	}
-	delete[] rx_data;
 	return ret;
 }
 
 int UxbusCmdTcp::send_xbus(int funcode, unsigned char *datas, int num) {
 	int len = num + 7;
 	// unsigned char send_data[len];
-	unsigned char *send_data = new unsigned char[len];
+	if (tx_buf_.size() < (size_t)len) { tx_buf_.resize(len); }
+	unsigned char *send_data = tx_buf_.data();
 
 	bin16_to_8(bus_flag_, &send_data[0]);
 	bin16_to_8(prot_flag_, &send_data[2]);
@@ -101,7 +102,6 @@ int UxbusCmdTcp::send_xbus(int funcode, unsigned char *datas, int num) {
 	arm_port_->flush();
 	// print_hex("send:", send_data, num + 7);
 	int ret = arm_port_->write_frame(send_data, len);
-	delete[] send_data;
 	if (ret != len) { return -1; }
 
 	bus_flag_ += 1;
@@ -210,7 +210,7 @@ int ReportDataRich::flush_data(unsigned char *rx_data) {
   rot_jerk_ = rot_msg_[0];
   rot_accmax_ = rot_msg_[1];
 
-  for (int i = 0; i < 17; i++) { sv3msg_[i] = data_fp[229 + i]; }
+  for (int i = 0; i < 16; i++) { sv3msg_[i] = data_fp[229 + i]; }
 
   return 0;
 }
@@ -324,9 +324,18 @@ XArmReportData::XArmReportData(std::string report_type_)
 
   debug_data = NULL;
   debug_size = 0;
+  debug_capacity_ = 0;
+
+  memset(frames_, 0, sizeof(frames_));
+  frame_guard_[0].store(0);
+  frame_guard_[1].store(0);
+  frame_seq_.store(0);
 }
 
-XArmReportData::~XArmReportData(void) {}
+XArmReportData::~XArmReportData(void)
+{
+  delete[] debug_data;
+}
 
 int XArmReportData::__flush_common_data(unsigned char *rx_data)
 {
@@ -358,8 +367,10 @@ void XArmReportData::__print_common_data(void)
 void XArmReportData::__flush_debug_data(int since_size) {
   if (total_num > since_size) {
     debug_size = total_num - since_size;
-    if (debug_data == NULL) {
+    if (debug_size > debug_capacity_) {
+      delete[] debug_data;
       debug_data = new unsigned char[debug_size];
+      debug_capacity_ = debug_size;
     }
     memcpy(debug_data, &data_fp[since_size], debug_size);
   }
@@ -436,10 +447,10 @@ int XArmReportData::_flush_rich_data(unsigned char *rx_data)
   rot_jerk = rot_msg_[0];
   rot_accmax = rot_msg_[1];
 
-  for (int i = 0; i < 17; i++) { sv3msg[i] = data_fp[229 + i]; }
+  for (int i = 0; i < 16; i++) { sv3msg[i] = data_fp[229 + i]; }
 
   if (total_num >= 252) {
-    for (int i = 0; i < 17; i++) { temperatures[i] = data_fp[245 + i]; }
+    for (int i = 0; i < 7; i++) { temperatures[i] = data_fp[245 + i]; }
   }
   if (total_num >= 284) {
     float tcp_spd[1];
@@ -574,14 +585,86 @@ void XArmReportData::_print_rich_data(void)
 
 int XArmReportData::flush_data(unsigned char *rx_data)
 {
+  int ret;
+  int level;
   if (report_type == "dev") {
-    return _flush_dev_data(rx_data);
+    ret = _flush_dev_data(rx_data);
+    level = 0;
   }
   else if (report_type == "rich") {
-    return _flush_rich_data(rx_data);
+    ret = _flush_rich_data(rx_data);
+    level = 2;
   }
   else {
-    return _flush_normal_data(rx_data);
+    ret = _flush_normal_data(rx_data);
+    level = 1;
+  }
+  if (ret == 0) __publish_frame(level);
+  return ret;
+}
+
+void XArmReportData::__publish_frame(int level)
+{
+  // only the report thread writes, so the counters need no read-modify-write
+  unsigned long long seq = frame_seq_.load(std::memory_order_relaxed) + 1;
+  int slot = (int)(seq & 1);
+  XArmReportFrame *frame = &frames_[slot];
+  unsigned int guard = frame_guard_[slot].load(std::memory_order_relaxed);
+  frame_guard_[slot].store(guard + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  frame->seq = seq;
+  frame->total_num = total_num;
+  frame->level = level;
+  frame->state = data_fp[4] & 0x0F;
+  frame->mode = data_fp[4] >> 4;
+  frame->cmdnum = bin8_to_16(&data_fp[5]);
+  hex_to_nfp32(&data_fp[7], frame->angle, 7);
+  hex_to_nfp32(&data_fp[35], frame->pose, 6);
+  hex_to_nfp32(&data_fp[59], frame->tau, 7);
+
+  if (level >= 1) {
+    frame->mt_brake = data_fp[87];
+    frame->mt_able = data_fp[88];
+    frame->err = data_fp[89];
+    frame->war = data_fp[90];
+    hex_to_nfp32(&data_fp[91], frame->tcp_offset, 6);
+    hex_to_nfp32(&data_fp[115], frame->tcp_load, 4);
+    frame->collis_sens = data_fp[131];
+    frame->teach_sens = data_fp[132];
+    hex_to_nfp32(&data_fp[133], frame->gravity_dir, 3);
+  }
+
+  if (level >= 2 && total_num >= 252) {
+    for (int i = 0; i < 7; i++) { frame->temperatures[i] = data_fp[245 + i]; }
+  }
+  if (level >= 2 && total_num >= 284) {
+    hex_to_nfp32(&data_fp[252], &frame->rt_tcp_spd, 1);
+    hex_to_nfp32(&data_fp[256], frame->rt_joint_spds, 7);
+  }
+  if (level >= 2 && total_num >= 288) {
+    frame->count = bin8_to_32(&data_fp[284]);
+  }
+  if (level >= 2 && total_num >= 417) {
+    for (int i = 0; i < 7; i++) { frame->voltages[i] = (float)bin8_to_16(&data_fp[341 + 2 * i]) / 100; }
+    hex_to_nfp32(&data_fp[355], frame->currents, 7);
+  }
+
+  frame_guard_[slot].store(guard + 2, std::memory_order_release);
+  frame_seq_.store(seq, std::memory_order_release);
+}
+
+int XArmReportData::get_frame(XArmReportFrame *frame) const
+{
+  while (true) {
+    unsigned long long seq = frame_seq_.load(std::memory_order_acquire);
+    if (seq == 0) return -1;
+    int slot = (int)(seq & 1);
+    unsigned int guard = frame_guard_[slot].load(std::memory_order_acquire);
+    if (guard & 1) continue;
+    memcpy(frame, &frames_[slot], sizeof(XArmReportFrame));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (frame_guard_[slot].load(std::memory_order_relaxed) == guard) return 0;
   }
 }
 
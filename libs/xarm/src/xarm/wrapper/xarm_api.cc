@@ -61,6 +61,13 @@ XArmAPI::~XArmAPI() {
 
 void XArmAPI::_init(void) {
 	core = NULL;
+	for (int i = 0; i < MAX_FRAME_CALLBACKS; i++) {
+		frame_callbacks_[i].store(NULL);
+		frame_callback_args_[i].store(NULL);
+	}
+	frame_callbacks_running_.store(0);
+	report_batch_size_ = 1;
+	report_batch_count_ = 0;
 	stream_tcp_ = NULL;
 	stream_tcp_report_ = NULL;
 	stream_ser_ = NULL;
@@ -536,6 +543,11 @@ int XArmAPI::get_servo_angle(fp32 angs[7]) {
 	return ret;
 }
 
+int XArmAPI::get_report_frame(XArmReportFrame *frame) {
+	if (report_data_ptr_ == NULL || report_data_ptr_->get_frame(frame) != 0) return API_CODE::NOT_CONNECTED;
+	return 0;
+}
+
 int XArmAPI::motion_enable(bool enable, int servo_id) {
 	if (!is_connected()) return API_CODE::NOT_CONNECTED;
 	int ret = core->motion_en(servo_id, int(enable));
@@ -11,21 +11,44 @@
 
 template<typename CallableVector, typename FunctionVector, class... arguments>
 void XArmAPI::_report_callback(CallableVector&& callbacks, FunctionVector&& functions, arguments&&... args) {
+	// without callback threads call straight through, pool_.commit would bind a std::function per call
+	if (!callback_in_thread_) {
+		for (size_t i = 0; i < callbacks.size(); i++) callbacks[i](args...);
+		for (size_t i = 0; i < functions.size(); i++) functions[i](args...);
+		return;
+	}
 	for (size_t i = 0; i < callbacks.size(); i++) {
-		if (callback_in_thread_) pool_.dispatch(callbacks[i], std::forward<arguments>(args)...);
-		else pool_.commit(callbacks[i], std::forward<arguments>(args)...);
+		pool_.dispatch(callbacks[i], std::forward<arguments>(args)...);
 	}
-    for (size_t i = 0; i < functions.size(); i++) {
-		if (callback_in_thread_) pool_.dispatch(functions[i], std::forward<arguments>(args)...);
-		else pool_.commit(functions[i], std::forward<arguments>(args)...);
+	for (size_t i = 0; i < functions.size(); i++) {
+		pool_.dispatch(functions[i], std::forward<arguments>(args)...);
 	}
 }
 
+void XArmAPI::_report_frame_callback(void) {
+	XArmReportFrame frame;
+	bool has_frame = false;
+	// release_report_frame_callback waits on this, so a released callback is never running
+	frame_callbacks_running_.fetch_add(1);
+	for (int i = 0; i < MAX_FRAME_CALLBACKS; i++) {
+		XArmReportFrameCallback callback = frame_callbacks_[i].load();
+		if (callback == NULL) continue;
+		if (!has_frame) {
+			if (report_data_ptr_->get_frame(&frame) != 0) break;
+			has_frame = true;
+		}
+		callback(&frame, frame_callback_args_[i].load(std::memory_order_relaxed));
+	}
+	frame_callbacks_running_.fetch_sub(1, std::memory_order_release);
+}
+
 void XArmAPI::_report_data_callback(void) {
+	if (report_batch_count_ != 0) return;
 	_report_callback(report_data_callbacks_, report_data_functions_, report_data_ptr_);
 }
 
 void XArmAPI::_report_location_callback(void) {
+	if (report_batch_count_ != 0) return;
 	_report_callback(report_location_callbacks_, report_location_functions_, position, angles);
 	// for (size_t i = 0; i < report_location_callbacks_.size(); i++) {
 	// 	if (callback_in_thread_) pool_.dispatch(report_location_callbacks_[i], position, angles);
@@ -210,6 +233,43 @@ int XArmAPI::register_count_changed_callback(std::function<void (int)> callback)
     return _register_event_function(count_changed_functions_, callback);
 }
 
+int XArmAPI::register_report_frame_callback(XArmReportFrameCallback callback, void *arg) {
+	if (callback == NULL) return -1;
+	std::lock_guard<std::mutex> locker(frame_callback_mutex_);
+	int empty_inx = -1;
+	for (int i = 0; i < MAX_FRAME_CALLBACKS; i++) {
+		XArmReportFrameCallback cb = frame_callbacks_[i].load(std::memory_order_relaxed);
+		if (cb == callback && frame_callback_args_[i].load(std::memory_order_relaxed) == arg) return 1;
+		if (cb == NULL && empty_inx < 0) empty_inx = i;
+	}
+	if (empty_inx < 0) return -1;
+	frame_callback_args_[empty_inx].store(arg, std::memory_order_relaxed);
+	frame_callbacks_[empty_inx].store(callback, std::memory_order_release);
+	return 0;
+}
+
+int XArmAPI::release_report_frame_callback(XArmReportFrameCallback callback, void *arg) {
+	std::lock_guard<std::mutex> locker(frame_callback_mutex_);
+	int ret = -1;
+	for (int i = 0; i < MAX_FRAME_CALLBACKS; i++) {
+		XArmReportFrameCallback cb = frame_callbacks_[i].load(std::memory_order_relaxed);
+		if (callback == NULL || (cb == callback && frame_callback_args_[i].load(std::memory_order_relaxed) == arg)) {
+			frame_callbacks_[i].store(NULL);
+			ret = 0;
+		}
+	}
+	while (frame_callbacks_running_.load() != 0) {
+		std::this_thread::yield();
+	}
+	return callback == NULL ? 0 : ret;
+}
+
+int XArmAPI::set_report_callback_batch(int batch) {
+	report_batch_size_ = batch > 1 ? batch : 1;
+	report_batch_count_ = 0;
+	return 0;
+}
+
 int XArmAPI::release_report_data_callback(void(*callback)(XArmReportData *report_data_ptr)) {
     return _release_event_callback(report_data_callbacks_, callback);
 }
@@ -147,10 +147,14 @@ void XArmAPI::_update(unsigned char *rx_data) {
 	long long interval = report_time - last_report_time_;
 	max_report_interval_ = std::max(max_report_interval_, interval);
 	last_report_time_ = report_time;
+	// only the report thread counts, set_report_callback_batch just restarts it
+	int batch_count = report_batch_count_.load(std::memory_order_relaxed) + 1;
+	report_batch_count_.store(batch_count >= report_batch_size_.load(std::memory_order_relaxed) ? 0 : batch_count, std::memory_order_relaxed);
 	if (is_old_protocol_) {
 		_update_old(rx_data);
 		return;
 	}
+	_report_frame_callback();
 	_report_data_callback();
 	int sizeof_data = bin8_to_32(rx_data);
 	if (sizeof_data >= 87) {
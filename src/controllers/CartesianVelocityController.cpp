@@ -0,0 +1,217 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "CartesianVelocityController.h"
+#include "SimClock.h"
+#include "Trace.h"
+
+using namespace ofxRobotArm;
+
+namespace{
+    // finite difference step for the Jacobian, rad
+    const double JACOBIAN_STEP = 1e-6;
+
+    /// in place lower Cholesky factor of a 6x6 row-major matrix, false if not positive definite
+    bool cholesky(double * a){
+        for(int j = 0; j < 6; j++){
+            double d = a[j * 6 + j];
+            for(int k = 0; k < j; k++){
+                d -= a[j * 6 + k] * a[j * 6 + k];
+            }
+            if(d <= 0){
+                return false;
+            }
+            d = sqrt(d);
+            a[j * 6 + j] = d;
+            for(int i = j + 1; i < 6; i++){
+                double s = a[i * 6 + j];
+                for(int k = 0; k < j; k++){
+                    s -= a[i * 6 + k] * a[j * 6 + k];
+                }
+                a[i * 6 + j] = s / d;
+            }
+        }
+        return true;
+    }
+
+    /// solves L L^T x = b in place
+    void choleskySolve(const double * l, double * b){
+        for(int i = 0; i < 6; i++){
+            for(int k = 0; k < i; k++){
+                b[i] -= l[i * 6 + k] * b[k];
+            }
+            b[i] /= l[i * 6 + i];
+        }
+        for(int i = 5; i >= 0; i--){
+            for(int k = i + 1; k < 6; k++){
+                b[i] -= l[k * 6 + i] * b[k];
+            }
+            b[i] /= l[i * 6 + i];
+        }
+    }
+}
+
+CartesianVelocityController::CartesianVelocityController() : bToolFrame(false), maxDamping(0.05), threshold(0.01), timeout(0.1), acceleration(ofDegToRad(500)), manipulability(0), damping(0){
+    std::fill(jacobian, jacobian + 6 * MAX_JOINTS, 0.0);
+}
+
+CartesianVelocityController::~CartesianVelocityController(){
+}
+
+void CartesianVelocityController::setup(InverseKinematics * ik, int numJoints){
+    this->ik = ik;
+    this->numJoints = std::min(numJoints, (int)MAX_JOINTS);
+    perturbed.reserve(MAX_JOINTS);
+    stop();
+}
+
+void CartesianVelocityController::setTwist(const math::Vec3d & linear, const math::Vec3d & angular){
+    std::lock_guard<std::mutex> lock(mutex);
+    this->linear = linear;
+    this->angular = angular;
+    lastTwistMicros = simclock::nowMicros();
+    bHasTwist = true;
+}
+
+void CartesianVelocityController::setTwist(const ofVec3f & linear, const ofVec3f & angular){
+    setTwist(math::Vec3d(linear.x, linear.y, linear.z), math::Vec3d(angular.x, angular.y, angular.z));
+}
+
+void CartesianVelocityController::stop(){
+    std::lock_guard<std::mutex> lock(mutex);
+    bHasTwist = false;
+}
+
+void CartesianVelocityController::setToolFrame(bool toolFrame){
+    bToolFrame = toolFrame;
+}
+
+void CartesianVelocityController::setDamping(double maxDamping, double threshold){
+    this->maxDamping = maxDamping;
+    this->threshold = threshold;
+}
+
+void CartesianVelocityController::setTimeout(double seconds){
+    timeout = seconds;
+}
+
+void CartesianVelocityController::setAcceleration(double radiansPerSecond2){
+    acceleration = radiansPerSecond2;
+}
+
+double CartesianVelocityController::getAcceleration(){
+    return acceleration;
+}
+
+double CartesianVelocityController::getManipulability(){
+    return manipulability;
+}
+
+double CartesianVelocityController::getDamping(){
+    return damping;
+}
+
+void CartesianVelocityController::computeJacobian(const vector<double> & q){
+    // forward differences of the TCP pose, one column per joint, rows vx vy vz wx wy wz
+    math::Transformd base = math::Transformd::fromMatrix(ik->forward(q));
+    rotation = base.rotation;
+    math::Quatd inverse = base.rotation.conjugate();
+    perturbed = q;
+    for(int j = 0; j < numJoints; j++){
+        perturbed[j] = q[j] + JACOBIAN_STEP;
+        math::Transformd moved = math::Transformd::fromMatrix(ik->forward(perturbed));
+        perturbed[j] = q[j];
+
+        math::Vec3d v = (moved.translation - base.translation) / JACOBIAN_STEP;
+        math::Quatd delta = moved.rotation * inverse;
+        double sign = delta.w < 0 ? -1.0 : 1.0;
+        math::Vec3d w = math::Vec3d(delta.x, delta.y, delta.z) * (2.0 * sign / JACOBIAN_STEP);
+        for(int r = 0; r < 3; r++){
+            jacobian[r * numJoints + j] = v[r];
+            jacobian[(r + 3) * numJoints + j] = w[r];
+        }
+    }
+}
+
+void CartesianVelocityController::update(const vector<double> & q, vector<double> & speeds){
+    RA_TRACE_SCOPE("velocity.update");
+    std::fill(speeds.begin(), speeds.end(), 0.0);
+    if(!ik || (int)q.size() < numJoints || (int)speeds.size() < numJoints){
+        return;
+    }
+
+    math::Vec3d v, w;
+    bool active;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        v = linear;
+        w = angular;
+        active = bHasTwist && simclock::nowMicros() - lastTwistMicros <= timeout * 1000000;
+    }
+
+    computeJacobian(q);
+    const int n = numJoints;
+
+    // J J^T, the manipulability sqrt(det) is the product of its Cholesky diagonal
+    double a[36];
+    for(int i = 0; i < 6; i++){
+        for(int k = 0; k < 6; k++){
+            double s = 0;
+            for(int j = 0; j < n; j++){
+                s += jacobian[i * n + j] * jacobian[k * n + j];
+            }
+            a[i * 6 + k] = s;
+        }
+    }
+    double l[36];
+    std::copy(a, a + 36, l);
+    double measure = 0;
+    if(cholesky(l)){
+        measure = 1;
+        for(int i = 0; i < 6; i++){
+            measure *= l[i * 6 + i];
+        }
+    }
+    manipulability = measure;
+
+    double lambda2 = 0;
+    double t = threshold;
+    if(measure < t){
+        double ratio = t > 0 ? measure / t : 0;
+        lambda2 = maxDamping * maxDamping * (1.0 - ratio * ratio);
+    }
+    damping = sqrt(lambda2);
+
+    if(!active){
+        return;
+    }
+    if(bToolFrame){
+        v = rotation.rotate(v);
+        w = rotation.rotate(w);
+    }
+
+    for(int i = 0; i < 6; i++){
+        a[i * 6 + i] += lambda2;
+    }
+    if(!cholesky(a)){
+        return;
+    }
+    double y[6] = {v.x, v.y, v.z, w.x, w.y, w.z};
+    choleskySolve(a, y);
+
+    // qdot = J^T y, scaled as a whole to the slowest joint's limit
+    double scale = 1.0;
+    for(int j = 0; j < n; j++){
+        double s = 0;
+        for(int i = 0; i < 6; i++){
+            s += jacobian[i * n + j] * y[i];
+        }
+        speeds[j] = s;
+        if(j < (int)ik->maxJointSpeeds.size() && ik->maxJointSpeeds[j] > 0 && fabs(s) * scale > ik->maxJointSpeeds[j]){
+            scale = ik->maxJointSpeeds[j] / fabs(s);
+        }
+    }
+    for(int j = 0; j < n; j++){
+        speeds[j] *= scale;
+    }
+}
@@ -0,0 +1,92 @@
+//
+//  CartesianVelocityController.h
+//  ofxRobotArm
+//
+//  Cartesian velocity mode: the app sets a TCP twist, and on every driver
+//  tick it is mapped through the Jacobian at the measured joints into joint
+//  speeds, which the driver streams as speedj. Tracking a moving target in
+//  velocity mode skips the servoj lookahead, so it reacts a lot faster than
+//  position servoing.
+//
+//  Uses damped least squares, qdot = J^T (J J^T + lambda^2 I)^-1 twist.
+//  lambda stays 0 while the manipulability sqrt(det(J J^T)) is above the
+//  singular threshold, then grows toward the max damping as the arm
+//  approaches a singularity. The result is scaled down as a whole until
+//  every joint is within the IK's max joint speeds, so the direction holds.
+//
+//  Attach with RobotDriver::setVelocityControl. While attached it takes
+//  over the driver's moves. If no twist has arrived for the timeout, it
+//  commands zero.
+//
+//  Twists are in the IK frame (InverseKinematics::forward): m/s and rad/s
+//  about the base axes, or the tool axes with setToolFrame(true).
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "InverseKinematics.h"
+#include "RobotMath.h"
+
+namespace ofxRobotArm{
+    class CartesianVelocityController{
+    public:
+        static const int MAX_JOINTS = 7;
+
+        CartesianVelocityController();
+        ~CartesianVelocityController();
+
+        /// \brief ik is only used for forward kinematics and the max joint speeds,
+        /// it needs HK, SW or NUMERIC
+        void setup(InverseKinematics * ik, int numJoints = 6);
+
+        /// \brief linear (m/s) and angular (rad/s) TCP velocity, from any thread
+        void setTwist(const math::Vec3d & linear, const math::Vec3d & angular);
+        void setTwist(const ofVec3f & linear, const ofVec3f & angular);
+        /// \brief commands zero until the next setTwist
+        void stop();
+
+        /// \brief twists given in the tool frame instead of the base frame
+        void setToolFrame(bool toolFrame);
+        /// \brief damping starts below manipulability threshold and reaches maxDamping at 0
+        void setDamping(double maxDamping, double threshold);
+        /// \brief zero is commanded once the last twist is older than this
+        void setTimeout(double seconds);
+        /// \brief joint acceleration (rad/s^2) speedj ramps with
+        void setAcceleration(double radiansPerSecond2);
+        double getAcceleration();
+
+        /// \brief driver thread: joint speeds (rad/s) for measured joints q,
+        /// written to speeds, which must be sized already. Never allocates.
+        void update(const vector<double> & q, vector<double> & speeds);
+
+        /// \brief of the last update
+        double getManipulability();
+        double getDamping();
+
+    protected:
+        void computeJacobian(const vector<double> & q);
+
+        InverseKinematics * ik = nullptr;
+        int numJoints = 6;
+
+        std::mutex mutex;
+        math::Vec3d linear;
+        math::Vec3d angular;
+        uint64_t lastTwistMicros = 0;
+        bool bHasTwist = false;
+
+        std::atomic<bool> bToolFrame;
+        std::atomic<double> maxDamping;
+        std::atomic<double> threshold;
+        std::atomic<double> timeout;
+        std::atomic<double> acceleration;
+        std::atomic<double> manipulability;
+        std::atomic<double> damping;
+
+        // driver thread scratch, 6 x numJoints row-major
+        double jacobian[6 * MAX_JOINTS];
+        math::Quatd rotation;
+        vector<double> perturbed;
+    };
+}
@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "ContactDetector.h"
+#include "Trace.h"
+
+using namespace ofxRobotArm;
+
+namespace{
+    // low pass on the differentiated velocities and accelerations, s
+    const double DIFFERENTIATION_FILTER = 0.02;
+}
+
+ContactDetector::ContactDetector() : sigmas(5.0), adaptation(2.0), warmup(0.5), triggerCycles(2), stopAcceleration(10.0), bTriggered(false), bResetRequested(false), triggeredJoint(-1){
+    for(int j = 0; j < MAX_JOINTS; j++){
+        minThresholds[j] = 0.5;
+        residuals[j] = 0;
+        thresholds[j] = 0;
+    }
+    clear();
+}
+
+ContactDetector::~ContactDetector(){
+}
+
+void ContactDetector::setup(int numJoints){
+    this->numJoints = ofClamp(numJoints, 1, MAX_JOINTS);
+    reset();
+}
+
+void ContactDetector::setDynamics(const Dynamics * dynamics){
+    this->dynamics = dynamics;
+}
+
+void ContactDetector::setSensitivity(double sigmas){
+    this->sigmas = sigmas;
+}
+
+void ContactDetector::setMinThreshold(double threshold){
+    for(int j = 0; j < MAX_JOINTS; j++){
+        minThresholds[j] = threshold;
+    }
+}
+
+void ContactDetector::setMinThreshold(const vector<double> & thresholds){
+    for(int j = 0; j < MAX_JOINTS && j < (int)thresholds.size(); j++){
+        minThresholds[j] = thresholds[j];
+    }
+}
+
+void ContactDetector::setAdaptation(double seconds){
+    adaptation = MAX(seconds, 0.0);
+}
+
+void ContactDetector::setWarmup(double seconds){
+    warmup = seconds;
+}
+
+void ContactDetector::setTriggerCycles(int cycles){
+    triggerCycles = MAX(cycles, 1);
+}
+
+void ContactDetector::setStopAcceleration(double radiansPerSecond2){
+    stopAcceleration = radiansPerSecond2;
+}
+
+double ContactDetector::getStopAcceleration(){
+    return stopAcceleration;
+}
+
+bool ContactDetector::update(const double * expected, const double * measured, double seconds){
+    RA_TRACE_SCOPE("contact.update");
+    if(bResetRequested.exchange(false)){
+        clear();
+    }
+    double dt = numSamples > 0 ? MAX(seconds - lastTime, 0.0) : 0;
+    lastTime = seconds;
+    elapsed += dt;
+
+    // the first samples average equally, so the warmup starts from a real estimate
+    double alpha = 1.0 / (numSamples + 1);
+    if(dt > 0){
+        alpha = MAX(alpha, dt / (adaptation + dt));
+    }
+    bool bArmed = elapsed >= warmup;
+    double k = sigmas;
+    int cycles = triggerCycles;
+    for(int j = 0; j < numJoints; j++){
+        double deviation = measured[j] - expected[j] - mean[j];
+        double threshold = MAX(minThresholds[j].load(), k * sqrt(variance[j]));
+        residuals[j] = deviation;
+        thresholds[j] = threshold;
+        if(bArmed && fabs(deviation) > threshold){
+            // frozen while over, a push mustn't become the new normal
+            overCount[j]++;
+            if(overCount[j] >= cycles && !bTriggered){
+                triggeredJoint = j;
+                bTriggered = true;
+            }
+            continue;
+        }
+        overCount[j] = 0;
+        if(bTriggered){
+            continue;
+        }
+        mean[j] += alpha * deviation;
+        variance[j] = (1.0 - alpha) * (variance[j] + alpha * deviation * deviation);
+    }
+    numSamples++;
+    return bTriggered;
+}
+
+bool ContactDetector::updateModel(const double * q, const double * measured, double seconds){
+    if(!dynamics || !dynamics->isSetup()){
+        return bTriggered;
+    }
+    if(bResetRequested){
+        numModelSamples = 0;
+    }
+    int n = MIN(numJoints, dynamics->getNumJoints());
+    if(numModelSamples == 0){
+        std::fill(qd, qd + MAX_JOINTS, 0.0);
+        std::fill(qdd, qdd + MAX_JOINTS, 0.0);
+    }else if(seconds > lastModelTime){
+        double dt = seconds - lastModelTime;
+        double beta = dt / (DIFFERENTIATION_FILTER + dt);
+        for(int j = 0; j < n; j++){
+            double last = qd[j];
+            qd[j] += beta * ((q[j] - lastQ[j]) / dt - qd[j]);
+            qdd[j] += beta * ((qd[j] - last) / dt - qdd[j]);
+        }
+    }
+    lastModelTime = seconds;
+    std::copy(q, q + n, lastQ);
+    numModelSamples++;
+
+    dynamics->inverseDynamics(q, qd, qdd, modelEffort);
+    return update(modelEffort, measured, seconds);
+}
+
+bool ContactDetector::isTriggered(){
+    return bTriggered;
+}
+
+int ContactDetector::getTriggeredJoint(){
+    return triggeredJoint;
+}
+
+void ContactDetector::reset(){
+    // the driver thread clears its statistics on the next update
+    bResetRequested = true;
+    triggeredJoint = -1;
+    bTriggered = false;
+}
+
+vector<double> ContactDetector::getResiduals(){
+    vector<double> ret(numJoints);
+    for(int j = 0; j < numJoints; j++){
+        ret[j] = residuals[j];
+    }
+    return ret;
+}
+
+vector<double> ContactDetector::getThresholds(){
+    vector<double> ret(numJoints);
+    for(int j = 0; j < numJoints; j++){
+        ret[j] = thresholds[j];
+    }
+    return ret;
+}
+
+void ContactDetector::clear(){
+    std::fill(mean, mean + MAX_JOINTS, 0.0);
+    std::fill(variance, variance + MAX_JOINTS, 0.0);
+    std::fill(overCount, overCount + MAX_JOINTS, 0);
+    std::fill(lastQ, lastQ + MAX_JOINTS, 0.0);
+    std::fill(qd, qd + MAX_JOINTS, 0.0);
+    std::fill(qdd, qdd + MAX_JOINTS, 0.0);
+    std::fill(modelEffort, modelEffort + MAX_JOINTS, 0.0);
+    elapsed = 0;
+    numSamples = 0;
+    numModelSamples = 0;
+}
@@ -0,0 +1,111 @@
+//
+//  ContactDetector.h
+//  ofxRobotArm
+//
+//  Residual based collision detection. Every driver tick compares the
+//  effort each joint should need with the effort it measures, and stops the
+//  arm once a residual leaves its threshold for a cycle or two. It reacts a
+//  lot sooner than waiting for the controller's protective stop.
+//
+//  Each joint keeps an exponential running mean and variance of its
+//  residual. The mean soaks up what the model misses (friction, cable
+//  drag, calibration), and the threshold is sigmas standard deviations
+//  around it, never below the joint's min threshold. The statistics freeze
+//  while a joint is over its threshold, so a slow push can't teach itself
+//  to be normal.
+//
+//  The driver picks the residual. The UR compares the actual motor currents
+//  with the controller's target currents (A). The xArm compares its joint
+//  torques with the Dynamics model's inverse dynamics at the measured
+//  joints (Nm), so it needs setDynamics.
+//
+//  Attach with RobotDriver::setContactDetector. A trigger latches and
+//  holds the arm until reset().
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "Dynamics.h"
+#include <atomic>
+
+namespace ofxRobotArm{
+    class ContactDetector{
+    public:
+        static const int MAX_JOINTS = 8;
+
+        ContactDetector();
+        ~ContactDetector();
+
+        void setup(int numJoints = 6);
+        /// \brief model for updateModel, has to outlive the detector, nullptr to remove it
+        void setDynamics(const Dynamics * dynamics);
+
+        /// \brief threshold in standard deviations of each joint's residual
+        void setSensitivity(double sigmas);
+        /// \brief threshold floor, in the residual's units (A on a UR, Nm on an xArm)
+        void setMinThreshold(double threshold);
+        void setMinThreshold(const vector<double> & thresholds);
+        /// \brief time constant of the running mean and variance
+        void setAdaptation(double seconds);
+        /// \brief statistics settle this long after setup or reset before anything triggers
+        void setWarmup(double seconds);
+        /// \brief consecutive ticks over the threshold that trigger, 1 or 2 is the point
+        void setTriggerCycles(int cycles);
+        /// \brief rad/s^2 the driver brakes with
+        void setStopAcceleration(double radiansPerSecond2);
+        double getStopAcceleration();
+
+        /// \brief driver thread: feeds one tick sampled at seconds (the sample's own
+        /// timestamp, in one clock per detector), returns isTriggered(). Never allocates.
+        bool update(const double * expected, const double * measured, double seconds);
+        /// \brief driver thread: expected efforts from the dynamics at joints q, with
+        /// their velocities and accelerations differentiated from the previous ticks
+        bool updateModel(const double * q, const double * measured, double seconds);
+
+        bool isTriggered();
+        /// \brief joint that tripped the last trigger, -1 if none
+        int getTriggeredJoint();
+        /// \brief re-arms after a trigger and restarts the warmup, from any thread
+        void reset();
+
+        /// \brief of the last update, the residual minus its running mean, and the threshold
+        vector<double> getResiduals();
+        vector<double> getThresholds();
+
+    protected:
+        void clear();
+
+        int numJoints = 6;
+        const Dynamics * dynamics = nullptr;
+
+        std::atomic<double> sigmas;
+        std::atomic<double> adaptation;
+        std::atomic<double> warmup;
+        std::atomic<int> triggerCycles;
+        std::atomic<double> stopAcceleration;
+        std::atomic<double> minThresholds[MAX_JOINTS];
+
+        std::atomic<bool> bTriggered;
+        std::atomic<bool> bResetRequested;
+        std::atomic<int> triggeredJoint;
+        std::atomic<double> residuals[MAX_JOINTS];
+        std::atomic<double> thresholds[MAX_JOINTS];
+
+        // driver thread only
+        double mean[MAX_JOINTS];
+        double variance[MAX_JOINTS];
+        int overCount[MAX_JOINTS];
+        double elapsed = 0;
+        int numSamples = 0;
+        double lastTime = 0;
+
+        // updateModel
+        int numModelSamples = 0;
+        double lastModelTime = 0;
+        double lastQ[MAX_JOINTS];
+        double qd[MAX_JOINTS];
+        double qdd[MAX_JOINTS];
+        double modelEffort[MAX_JOINTS];
+    };
+}
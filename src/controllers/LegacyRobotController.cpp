@@ -1,10 +1,12 @@
 #include "LegacyRobotController.h"
+#include "AsyncLog.h"
 //
 // Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
 ////
 using namespace ofxRobotArm;
 LegacyRobotController::LegacyRobotController()
 {
+    robot = nullptr;
 }
 
 LegacyRobotController::~LegacyRobotController()
@@ -49,10 +51,30 @@ void LegacyRobotController::createRobot(RobotType type)
     else if(robotType == PANDA){
         robot = new PandaDriver();
     }
+    timing = TimingProfile::getDefault(robotType);
+    if(robot){
+        robot->setTimingProfile(timing);
+    }
+}
+
+bool LegacyRobotController::loadTimingProfile(string path)
+{
+    if(!timing.load(path, robotType)){
+        return false;
+    }
+    if(robot){
+        robot->setTimingProfile(timing);
+    }
+    for(auto & smooth : smoothedWeights){
+        smooth.set(timing.jointSmoothing);
+    }
+    ofLogNotice("LegacyRobotController") << "timing profile " << timing.name << ": " << timing.controlRate << "Hz control, " << timing.commandRate << "Hz commands";
+    return true;
 }
 
 void LegacyRobotController::loadURDF(string urdfpath)
 {
+    urdfPath = urdfpath;
     desiredModel.setup(urdfpath, robotType);
     actualModel.setup(urdfpath, robotType);
 }
@@ -141,11 +163,14 @@ void LegacyRobotController::initKinematics(ofxRobotArm::IKType ikType)
     smoothedPose.assign(pose.size(), 0.0f);
     for(int i = 0 ; i < pose.size(); i++){
         ofParameter<double> smooth;
-        smooth.set("Smooth-"+ofToString(i), 0.1, 0.001, 1.0);
+        smooth.set("Smooth-"+ofToString(i), timing.jointSmoothing, 0.001, 1.0);
         robotArmParams.add(smooth);
         smoothedWeights.push_back(smooth);
     }
     inverseKinematics.setup(robotType, ikType, pose, &actualModel);
+    if(ikType == NUMERIC){
+        inverseKinematics.loadChain(urdfPath);
+    }
     ofMatrix4x4 forwardIK = inverseKinematics.forwardKinematics(pose);
     forwardNode.setGlobalPosition(forwardIK.getTranslation());
     forwardNode.setGlobalOrientation(forwardIK.getRotate());
@@ -161,9 +186,17 @@ void LegacyRobotController::initKinematics(ofxRobotArm::IKType ikType)
 }
 
 void LegacyRobotController::setIKType(ofxRobotArm::IKType ikType){
+    bool bNeedsChain = ikType == NUMERIC || (ikType == RELAXED && inverseKinematics.bCacheEnabled);
+    if(bNeedsChain && !inverseKinematics.chain.isLoaded()){
+        inverseKinematics.loadChain(urdfPath);
+    }
     inverseKinematics.setIKType(ikType);
 }
 
+void LegacyRobotController::setIKCacheEnabled(bool enabled){
+    inverseKinematics.setCacheEnabled(enabled, urdfPath);
+}
+
 void LegacyRobotController::setPoseExternally(bool externally){
     bSetPoseExternally = externally;
 }
@@ -187,6 +220,76 @@ void LegacyRobotController::setEnableMovement(bool move){
     bLive = move;
 }
 
+void LegacyRobotController::setVelocityControl(bool enabled){
+    if(enabled == bVelocityControl || robot == nullptr){
+        return;
+    }
+    if(enabled){
+        if(inverseKinematics.ikType == RELAXED){
+            RA_LOG_ERROR("LegacyRobotController", "velocity control needs forward kinematics, use HK, SW or NUMERIC");
+            return;
+        }
+        if(!robot->supportsVelocityControl()){
+            // the others never read the speeds and would just stop taking poses
+            RA_LOG_ERROR("LegacyRobotController", "velocity control needs a driver that streams joint speeds, UR or simulated");
+            return;
+        }
+        velocityControl.setup(&inverseKinematics, robot->getInitPose().size());
+        robot->setVelocityControl(&velocityControl);
+    }else{
+        robot->setVelocityControl(nullptr);
+    }
+    bVelocityControl = enabled;
+}
+
+bool LegacyRobotController::isVelocityControlled(){
+    return bVelocityControl;
+}
+
+void LegacyRobotController::setTCPVelocity(ofVec3f linear, ofVec3f angular){
+    velocityControl.setTwist(linear, angular);
+}
+
+void LegacyRobotController::setContactDetection(bool enabled){
+    if(enabled == bContactDetection || robot == nullptr){
+        return;
+    }
+    if(enabled){
+        if(!robot->supportsContactDetection()){
+            // the others never feed the detector, it would never trigger
+            RA_LOG_ERROR("LegacyRobotController", "contact detection needs the UR or xArm driver");
+            return;
+        }
+        contactDetector.setup(robot->getInitPose().size());
+        if(robotType == XARM7){
+            if(!inverseKinematics.chain.isLoaded()){
+                inverseKinematics.loadChain(urdfPath);
+            }
+            if(!dynamics.setup(&inverseKinematics.chain)){
+                RA_LOG_ERROR("LegacyRobotController", "contact detection on the xArm models the joint torques, it needs a URDF with inertials");
+                return;
+            }
+            contactDetector.setDynamics(&dynamics);
+        }
+        robot->setContactDetector(&contactDetector);
+    }else{
+        robot->setContactDetector(nullptr);
+    }
+    bContactDetection = enabled;
+}
+
+bool LegacyRobotController::isContactDetectionEnabled(){
+    return bContactDetection;
+}
+
+bool LegacyRobotController::isInContact(){
+    return robot != nullptr && robot->isContactStopped();
+}
+
+void LegacyRobotController::resetContact(){
+    contactDetector.reset();
+}
+
 void LegacyRobotController::setHomePose(vector<double> pose)
 {
     homePose = pose;
@@ -207,6 +310,7 @@ void LegacyRobotController::setToolOffset(ofVec3f local)
 {
     desiredModel.setToolOffset(local/1000);
     actualModel.setToolOffset(local/1000);
+    inverseKinematics.setToolOffset(local/1000);
 }
 
 void LegacyRobotController::startConnection()
@@ -235,12 +339,17 @@ void LegacyRobotController::setTeachMode(bool teachMode)
 }
 
 #pragma mark - IK
-void LegacyRobotController::updateIK(Pose pose)
+void LegacyRobotController::updateIK(const Pose & pose)
 {
 
-    targetPoses = inverseKinematics.inverseKinematics(pose, initPose);
+    inverseKinematics.inverseKinematics(pose, initPose, targetPoses);
     if(targetPoses.size() > 0){
-        targetPose = targetPoses[0];
+        // start from the last commanded pose, so joints take the nearest of
+        // their 2PI equivalents instead of unwinding back toward zero
+        const vector<double> & seed = targetPose.size() == targetPoses[0].size() ? targetPose : currentPose;
+        if(inverseKinematics.ikType == RELAXED || inverseKinematics.selectSolution(targetPoses, seed, targetPose) < 0){
+            targetPose = targetPoses[0];
+        }
     }
     
     ofQuaternion rot = initPose.orientation.inverse() * pose.orientation;
@@ -362,7 +471,12 @@ void LegacyRobotController::updateMovement()
         desiredModel.setForwardPose(fN);
     }
 
-    if (bLive)
+    if (bVelocityControl)
+    {
+        // the driver thread streams the speeds, a pose would only be ignored
+        stopCount = 0;
+    }
+    else if (bLive)
     {
         robot->setPose(targetPose);
         stopPosition = targetPose;
@@ -377,7 +491,7 @@ void LegacyRobotController::updateMovement()
                 stopPosition[d] *= 0.9998;
             }
             robot->setPose(stopPosition);
-            cout << " Doing stop count " << stopCount << endl;
+            RA_LOG_VERBOSE("LegacyRobotController", "Doing stop count %d", stopCount);
             stopCount--;
         }
     }
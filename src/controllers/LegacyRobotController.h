@@ -10,6 +10,9 @@
 #include "XARMDriver.h"
 #include "PandaDriver.h"
 #include "InverseKinematics.h"
+#include "CartesianVelocityController.h"
+#include "ContactDetector.h"
+#include "Dynamics.h"
 #include "URDFModel.h"
 #include "RobotConstants.hpp"
 #include "Plane.h"
@@ -25,6 +28,9 @@ namespace ofxRobotArm {
         /// \params params default parameters for the robot & GUI
         void setup(string ipAddress, int port, string urdfPath, RobotType robotType, IKType ikType, bool offline);
         void createRobot(RobotType type);
+        /// \brief overrides the robot's default timing profile from a YAML file, see data/timing_profiles.yaml
+        bool loadTimingProfile(string path);
+        const TimingProfile & getTimingProfile() const { return timing; }
         
         void setAddress(string ipAddress);
         void setPort(int port);
@@ -39,6 +45,8 @@ namespace ofxRobotArm {
         void setRobotOrigin(ofVec3f origin, ofQuaternion orientation);
         void setHomePose(vector<double> pose);
         void setIKType(ofxRobotArm::IKType ikType);
+        /// \brief caches IK results for repeated targets, see InverseKinematics::setCacheEnabled
+        void setIKCacheEnabled(bool enabled);
         
         void startConnection();
 
@@ -53,7 +61,7 @@ namespace ofxRobotArm {
         void updateRobotData();
         void update();
         void update(vector<double> pose);
-        void updateIK(Pose pose);
+        void updateIK(const Pose & pose);
         
         void setDesiredPose(ofNode target);
         void drawActual(ofColor color = ofColor(255,255,255,255), bool debug = false);
@@ -72,11 +80,33 @@ namespace ofxRobotArm {
         
         void setEnableMovement(bool move);
 
+        /// \brief streams joint speeds for the TCP velocity set with setTCPVelocity
+        /// instead of IK poses. Needs HK, SW or NUMERIC and a speed capable driver
+        /// (UR or SimulatedDriver), others are refused.
+        void setVelocityControl(bool enabled);
+        bool isVelocityControlled();
+        /// \brief linear m/s and angular rad/s, in the robot base frame. Call at
+        /// least every 100ms while moving, the arm stops when it stops hearing.
+        void setTCPVelocity(ofVec3f linear, ofVec3f angular);
+
+        /// \brief stops the arm on a collision, see ContactDetector. The UR uses its
+        /// motor currents, the xArm its joint torques against the chain's dynamics,
+        /// so it needs loadChain with a URDF that has inertials. Other drivers are refused.
+        void setContactDetection(bool enabled);
+        bool isContactDetectionEnabled();
+        /// \brief true while the arm is held after a contact
+        bool isInContact();
+        /// \brief releases the arm after a contact, send a new pose to move again
+        void resetContact();
+
         RobotDriver * robot;
         RobotModel desiredModel;
         RobotModel actualModel;
         vector<RobotModel*> desiredModels;
         InverseKinematics inverseKinematics;
+        CartesianVelocityController velocityControl;
+        ContactDetector contactDetector;
+        Dynamics dynamics;
         // RobotArmSafety robotSafety;
 
         ofParameter<ofVec3f> origin;
@@ -131,13 +161,17 @@ namespace ofxRobotArm {
         ofParameter<bool> bDoReconnect;
         ofParameter<bool> bSetPoseExternally;
         ofParameter<bool> bHome;
+        bool bVelocityControl = false;
+        bool bContactDetection = false;
 
         std::string ipAddress;
+        std::string urdfPath;
         int port;
         Pose actualTCP;
         Pose targetTCP;
 
         ofxRobotArm::RobotType robotType;
+        TimingProfile timing;
         ofxRobotArm::IKType ikType;
         
         
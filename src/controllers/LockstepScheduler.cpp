@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "LockstepScheduler.h"
+#include "SimClock.h"
+#include "Trace.h"
+
+using namespace ofxRobotArm;
+
+LockstepScheduler::LockstepScheduler(){
+}
+
+LockstepScheduler::~LockstepScheduler(){
+    close();
+}
+
+void LockstepScheduler::setup(LegacyRobotController * controller, double rate){
+    close();
+    if(!controller || !controller->robot){
+        ofLogError("LockstepScheduler") << "setup: the controller needs to be set up (offline) first";
+        return;
+    }
+    this->controller = controller;
+    originalDriver = controller->robot;
+    if(originalDriver->isThreadRunning()){
+        ofLogWarning("LockstepScheduler") << "setup: the controller's driver is running, stop it before simulating";
+    }
+
+    TimingProfile profile = controller->getTimingProfile();
+    this->rate = rate > 0 ? rate : profile.controlRate;
+    driver.setTimingProfile(profile);
+    driver.setup(originalDriver->getInitPose());
+    controller->robot = &driver;
+    controller->inverseKinematics.setLockstep(true);
+    controller->setEnableMovement(true);
+
+    tick = 0;
+    simclock::setVirtual(true, 0);
+    ofLogNotice("LockstepScheduler") << "simulating " << profile.name << " at " << this->rate << "Hz virtual time";
+}
+
+void LockstepScheduler::close(){
+    if(!controller){
+        return;
+    }
+    controller->setEnableMovement(false);
+    controller->inverseKinematics.setLockstep(false);
+    controller->robot = originalDriver;
+    controller = nullptr;
+    originalDriver = nullptr;
+    simclock::setVirtual(false);
+}
+
+void LockstepScheduler::setPathController(PathController * paths){
+    this->paths = paths;
+}
+
+void LockstepScheduler::setTargetFunction(std::function<bool(uint64_t, double, ofNode &)> target){
+    targetFunction = target;
+}
+
+void LockstepScheduler::step(){
+    if(!controller){
+        return;
+    }
+    RA_TRACE_SCOPE("lockstep.tick");
+    tick++;
+    // from the tick count rather than summed periods, so long runs don't drift
+    simclock::set((uint64_t)(tick * 1000000.0 / rate + 0.5));
+
+    if(paths && paths->size() > 0){
+        paths->update();
+        ofMatrix4x4 pose = paths->getNextPose();
+        target.setGlobalPosition(pose.getTranslation() * 1000);
+        target.setGlobalOrientation(pose.getRotate());
+        controller->setDesiredPose(target);
+    }else if(targetFunction && targetFunction(tick, getTime(), target)){
+        controller->setDesiredPose(target);
+    }
+
+    controller->update();
+    driver.step(1.0 / rate);
+}
+
+void LockstepScheduler::run(uint64_t ticks){
+    for(uint64_t i = 0; i < ticks && controller; i++){
+        step();
+    }
+}
+
+void LockstepScheduler::runFor(double seconds){
+    run((uint64_t)(seconds * rate + 0.5));
+}
+
+uint64_t LockstepScheduler::getTick(){
+    return tick;
+}
+
+double LockstepScheduler::getTime(){
+    return tick / rate;
+}
+
+double LockstepScheduler::getRate(){
+    return rate;
+}
+
+SimulatedDriver & LockstepScheduler::getDriver(){
+    return driver;
+}
@@ -0,0 +1,72 @@
+//
+//  LockstepScheduler.h
+//  ofxRobotArm
+//
+//  Runs the whole control pipeline on one thread in a fixed order, on
+//  virtual time, so a run is bit reproducible and goes as fast as the CPU
+//  allows. Every tick:
+//
+//    1. virtual time advances by one control period (SimClock)
+//    2. the PathController (or target function) produces the next target
+//    3. the controller reads the robot, solves IK (RELAXED included, solved
+//       in place) and smooths, then hands the pose to the driver
+//    4. the SimulatedDriver runs its control tick
+//
+//  The controller has to be set up offline. setup() swaps its driver for a
+//  SimulatedDriver and turns movement on; close() puts the original back.
+//
+//      LockstepScheduler sim;
+//      sim.setup(&controller);
+//      sim.setPathController(&paths);
+//      recorder.start(type, numJoints);
+//      sim.getDriver().setRecorder(&recorder);
+//      sim.runFor(2 * 60 * 60);       // a two hour job, in minutes
+//      ofLog() << sim.getDriver().getDigest();
+//
+//  Nothing else may drive the controller while the scheduler runs.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "LegacyRobotController.h"
+#include "PathController.h"
+#include "SimulatedDriver.h"
+
+namespace ofxRobotArm{
+    class LockstepScheduler{
+    public:
+        LockstepScheduler();
+        ~LockstepScheduler();
+
+        /// \brief rate in Hz, 0 uses the controller's timing profile control rate
+        void setup(LegacyRobotController * controller, double rate = 0);
+        void close();
+
+        /// \brief targets come from paths, in meters like Path3D
+        void setPathController(PathController * paths);
+        /// \brief targets come from target(tick, time), in mm like setDesiredPose.
+        /// Returning false leaves the previous target in place.
+        void setTargetFunction(std::function<bool(uint64_t, double, ofNode &)> target);
+
+        void step();
+        void run(uint64_t ticks);
+        void runFor(double seconds);
+
+        uint64_t getTick();
+        /// \brief virtual seconds since setup
+        double getTime();
+        double getRate();
+        SimulatedDriver & getDriver();
+
+    protected:
+        LegacyRobotController * controller = nullptr;
+        RobotDriver * originalDriver = nullptr;
+        PathController * paths = nullptr;
+        std::function<bool(uint64_t, double, ofNode &)> targetFunction;
+        SimulatedDriver driver;
+        ofNode target;
+        double rate = 125;
+        uint64_t tick = 0;
+    };
+}
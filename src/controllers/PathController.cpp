@@ -4,7 +4,7 @@
 //
 #include "PathController.h"
 using namespace ofxRobotArm;
-PathController::PathController():currentState(NOT_READY){
+PathController::PathController():pathIndex(0), currentState(NOT_READY), isDone(false), pause(false){
     
 }
 
@@ -10,6 +10,7 @@ using namespace ofxRobotArm;
 
 
 RobotController::RobotController(){
+    robot = nullptr;
     bMove.set("Move Robot", false);
 }
 
@@ -20,6 +21,7 @@ RobotController::~RobotController(){
 
 
 void RobotController::setType(RobotType type){
+    this->type = type;
     if (type == UR3 || type == UR5 || type == UR10)
     {
         robot = new URDriver();
@@ -35,6 +37,9 @@ void RobotController::setType(RobotType type){
     else if(type == PANDA){
         robot = new PandaDriver();
     }
+    if(robot){
+        robot->setTimingProfile(TimingProfile::getDefault(type));
+    }
 }
 
 void RobotController::setAddress(string ipaddress){
@@ -71,17 +76,15 @@ void RobotController::disconnect(){
     }
 }
 
-void RobotController::update(vector<double> pose, vector<double> smoothing){
+void RobotController::update(const vector<double> & pose, const vector<double> & smoothing){
     if(robot != nullptr){
         targetPose = pose;
         currentPose = robot->getCurrentPose();
         
         if(targetPose.size() == currentPose.size()){
             if(smoothing.size() == targetPose.size()){
-                int i = 0;
-                for(auto a : currentPose){
+                for(size_t i = 0; i < targetPose.size(); i++){
                     targetPose[i] = ofLerp(currentPose[i], targetPose[i], smoothing[i]);
-                    i++;
                 }
             }
             robot->setPose(targetPose);
@@ -25,7 +25,7 @@ namespace ofxRobotArm {
             
             void connect();
             void disconnect();
-            void update(vector<double> pose, vector<double> smoothing);
+            void update(const vector<double> & pose, const vector<double> & smoothing);
             
             void setType(RobotType type);
             void setAddress(string ipAddress);
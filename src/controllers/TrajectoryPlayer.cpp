@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "TrajectoryPlayer.h"
+#include "SimClock.h"
+using namespace ofxRobotArm;
+
+TrajectoryPlayer::TrajectoryPlayer(){
+
+}
+
+TrajectoryPlayer::~TrajectoryPlayer(){
+
+}
+
+void TrajectoryPlayer::setup(RobotDriver * driver){
+    this->driver = driver;
+}
+
+bool TrajectoryPlayer::load(string path){
+    JointTrajectory loaded;
+    if(!loaded.load(path)){
+        return false;
+    }
+    setTrajectory(loaded);
+    return true;
+}
+
+void TrajectoryPlayer::setTrajectory(const JointTrajectory & trajectory){
+    this->trajectory = trajectory;
+    stop();
+}
+
+const JointTrajectory & TrajectoryPlayer::getTrajectory(){
+    return trajectory;
+}
+
+void TrajectoryPlayer::play(){
+    if(trajectory.size() == 0){
+        ofLogWarning("TrajectoryPlayer") << "play: no trajectory loaded";
+        return;
+    }
+    if(driver && driver->numJoints != trajectory.getNumJoints()){
+        ofLogWarning("TrajectoryPlayer") << "play: trajectory has " << trajectory.getNumJoints() << " joints, robot has " << driver->numJoints;
+        return;
+    }
+    if(bDone){
+        playhead = 0;
+        bDone = false;
+    }
+    lastUpdateMicros = simclock::nowMicros();
+    bPlaying = true;
+}
+
+void TrajectoryPlayer::pause(){
+    bPlaying = false;
+}
+
+void TrajectoryPlayer::stop(){
+    bPlaying = false;
+    bDone = false;
+    playhead = 0;
+}
+
+bool TrajectoryPlayer::isPlaying(){
+    return bPlaying;
+}
+
+bool TrajectoryPlayer::isDone(){
+    return bDone;
+}
+
+void TrajectoryPlayer::setSpeed(double speed){
+    this->speed = MAX(speed, 0.0);
+}
+
+double TrajectoryPlayer::getSpeed(){
+    return speed;
+}
+
+void TrajectoryPlayer::setTimeWarp(std::function<double(double)> warp){
+    timeWarp = warp;
+}
+
+void TrajectoryPlayer::setLoop(bool loop){
+    bLoop = loop;
+}
+
+vector<double> TrajectoryPlayer::update(){
+    uint64_t now = simclock::nowMicros();
+    double dt = (now - lastUpdateMicros) / 1000000.0;
+    lastUpdateMicros = now;
+    return update(dt);
+}
+
+vector<double> TrajectoryPlayer::update(double dt){
+    if(!bPlaying){
+        return vector<double>();
+    }
+
+    double duration = trajectory.getDuration();
+    playhead += dt * speed;
+    if(playhead >= duration){
+        if(bLoop && duration > 0){
+            playhead = fmod(playhead, duration);
+        }else{
+            playhead = duration;
+            bPlaying = false;
+            bDone = true;
+        }
+    }
+
+    double t = playhead;
+    if(timeWarp && duration > 0){
+        t = ofClamp(timeWarp(playhead / duration), 0.0, 1.0) * duration;
+    }
+    trajectory.getPoseAt(trajectory.getTime(0) + t, pose);
+
+    if(driver){
+        driver->setPose(pose);
+    }
+    return pose;
+}
+
+double TrajectoryPlayer::getProgress(){
+    double duration = trajectory.getDuration();
+    return duration > 0 ? playhead / duration : 0;
+}
@@ -0,0 +1,59 @@
+//
+//  TrajectoryPlayer.h
+//  ofxRobotArm
+//
+//  Streams a JointTrajectory to any RobotDriver through setPose, so it goes
+//  through the same servo path (servoj / EGM / xArm servo mode) as live control.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "RobotDriver.h"
+#include "JointTrajectory.h"
+namespace ofxRobotArm{
+    class TrajectoryPlayer{
+    public:
+        TrajectoryPlayer();
+        ~TrajectoryPlayer();
+
+        void setup(RobotDriver * driver);
+        bool load(string path);
+        void setTrajectory(const JointTrajectory & trajectory);
+        const JointTrajectory & getTrajectory();
+
+        void play();
+        void pause();
+        void stop();
+        bool isPlaying();
+        bool isDone();
+
+        /// \brief playback rate, 1.0 is recorded speed
+        void setSpeed(double speed);
+        double getSpeed();
+        /// \brief maps normalized playback progress [0, 1] to normalized trajectory time [0, 1],
+        /// e.g. an ease curve to soften start and end. Should be monotonic.
+        void setTimeWarp(std::function<double(double)> warp);
+        void setLoop(bool loop);
+
+        /// \brief advance the playhead by the elapsed host time and send the pose
+        /// to the driver; returns the commanded pose (empty when not playing)
+        vector<double> update();
+        /// \brief same, with an explicit time step in seconds (lockstep / offline use)
+        vector<double> update(double dt);
+
+        double getProgress();
+
+    protected:
+        RobotDriver * driver = nullptr;
+        JointTrajectory trajectory;
+        std::function<double(double)> timeWarp;
+        vector<double> pose;
+        double playhead = 0;
+        double speed = 1.0;
+        uint64_t lastUpdateMicros = 0;
+        bool bPlaying = false;
+        bool bLoop = false;
+        bool bDone = false;
+    };
+}
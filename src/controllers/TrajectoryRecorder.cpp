@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "TrajectoryRecorder.h"
+#include "SimClock.h"
+using namespace ofxRobotArm;
+
+namespace{
+    // how often the recorder thread takes in the ring, ms
+    const int DRAIN_INTERVAL = 5;
+}
+
+TrajectoryRecorder::TrajectoryRecorder() : bRecording(false), startMicros(0), head(0), tail(0), dropped(0){
+    ring.assign(RING_CAPACITY, Sample());
+}
+
+TrajectoryRecorder::~TrajectoryRecorder(){
+    stop();
+}
+
+void TrajectoryRecorder::start(RobotType type, int numJoints){
+    stop();
+    mutex.lock();
+    trajectory.setup(type, numJoints);
+    lastSampleTime = -1;
+    mutex.unlock();
+    // anything left over from the last recording is older than startMicros and skipped
+    startMicros = simclock::nowMicros();
+    tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    dropped = 0;
+    bRecording = true;
+    startThread();
+}
+
+void TrajectoryRecorder::stop(){
+    bRecording = false;
+    if(isThreadRunning()){
+        stopThread();
+        waitForThread(false);
+    }
+    drain();
+}
+
+bool TrajectoryRecorder::isRecording(){
+    return bRecording;
+}
+
+void TrajectoryRecorder::setMinInterval(double seconds){
+    mutex.lock();
+    minInterval = MAX(seconds, 0.0);
+    mutex.unlock();
+}
+
+void TrajectoryRecorder::addSample(const vector<double> & joints){
+    if(!bRecording) return;
+    addSample(simclock::nowMicros(), joints.data(), joints.size());
+}
+
+void TrajectoryRecorder::addSample(uint64_t timeMicros, const double * joints, int count){
+    if(!bRecording) return;
+    uint64_t h = head.load(std::memory_order_relaxed);
+    while(h - tail.load(std::memory_order_acquire) >= RING_CAPACITY){
+        if(!simclock::isVirtual() || !isThreadRunning()){
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // virtual time isn't waiting on an arm, keep every sample
+        std::this_thread::yield();
+    }
+    Sample & s = ring[h % RING_CAPACITY];
+    s.timeMicros = timeMicros;
+    s.count = MIN(count, MAX_JOINTS);
+    std::copy(joints, joints + s.count, s.joints);
+    head.store(h + 1, std::memory_order_release);
+}
+
+void TrajectoryRecorder::threadedFunction(){
+    while(isThreadRunning()){
+        drain();
+        ofSleepMillis(DRAIN_INTERVAL);
+    }
+}
+
+void TrajectoryRecorder::drain(){
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    uint64_t h = head.load(std::memory_order_acquire);
+    if(t == h){
+        return;
+    }
+    uint64_t start = startMicros;
+    mutex.lock();
+    for(; t < h; t++){
+        const Sample & s = ring[t % RING_CAPACITY];
+        if(s.timeMicros < start){
+            continue;
+        }
+        double time = (s.timeMicros - start) / 1000000.0;
+        if(s.count >= trajectory.getNumJoints() && (lastSampleTime < 0 || time - lastSampleTime >= minInterval)){
+            trajectory.addSample(time, s.joints);
+            lastSampleTime = time;
+        }
+    }
+    mutex.unlock();
+    tail.store(h, std::memory_order_release);
+}
+
+JointTrajectory TrajectoryRecorder::getTrajectory(){
+    JointTrajectory ret;
+    mutex.lock();
+    ret = trajectory;
+    mutex.unlock();
+    return ret;
+}
+
+bool TrajectoryRecorder::save(string path){
+    mutex.lock();
+    bool ret = trajectory.save(path);
+    mutex.unlock();
+    if(ret){
+        ofLogNotice("TrajectoryRecorder") << "saved " << trajectory.size() << " samples (" << trajectory.getDuration() << "s) to " << path;
+    }
+    if(dropped > 0){
+        ofLogWarning("TrajectoryRecorder") << dropped << " samples were dropped, the recorder thread fell behind";
+    }
+    return ret;
+}
+
+size_t TrajectoryRecorder::size(){
+    size_t ret;
+    mutex.lock();
+    ret = trajectory.size();
+    mutex.unlock();
+    return ret;
+}
@@ -0,0 +1,73 @@
+//
+//  TrajectoryRecorder.h
+//  ofxRobotArm
+//
+//  Host side teach recording. Drivers push every joint update they
+//  receive from the arm, so the recording runs at the arm's report rate.
+//
+//  The driver thread pushes into a lock-free ring; the recorder's own
+//  thread drains it into the trajectory, so nothing on the driver side
+//  waits on a mutex or allocates. On a real clock a full ring drops the
+//  sample and counts it; on virtual time (SimClock) the driver waits for
+//  room instead, so lockstep runs record every tick.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "JointTrajectory.h"
+#include <atomic>
+namespace ofxRobotArm{
+    class TrajectoryRecorder : public ofThread{
+    public:
+        static const int MAX_JOINTS = 8;
+        /// \brief samples buffered between the driver and the recorder thread
+        static const size_t RING_CAPACITY = 4096;
+
+        struct Sample{
+            uint64_t timeMicros;
+            int count;
+            double joints[MAX_JOINTS];
+        };
+
+        TrajectoryRecorder();
+        ~TrajectoryRecorder();
+
+        void start(RobotType type, int numJoints);
+        /// \brief stops and takes in whatever the driver pushed before
+        void stop();
+        bool isRecording();
+
+        /// \brief skip samples closer than minInterval seconds to the last one, 0 keeps all
+        void setMinInterval(double seconds);
+
+        /// \brief called from the driver thread, never blocks or allocates on a
+        /// real clock. The first overload timestamps with simclock.
+        void addSample(const vector<double> & joints);
+        void addSample(uint64_t timeMicros, const double * joints, int count);
+
+        /// \brief samples taken in so far, up to a few ms behind while recording
+        JointTrajectory getTrajectory();
+        bool save(string path);
+        size_t size();
+        uint64_t getNumDropped(){ return dropped.load(); }
+
+        void threadedFunction();
+
+    protected:
+        void drain();
+
+        ofMutex mutex;
+        JointTrajectory trajectory;
+        std::atomic<bool> bRecording;
+        std::atomic<uint64_t> startMicros;
+        double lastSampleTime = -1;
+        double minInterval = 0;
+
+        // single producer ring, the driver thread writes, the recorder thread reads
+        vector<Sample> ring;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::atomic<uint64_t> dropped;
+    };
+}
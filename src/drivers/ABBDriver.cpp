@@ -9,6 +9,9 @@
 
 
 #include "ABBDriver.h"
+#include "SimClock.h"
+#include "Trace.h"
+#include "AsyncLog.h"
 using namespace ofxRobotArm;
 ABBDriver::ABBDriver(){
     ofLog()<<"ABBDriver"<<endl;
@@ -28,19 +31,15 @@ ABBDriver::ABBDriver(){
     poseRaw.getBack().assign(numJoints, 0.0001);
     poseProcessed.getBack().assign(numJoints, 0.0001);
     toolPoseRaw.getBack().assign(numJoints, 0.0001);
-    numDeccelSteps = 120;
+    setTimingProfile(TimingProfile::getDefault(IRB120));
 }
 
 ABBDriver::~ABBDriver(){
-    if(robot->isInitialized()){
-        disconnect();
-    }
+    // the thread uses robot, it has to be gone before the members are
+    disconnect();
 }
 
 void ABBDriver::stopThread(){
-    if(isConnected()){
-        disconnect();
-    }
     if(isThreadRunning()){
         ofThread::stopThread();
     }
@@ -102,6 +101,11 @@ void ABBDriver::setup(int port, double minPayload, double maxPayload){
     bTriedOnce = false;
     
     abb::egm::BaseConfiguration configuration;
+    configuration.use_logging = bLogEGM && !bBinaryLog;
+    configuration.max_logging_duration = maxLogDuration;
+    if(bLogEGM && bBinaryLog){
+        binaryLogger.open(ofToDataPath("port_" + ofToString(port) + "_log.bin"), maxLogDuration);
+    }
     robot = std::make_unique<abb::egm::EGMControllerInterface>(io_service, port, configuration);
 
     if(!robot->isInitialized())
@@ -134,9 +138,13 @@ bool ABBDriver::isConnected() {
 
 
 void ABBDriver::disconnect(){
+    if(isThreadRunning()){
+        stopThread();
+        waitForThread(false);
+    }
     io_service.stop();
     thread_group.join_all();
-    stopThread();
+    binaryLogger.close();
 }
 
 bool ABBDriver::isDataReady(){
@@ -207,8 +215,16 @@ void ABBDriver::setToolOffset(ofVec3f localPos){
     
 }
 
+void ABBDriver::setLogging(bool enabled, bool binary, double maxDuration){
+    bLogEGM = enabled;
+    bBinaryLog = binary;
+    maxLogDuration = maxDuration;
+}
+
 void ABBDriver::threadedFunction(){
+    RA_TRACE_THREAD_NAME("ABBDriver");
     while(isThreadRunning()){
+        syncAttachments();
         timer.tick();
         if(!bStarted && !bTriedOnce) {
             if( robot ) {
@@ -233,8 +249,15 @@ void ABBDriver::threadedFunction(){
                 }
             }
         }else{
-            if(robot->waitForMessage(500))
+            bool bMessage;
             {
+                RA_TRACE_SCOPE("abb.receive");
+                bMessage = robot->waitForMessage(500);
+            }
+            if(bMessage)
+            {
+                RA_TRACE_SCOPE("abb.tick");
+                memory::TickScope tick;
                 // Read the message received from the EGM client.
                 robot->read(&input);
                 sequence_number = input.header().sequence_number();
@@ -243,7 +266,19 @@ void ABBDriver::threadedFunction(){
                     poseRaw.getBack()[i] = ofDegToRad(actualPose.values(i));
                 }
                 currentPoseRadian = poseRaw.getBack();
+                // controller send time, ms
+                updateJointState(poseRaw.getBack(), input.header().time_stamp() * 0.001);
                 poseProcessed.getBack() = poseRaw.getBack();
+                if(recorder){
+                    recorder->addSample(poseRaw.getBack());
+                }
+                if(stateBus){
+                    stateBus->publish(poseRaw.getBack());
+                    pollStateBus();
+                }
+                if(stateServer){
+                    stateServer->push(poseRaw.getBack());
+                }
                 if(sequence_number == 0)
                 {
                     output.Clear();
@@ -255,20 +290,21 @@ void ABBDriver::threadedFunction(){
                 {
                     initial_positions.CopyFrom(input.feedback().robot().joints().position());
                     output.mutable_robot()->mutable_joints()->mutable_position()->CopyFrom(initial_positions);
-                    time = sequence_number/((double) egm_rate);
+                    // EGM rate, specified by the EGMActJoint/EGMActPose RAPID instruction
+                    time = sequence_number/timing.controlRate;
                     if(bMoveWithPos){
                         //if we aren't moving but deccelCount isn't 0 lets deccelerate
                         if( (bMove && currentPose.size()>0)|| (currentPose.size()>0 && deccelCount>0) ){
-                            timeNow = ofGetElapsedTimef();
-                            if( bMove || timeNow-lastTimeSentMove >= 1.0/60.0){
-                                currentPose = getAchievablePosition(currentPose);
+                            timeNow = simclock::nowSeconds();
+                            if( bMove || timeNow-lastTimeSentMove >= 1.0/timing.commandRate){
+                                makeAchievable(currentPose);
                                 if(output.mutable_robot()->mutable_joints()->mutable_position()->values_size() == currentPose.size())
                                 {
                                     for(int i = 0 ; i < currentPose.size(); i++){
                                         output.mutable_robot()->mutable_joints()->mutable_position()->set_values(i, ofRadToDeg(currentPose[i]));
                                     }
                                 }else{
-                                    ofLog()<<"OUTPUT NOT BIG ENOUGH size "<<output.mutable_robot()->mutable_joints()->mutable_position()->values_size()<<endl;
+                                    RA_LOG_WARNING("ABBDriver", "OUTPUT NOT BIG ENOUGH size %d", output.mutable_robot()->mutable_joints()->mutable_position()->values_size());
                                 }
                                 if(!bMove){
                                     deccelCount--;
@@ -283,7 +319,13 @@ void ABBDriver::threadedFunction(){
                     }
                 }
                 // Write references back to the EGM client.
-                robot->write(output);
+                {
+                    RA_TRACE_SCOPE("abb.send");
+                    robot->write(output);
+                }
+                if(bLogEGM && bBinaryLog){
+                    binaryLogger.add(input, output);
+                }
                 
                 toolPoseRaw.swapBack();
                 poseRaw.swapBack();
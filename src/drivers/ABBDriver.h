@@ -5,6 +5,7 @@
 #include "ofxTiming.h"
 #include "Pose.h"
 #include "Synchronized.h"
+#include "EGMBinaryLogger.h"
 #include <abb_libegm/egm_udp_server.h>
 #include <abb_libegm/egm_controller_interface.h>
 namespace ofxRobotArm{
@@ -25,6 +26,12 @@ public:
     void setTeachMode(bool enabled);
 
     void setToolOffset(ofVec3f localPos);
+    /// \brief enables EGM session logging, call before setup
+    /// \param enabled log every EGM message
+    /// \param binary write fixed-size binary records on a background thread (port_<port>_log.bin,
+    ///        see EGMBinaryLogger) instead of libegm's CSV log (port_<port>_log.csv)
+    /// \param maxDuration seconds of EGM traffic to log
+    void setLogging(bool enabled, bool binary = true, double maxDuration = 24*60*60);
     void threadedFunction();
     ofNode getToolNode();
     ofVec4f getCalculatedTCPOrientation();
@@ -51,12 +58,16 @@ public:
     abb::egm::wrapper::Joints actualPose;
     abb::egm::wrapper::Joints initial_positions;
 //    abb::egm::wrapper:: actualPose;
-    const int egm_rate = 250.0; // [Hz] (EGM communication rate, specified by the EGMActPose RAPID instruction).
     int sequence_number = 0;    // [-] (sequence number of a received EGM message).
     double time = 0.0;          // [seconds] (elapsed time during an EGM communication session).
 
     abb::egm::wrapper::Output output;
 
+    bool bLogEGM = false;
+    bool bBinaryLog = true;
+    double maxLogDuration = 24*60*60;
+    EGMBinaryLogger binaryLogger;
+
     double numJoints = 6;
 };
 }
@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "EGMBinaryLogger.h"
+#include <cstring>
+
+using namespace ofxRobotArm;
+
+namespace{
+    const char MAGIC[8] = "EGMBLOG";
+    // padding of the robot joints before the external ones, as libegm's CSV log
+    const int ROBOT_JOINTS = 6;
+
+    /// the columns of libegm's EGMLogger
+    void writeHeaders(std::ostream & stream){
+        const char * channels[] = {"R_FB", "R_PL", "S_REF"};
+        stream << "TIMESTAMP";
+        for(const char * c : channels){
+            for(const char * kind : {"POS", "VEL"}){
+                for(int i = 1; i <= 6; i++){
+                    stream << "," << c << "_" << kind << "_RJ" << i;
+                }
+                for(int i = 1; i <= 6; i++){
+                    stream << "," << c << "_" << kind << "_EJ" << i;
+                }
+            }
+            stream << "," << c << "_POS_X," << c << "_POS_Y," << c << "_POS_Z";
+            stream << "," << c << "_EULER_X," << c << "_EULER_Y," << c << "_EULER_Z";
+            stream << "," << c << "_QUAT_U0," << c << "_QUAT_U1," << c << "_QUAT_U2," << c << "_QUAT_U3";
+            stream << "," << c << "_VEL_LX," << c << "_VEL_LY," << c << "_VEL_LZ";
+            stream << "," << c << "_VEL_AX," << c << "_VEL_AY," << c << "_VEL_AZ";
+        }
+        stream << "\n";
+    }
+}
+
+const int EGMBinaryLogger::MAX_JOINTS;
+const uint32_t EGMBinaryLogger::FILE_VERSION;
+
+EGMBinaryLogger::EGMBinaryLogger() : head(0), tail(0), dropped(0), bStop(false){
+}
+
+EGMBinaryLogger::~EGMBinaryLogger(){
+    close();
+}
+
+bool EGMBinaryLogger::open(string filename, double maxDuration, size_t capacity, int flushIntervalMs){
+    close();
+    stream.open(filename.c_str(), std::ios::trunc | std::ios::binary);
+    if(!stream.is_open()){
+        ofLogError("EGMBinaryLogger") << "could not open " << filename;
+        return false;
+    }
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.recordSize = sizeof(Record);
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    buffer.assign(MAX(capacity, (size_t)1), Record());
+    head = 0;
+    tail = 0;
+    dropped = 0;
+    bStop = false;
+    bHasFirst = false;
+    this->maxDuration = maxDuration;
+    this->flushIntervalMs = MAX(flushIntervalMs, 1);
+    writer = std::thread(&EGMBinaryLogger::writerLoop, this);
+    return true;
+}
+
+void EGMBinaryLogger::close(){
+    if(writer.joinable()){
+        bStop = true;
+        writer.join();
+    }
+    if(stream.is_open()){
+        stream.close();
+    }
+}
+
+bool EGMBinaryLogger::isOpen(){
+    return writer.joinable();
+}
+
+bool EGMBinaryLogger::add(const abb::egm::wrapper::Input & input, const abb::egm::wrapper::Output & output){
+    if(!writer.joinable()){
+        return false;
+    }
+    uint32_t timeStamp = input.header().time_stamp();
+    if(!bHasFirst){
+        firstTimeStamp = timeStamp;
+        bHasFirst = true;
+    }else if((timeStamp - firstTimeStamp) * 0.001 > maxDuration){
+        return false;
+    }
+    uint64_t h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) >= buffer.size()){
+        // never wait for the writer
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Record & record = buffer[h % buffer.size()];
+    const auto & feedback = input.feedback();
+    const auto & planned = input.planned();
+    record.timeStamp = timeStamp;
+    record.sequenceNumber = input.header().sequence_number();
+
+    copy(record.feedback.jointPositions, feedback.robot().joints().position(), feedback.external().joints().position());
+    copy(record.feedback.jointVelocities, feedback.robot().joints().velocity(), feedback.external().joints().velocity());
+    copy(record.feedback.cartesian, feedback.robot().cartesian().pose(), feedback.robot().cartesian().velocity());
+
+    copy(record.planned.jointPositions, planned.robot().joints().position(), planned.external().joints().position());
+    copy(record.planned.jointVelocities, planned.robot().joints().velocity(), planned.external().joints().velocity());
+    copy(record.planned.cartesian, planned.robot().cartesian().pose(), planned.robot().cartesian().velocity());
+
+    copy(record.references.jointPositions, output.robot().joints().position(), output.external().joints().position());
+    copy(record.references.jointVelocities, output.robot().joints().velocity(), output.external().joints().velocity());
+    copy(record.references.cartesian, output.robot().cartesian().pose(), output.robot().cartesian().velocity());
+
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t EGMBinaryLogger::getNumRecords(){
+    return head.load(std::memory_order_relaxed);
+}
+
+uint64_t EGMBinaryLogger::getNumDropped(){
+    return dropped.load(std::memory_order_relaxed);
+}
+
+bool EGMBinaryLogger::convertToCSV(string binaryFilename, string csvFilename){
+    std::ifstream in(binaryFilename.c_str(), std::ios::binary);
+    if(!in.is_open()){
+        ofLogError("EGMBinaryLogger") << "could not open " << binaryFilename;
+        return false;
+    }
+    FileHeader header;
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if(!in || std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 ||
+       header.version != FILE_VERSION || header.recordSize != sizeof(Record)){
+        ofLogError("EGMBinaryLogger") << binaryFilename << " is not a version " << FILE_VERSION << " EGM binary log";
+        return false;
+    }
+    std::ofstream out(csvFilename.c_str(), std::ios::trunc);
+    if(!out.is_open()){
+        ofLogError("EGMBinaryLogger") << "could not open " << csvFilename;
+        return false;
+    }
+    writeHeaders(out);
+    Record record;
+    while(in.read(reinterpret_cast<char *>(&record), sizeof(record))){
+        out << record.timeStamp << ",";
+        writeCSV(out, record.feedback, false);
+        writeCSV(out, record.planned, false);
+        writeCSV(out, record.references, true);
+        out << "\n";
+    }
+    return true;
+}
+
+void EGMBinaryLogger::copy(double * values, const abb::egm::wrapper::Joints & robot, const abb::egm::wrapper::Joints & external){
+    int index = 0;
+    for(int i = 0; i < robot.values_size() && index < MAX_JOINTS; i++){
+        values[index++] = robot.values(i);
+    }
+    while(index < ROBOT_JOINTS){
+        values[index++] = 0;
+    }
+    for(int i = 0; i < external.values_size() && index < MAX_JOINTS; i++){
+        values[index++] = external.values(i);
+    }
+    while(index < MAX_JOINTS){
+        values[index++] = 0;
+    }
+}
+
+void EGMBinaryLogger::copy(CartesianRecord & cartesian, const abb::egm::wrapper::CartesianPose & pose, const abb::egm::wrapper::CartesianVelocity & velocity){
+    cartesian.position[0] = pose.position().x();
+    cartesian.position[1] = pose.position().y();
+    cartesian.position[2] = pose.position().z();
+    cartesian.euler[0] = pose.euler().x();
+    cartesian.euler[1] = pose.euler().y();
+    cartesian.euler[2] = pose.euler().z();
+    cartesian.quaternion[0] = pose.quaternion().u0();
+    cartesian.quaternion[1] = pose.quaternion().u1();
+    cartesian.quaternion[2] = pose.quaternion().u2();
+    cartesian.quaternion[3] = pose.quaternion().u3();
+    cartesian.linearVelocity[0] = velocity.linear().x();
+    cartesian.linearVelocity[1] = velocity.linear().y();
+    cartesian.linearVelocity[2] = velocity.linear().z();
+    cartesian.angularVelocity[0] = velocity.angular().x();
+    cartesian.angularVelocity[1] = velocity.angular().y();
+    cartesian.angularVelocity[2] = velocity.angular().z();
+}
+
+void EGMBinaryLogger::writeCSV(std::ostream & stream, const ChannelRecord & channel, bool last){
+    for(int i = 0; i < MAX_JOINTS; i++){
+        stream << channel.jointPositions[i] << ",";
+    }
+    for(int i = 0; i < MAX_JOINTS; i++){
+        stream << channel.jointVelocities[i] << ",";
+    }
+    const CartesianRecord & c = channel.cartesian;
+    stream << c.position[0] << "," << c.position[1] << "," << c.position[2] << ",";
+    stream << c.euler[0] << "," << c.euler[1] << "," << c.euler[2] << ",";
+    stream << c.quaternion[0] << "," << c.quaternion[1] << "," << c.quaternion[2] << "," << c.quaternion[3] << ",";
+    stream << c.linearVelocity[0] << "," << c.linearVelocity[1] << "," << c.linearVelocity[2] << ",";
+    stream << c.angularVelocity[0] << "," << c.angularVelocity[1] << "," << c.angularVelocity[2] << (last ? "" : ",");
+}
+
+void EGMBinaryLogger::writerLoop(){
+    while(!bStop.load(std::memory_order_acquire)){
+        std::this_thread::sleep_for(std::chrono::milliseconds(flushIntervalMs));
+        flush();
+    }
+    // whatever came in before the stop
+    flush();
+}
+
+void EGMBinaryLogger::flush(){
+    uint64_t h = head.load(std::memory_order_acquire);
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    if(h == t){
+        return;
+    }
+    while(t < h){
+        // at most two contiguous chunks, before and after the wrap
+        size_t index = t % buffer.size();
+        size_t count = std::min<uint64_t>(h - t, buffer.size() - index);
+        stream.write(reinterpret_cast<const char *>(&buffer[index]), count * sizeof(Record));
+        t += count;
+        tail.store(t, std::memory_order_release);
+    }
+    stream.flush();
+}
@@ -0,0 +1,100 @@
+//
+//  EGMBinaryLogger.h
+//  ofxRobotArm
+//
+//  Logs an EGM session as fixed-size binary records. The ABB driver adds
+//  one record per message on its thread into a preallocated ring buffer,
+//  and a background thread writes the buffer to file, so the control loop
+//  never blocks on I/O or allocates. If the writer falls behind, records
+//  are dropped and counted.
+//
+//  Lives in the addon rather than in libegm so the prebuilt libabb_libegm
+//  keeps the class layout its headers describe. convertToCSV writes the
+//  same columns as libegm's CSV EGMLogger.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include <abb_libegm/egm_wrapper.pb.h>
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+namespace ofxRobotArm{
+    class EGMBinaryLogger{
+    public:
+        static const int MAX_JOINTS = 12;
+        static const uint32_t FILE_VERSION = 1;
+
+        struct CartesianRecord{
+            double position[3];
+            double euler[3];
+            double quaternion[4];
+            double linearVelocity[3];
+            double angularVelocity[3];
+        };
+
+        /// \brief feedback, planned or references: robot joints first, then external joints
+        struct ChannelRecord{
+            double jointPositions[MAX_JOINTS];
+            double jointVelocities[MAX_JOINTS];
+            CartesianRecord cartesian;
+        };
+
+        struct Record{
+            /// \brief ms, from the message header
+            uint32_t timeStamp;
+            uint32_t sequenceNumber;
+            ChannelRecord feedback;
+            ChannelRecord planned;
+            /// \brief the outputs sent to the controller
+            ChannelRecord references;
+        };
+
+        struct FileHeader{
+            char magic[8];
+            uint32_t version;
+            uint32_t recordSize;
+        };
+
+        EGMBinaryLogger();
+        ~EGMBinaryLogger();
+
+        /// \brief opens filename and starts the writer, capacity records are
+        /// buffered before any are dropped, maxDuration seconds are logged
+        bool open(string filename, double maxDuration = 24 * 60 * 60, size_t capacity = 4096, int flushIntervalMs = 50);
+        /// \brief writes what is left and closes the file
+        void close();
+        bool isOpen();
+
+        /// \brief driver thread only. False if the record was dropped or the
+        /// duration is up. Never allocates.
+        bool add(const abb::egm::wrapper::Input & input, const abb::egm::wrapper::Output & output);
+
+        uint64_t getNumRecords();
+        uint64_t getNumDropped();
+
+        static bool convertToCSV(string binaryFilename, string csvFilename);
+
+    protected:
+        static void copy(double * values, const abb::egm::wrapper::Joints & robot, const abb::egm::wrapper::Joints & external);
+        static void copy(CartesianRecord & cartesian, const abb::egm::wrapper::CartesianPose & pose, const abb::egm::wrapper::CartesianVelocity & velocity);
+        static void writeCSV(std::ostream & stream, const ChannelRecord & channel, bool last);
+        void writerLoop();
+        void flush();
+
+        vector<Record> buffer;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::atomic<uint64_t> dropped;
+        std::atomic<bool> bStop;
+        int flushIntervalMs = 50;
+        double maxDuration = 0;
+        bool bHasFirst = false;
+        uint32_t firstTimeStamp = 0;
+
+        std::ofstream stream;
+        std::thread writer;
+    };
+}
@@ -10,11 +10,24 @@
 #include "ofxTiming.h"
 #include "Pose.h"
 #include "Synchronized.h"
+#include "TrajectoryRecorder.h"
+#include "TickMemory.h"
+#include "StateBus.h"
+#include "StateServer.h"
+#include "TimingProfile.h"
+#include "JointStateEstimator.h"
+#include "AsyncLog.h"
 namespace ofxRobotArm
 {
+    class CartesianVelocityController;
+    class ContactDetector;
+
     class RobotDriver : public ofThread
     {
     public:
+        /// \brief most joints any driver has, as the state bus
+        static const int MAX_JOINTS = OFXRA_BUS_MAX_JOINTS;
+
         RobotDriver(){
 
         };
@@ -34,10 +47,41 @@ namespace ofxRobotArm
         virtual void setTeachMode(bool enabled) = 0;
         virtual void threadedFunction() = 0;
         virtual vector<double> getInitPose() = 0;
+        /// \brief true if the tick streams the speeds of setVelocityControl
+        virtual bool supportsVelocityControl(){ return false; }
+        /// \brief true if the tick feeds and acts on setContactDetector's detector
+        virtual bool supportsContactDetection(){ return false; }
 
         vector<double> getAchievablePosition(vector<double> position)
         {
-            float maxAccelDeg = 500.0;
+            makeAchievable(position);
+            return position;
+        }
+
+        /// \brief rates, servo parameters and limits, see TimingProfile
+        virtual void setTimingProfile(const TimingProfile & profile)
+        {
+            lock();
+            timing = profile;
+            numDeccelSteps = profile.decelSteps;
+            estimator.setPositionNoise(profile.positionNoise);
+            estimator.setJerkNoise(profile.jerkNoise);
+            unlock();
+        }
+
+        TimingProfile getTimingProfile()
+        {
+            TimingProfile ret;
+            lock();
+            ret = timing;
+            unlock();
+            return ret;
+        }
+
+        /// \brief limits position in place, allocation free once calculatedSpeed is sized
+        void makeAchievable(vector<double> & position)
+        {
+            float maxAccelDeg = timing.maxJointAccel;
             float maxSpeedPct = 1.0;
 
             if (!bMove && deccelCount > 0)
@@ -51,7 +95,7 @@ namespace ofxRobotArm
             }
             if (bMove)
             {
-                acceleratePct += 0.02;
+                acceleratePct += timing.accelRamp;
                 if (acceleratePct > 1.0)
                 {
                     acceleratePct = 1.0;
@@ -60,33 +104,32 @@ namespace ofxRobotArm
 
             maxSpeedPct *= acceleratePct;
 
-            //this seeems to do much better with a hardcoded timedelta
-            float timeDiff = 1.0 / 120.0; //timeNow-lastTimeSentMove;
+            //this seeems to do much better with a fixed timedelta than timeNow-lastTimeSentMove
+            //the estimator's period is the smoothed one between real samples, so it holds when the rate drifts
+            float timeDiff = estimator.isReady() ? estimator.getSamplePeriod() : timing.moveTimeStep;
 
             if (currentPoseRadian.size() && position.size())
             {
 
-                vector<double> lastSpeed = calculatedSpeed;
-
                 if (calculatedSpeed.size() != position.size())
                 {
                     calculatedSpeed.assign(position.size(), 0);
-                    lastSpeed = calculatedSpeed;
                 }
+                // on the stack, this also runs off the driver thread (getAchievablePosition)
+                unsigned int numLimited = MIN(MIN(position.size(), currentPoseRadian.size()), (size_t)MAX_JOINTS);
+                double lastSpeed[MAX_JOINTS];
+                std::copy(calculatedSpeed.begin(), calculatedSpeed.begin() + numLimited, lastSpeed);
 
-                for (unsigned int d = 0; d < position.size(); d++)
+                for (unsigned int d = 0; d < numLimited; d++)
                 {
                     calculatedSpeed[d] = (position[d] - currentPoseRadian[d]) / timeDiff;
                 }
 
-                vector<double> acceleration;
-                acceleration.assign(calculatedSpeed.size(), 0);
-
-                for (unsigned int d = 0; d < acceleration.size(); d++)
+                for (unsigned int d = 0; d < numLimited; d++)
                 {
-                    acceleration[d] = (calculatedSpeed[d] - lastSpeed[d]) / timeDiff;
+                    double jointAcceleration = (calculatedSpeed[d] - lastSpeed[d]) / timeDiff;
 
-                    float accelDegPerSec = ofRadToDeg(acceleration[d]);
+                    float accelDegPerSec = ofRadToDeg(jointAcceleration);
 
                     //this is the max accel reccomended.
                     //if we are over it we limit the new position to being the old position plus the current speed, plus the max acceleration
@@ -106,15 +149,15 @@ namespace ofxRobotArm
                     }
                     else if (maxSpeedPct < 1.0)
                     {
-                        position[d] = currentPoseRadian[d] + (currentSpeed[d] * timeDiff * maxSpeedPct);
+                        // ramp down from the speed the joint is actually moving at
+                        double speed = estimator.isReady() && (int)d < estimator.getNumJoints() ? estimator.getVelocity(d) : currentSpeed[d];
+                        position[d] = currentPoseRadian[d] + (speed * timeDiff * maxSpeedPct);
                     }
                 }
             }
-
-            return position;
         }
         
-        float getThreadFPS(){
+        virtual float getThreadFPS(){
             float fps = 0;
             lock();
             fps = timer.getFrameRate();
@@ -122,7 +165,7 @@ namespace ofxRobotArm
             return fps;
         }
    
-        bool isDataReady(){
+        virtual bool isDataReady(){
             if(bDataReady){
                 bDataReady = false;
                 return true;
@@ -130,7 +173,7 @@ namespace ofxRobotArm
                 return false;
             }
         }
-        vector<double> getToolPointRaw(){
+        virtual vector<double> getToolPointRaw(){
             vector<double> ret;
             lock();
             toolPoseRaw.swapFront();
@@ -139,7 +182,7 @@ namespace ofxRobotArm
             return ret;
         }
 
-        vector<double> getCurrentPose(){
+        virtual vector<double> getCurrentPose(){
             vector<double> ret;
             
             lock();
@@ -150,7 +193,18 @@ namespace ofxRobotArm
             return ret;
         }
 
-        ofVec4f getCalculatedTCPOrientation(){
+        /// \brief filtered joint positions, velocities and accelerations of the
+        /// last sample, see JointStateEstimator. getCurrentPose is the raw state.
+        virtual JointState getJointState(){
+            JointState ret;
+            lock();
+            jointState.swapFront();
+            ret = jointState.getFront();
+            unlock();
+            return ret;
+        }
+
+        virtual ofVec4f getCalculatedTCPOrientation(){
             ofVec4f ret;
             lock();
             ret = ofVec4f(dtoolPoint.orientation.x(), dtoolPoint.orientation.y(), dtoolPoint.orientation.z(), dtoolPoint.orientation.w());
@@ -158,7 +212,7 @@ namespace ofxRobotArm
             return ret;
         }
 
-        ofxRobotArm::Pose getToolPose(){
+        virtual ofxRobotArm::Pose getToolPose(){
             ofxRobotArm::Pose ret;
             lock();
             ret = tool;
@@ -166,7 +220,7 @@ namespace ofxRobotArm
             return ret;
         }
 
-        void setSpeed(vector<double> speeds, double accel){
+        virtual void setSpeed(vector<double> speeds, double accel){
             lock();
             currentSpeed = speeds;
             acceleration = accel;
@@ -175,7 +229,7 @@ namespace ofxRobotArm
             unlock();
         }
 
-        void setPose(vector<double> pose){
+        virtual void setPose(vector<double> pose){
             lock();
             currentPose = pose;
             bMove = true;
@@ -184,6 +238,151 @@ namespace ofxRobotArm
             bStop = false;
             unlock();
         }
+
+        /// \brief record every joint update received from the arm, nullptr to detach
+        void setRecorder(TrajectoryRecorder * recorder){
+            lock();
+            attachments.recorder = recorder;
+            uint64_t request = ++attachRequested;
+            unlock();
+            waitForAttachments(request);
+        }
+
+        /// \brief publish joint updates on a shared-memory bus and take its commands, nullptr to detach
+        void setStateBus(StateBus * bus){
+            lock();
+            attachments.stateBus = bus;
+            uint64_t request = ++attachRequested;
+            unlock();
+            waitForAttachments(request);
+        }
+
+        /// \brief stream joint updates to remote clients, nullptr to detach
+        void setStateServer(StateServer * server){
+            lock();
+            attachments.stateServer = server;
+            uint64_t request = ++attachRequested;
+            unlock();
+            waitForAttachments(request);
+        }
+
+        /// \brief maps its TCP twist to joint speeds on every tick and streams them,
+        /// taking over from setPose/setSpeed while attached. nullptr to detach,
+        /// which stops the arm.
+        void setVelocityControl(CartesianVelocityController * control){
+            lock();
+            attachments.velocityControl = control;
+            uint64_t request = ++attachRequested;
+            unlock();
+            waitForAttachments(request);
+        }
+
+        /// \brief checks every tick for a collision and stops the arm when it
+        /// triggers, holding it until the detector is reset. nullptr to detach.
+        void setContactDetector(ContactDetector * detector){
+            lock();
+            attachments.contactDetector = detector;
+            uint64_t request = ++attachRequested;
+            unlock();
+            waitForAttachments(request);
+        }
+
+        /// \brief true while the arm is held after a contact
+        bool isContactStopped(){
+            return bContactStopped;
+        }
+
+        /// \brief feeds a joint sample to the estimator and publishes the result,
+        /// call on the driver thread with the sample's own timestamp (s)
+        void updateJointState(const vector<double> & q, double seconds){
+            if(estimator.getNumJoints() != (int)q.size()){
+                // sized on the first sample, the drivers only know their joints by then
+                memory::HeapAllowed allow;
+                estimator.setup(q.size());
+                JointState prototype;
+                estimator.getState(prototype);
+                jointState.setup(prototype);
+            }
+            estimator.update(q.data(), seconds);
+            estimator.getState(jointState.getBack());
+            jointState.swapBack();
+        }
+
+        /// \brief driver thread, at the top of every tick outside lock(): takes
+        /// in what the setters attached or detached since the last tick
+        void syncAttachments(){
+            uint64_t request = attachRequested.load();
+            if(request == attachApplied.load()){
+                return;
+            }
+            lock();
+            request = attachRequested;
+            recorder = attachments.recorder;
+            stateBus = attachments.stateBus;
+            stateServer = attachments.stateServer;
+            if(!attachments.velocityControl && velocityControl){
+                bVelocityStop = true;
+            }
+            velocityControl = attachments.velocityControl;
+            if(attachments.contactDetector != contactDetector){
+                bContactStopped = false;
+            }
+            contactDetector = attachments.contactDetector;
+            unlock();
+            if(velocityControl && (int)velocitySpeeds.size() != numJoints){
+                memory::HeapAllowed allow;
+                velocitySpeeds.assign(numJoints, 0.0);
+            }
+            if(contactDetector && (int)contactExpected.size() != numJoints){
+                memory::HeapAllowed allow;
+                contactExpected.assign(numJoints, 0.0);
+                contactMeasured.assign(numJoints, 0.0);
+            }
+            onAttachmentsSynced();
+            attachApplied = request;
+        }
+
+        /// \brief after syncAttachments took in a change, for drivers that hand
+        /// the attachments on to another thread of their own
+        virtual void onAttachmentsSynced(){}
+
+        /// \brief app thread: returns once the driver thread has started a tick
+        /// with the change, so nothing detached is still in use
+        void waitForAttachments(uint64_t request){
+            if(!isThreadRunning() || isCurrentThread()){
+                syncAttachments();
+                return;
+            }
+            uint64_t start = ofGetElapsedTimeMillis();
+            while(attachApplied < request && isThreadRunning()){
+                if(ofGetElapsedTimeMillis() - start > ATTACH_TIMEOUT){
+                    ofLogWarning("RobotDriver") << "the driver thread hasn't ticked in a second, the change applies on its next tick";
+                    return;
+                }
+                ofSleepMillis(1);
+            }
+        }
+
+        /// \brief applies a new command from the bus mailbox, call on the driver
+        /// thread outside lock(), before the move is sent
+        void pollStateBus(){
+            ofxra_command command;
+            if(!stateBus || !stateBus->pollCommand(command)){
+                return;
+            }
+            if((int)command.num_joints != numJoints){
+                RA_LOG_WARNING("RobotDriver", "bus command ignored, expected %d joints, got %d", numJoints, (int)command.num_joints);
+                return;
+            }
+            // setPose/setSpeed take a vector, commands are rare next to ticks
+            memory::HeapAllowed allow;
+            vector<double> values(command.values, command.values + command.num_joints);
+            if(command.mode == OFXRA_COMMAND_POSITION){
+                setPose(values);
+            }else if(command.mode == OFXRA_COMMAND_SPEED){
+                setSpeed(values, command.acceleration);
+            }
+        }
         // Robot Arm
 
         bool bTeachModeEnabled;
@@ -202,8 +401,9 @@ namespace ofxRobotArm
 
         RateTimer timer;
         float epslion = 0.00000000000000001;
-        float lastTimeSentMove = -1;
-        float timeNow = 0;
+        /// \brief s, simclock
+        double lastTimeSentMove = -1;
+        double timeNow = 0;
         deque<vector<double>> poseBuffers;
         deque<vector<double>> speedBuffers;
 
@@ -212,6 +412,8 @@ namespace ofxRobotArm
         Synchronized<vector<double>> poseProcessed;
         Synchronized<vector<double>> poseRaw;
         Synchronized<vector<double>> toolPoseRaw;
+        JointStateEstimator estimator;
+        Synchronized<JointState> jointState;
         ofxRobotArm::Pose tool;
         ofxRobotArm::Pose dtoolPoint;
         vector<ofxRobotArm::Pose> pose;
@@ -224,5 +426,31 @@ namespace ofxRobotArm
         int deccelCount = 0;
         int numDeccelSteps = 60;
         int numJoints = 6;
+        TimingProfile timing;
+
+        /// \brief what the setters asked for, guarded by lock()
+        struct Attachments{
+            TrajectoryRecorder * recorder = nullptr;
+            StateBus * stateBus = nullptr;
+            StateServer * stateServer = nullptr;
+            CartesianVelocityController * velocityControl = nullptr;
+            ContactDetector * contactDetector = nullptr;
+        };
+        /// \brief ms the setters wait for the driver thread
+        static const uint64_t ATTACH_TIMEOUT = 1000;
+        Attachments attachments;
+        std::atomic<uint64_t> attachRequested{0};
+        std::atomic<uint64_t> attachApplied{0};
+        // the driver thread's copies, see syncAttachments
+        TrajectoryRecorder * recorder = nullptr;
+        StateBus * stateBus = nullptr;
+        StateServer * stateServer = nullptr;
+        CartesianVelocityController * velocityControl = nullptr;
+        vector<double> velocitySpeeds;
+        bool bVelocityStop = false;
+        ContactDetector * contactDetector = nullptr;
+        vector<double> contactExpected;
+        vector<double> contactMeasured;
+        std::atomic<bool> bContactStopped{false};
     };
 }
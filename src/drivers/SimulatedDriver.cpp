@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "SimulatedDriver.h"
+#include "SimClock.h"
+#include "CartesianVelocityController.h"
+#include "Trace.h"
+
+using namespace ofxRobotArm;
+
+namespace{
+    const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    const uint64_t FNV_PRIME = 1099511628211ULL;
+}
+
+SimulatedDriver::SimulatedDriver(){
+    bStarted = false;
+    bMove = false;
+    acceleration = 0;
+    digest = FNV_OFFSET;
+}
+
+SimulatedDriver::~SimulatedDriver(){
+    disconnect();
+}
+
+void SimulatedDriver::setup(vector<double> initPose){
+    lock();
+    numJoints = initPose.size();
+    this->initPose = initPose;
+    joints = initPose;
+    currentPoseRadian = initPose;
+    currentPose.clear();
+    currentSpeed.assign(numJoints, 0.0);
+    calculatedSpeed.assign(numJoints, 0.0);
+    poseRaw.setup(initPose);
+    poseProcessed.setup(initPose);
+    toolPoseRaw.setup(vector<double>(6, 0.0));
+    bMove = false;
+    bMoveWithPos = false;
+    deccelCount = 0;
+    acceleratePct = 0;
+    lastTimeSentMove = -1;
+    numSteps = 0;
+    digest = FNV_OFFSET;
+    bStarted = true;
+    unlock();
+}
+
+void SimulatedDriver::start(){
+    if(!isThreadRunning()){
+        startThread();
+    }
+}
+
+bool SimulatedDriver::isConnected(){
+    return bStarted;
+}
+
+void SimulatedDriver::stopThread(){
+    if(isThreadRunning()){
+        ofThread::stopThread();
+    }
+}
+
+void SimulatedDriver::disconnect(){
+    if(isThreadRunning()){
+        stopThread();
+        waitForThread(false);
+    }
+}
+
+vector<double> SimulatedDriver::getInitPose(){
+    return initPose;
+}
+
+uint64_t SimulatedDriver::getNumSteps(){
+    uint64_t ret;
+    lock();
+    ret = numSteps;
+    unlock();
+    return ret;
+}
+
+uint64_t SimulatedDriver::getDigest(){
+    uint64_t ret;
+    lock();
+    ret = digest;
+    unlock();
+    return ret;
+}
+
+void SimulatedDriver::step(double dt){
+    RA_TRACE_SCOPE("sim.tick");
+    syncAttachments();
+    memory::TickScope tick;
+    pollStateBus();
+
+    lock();
+    if(velocityControl){
+        velocityControl->update(joints, velocitySpeeds);
+        for(size_t i = 0; i < joints.size() && i < velocitySpeeds.size(); i++){
+            joints[i] += velocitySpeeds[i] * dt;
+        }
+    }else if(bMoveWithPos){
+        //if we aren't moving but deccelCount isn't 0 lets deccelerate, same as the real drivers
+        if( (bMove && currentPose.size() == joints.size()) || (currentPose.size() == joints.size() && deccelCount > 0) ){
+            timeNow = simclock::nowSeconds();
+            if( bMove || timeNow-lastTimeSentMove >= 1.0/timing.commandRate){
+                makeAchievable(currentPose);
+                joints = currentPose;
+                if(!bMove){
+                    deccelCount--;
+                    if( deccelCount < 0){
+                        deccelCount = 0;
+                    }
+                }
+                lastTimeSentMove = timeNow;
+            }
+            bMove = false;
+        }
+    }else if(bMove && currentSpeed.size() == joints.size()){
+        for(size_t i = 0; i < joints.size(); i++){
+            joints[i] += currentSpeed[i] * dt;
+        }
+    }
+    currentPoseRadian = joints;
+    updateJointState(joints, simclock::nowSeconds());
+    poseRaw.getBack() = joints;
+    poseProcessed.getBack() = joints;
+
+    const unsigned char * bytes = reinterpret_cast<const unsigned char *>(joints.data());
+    for(size_t i = 0; i < joints.size() * sizeof(double); i++){
+        digest = (digest ^ bytes[i]) * FNV_PRIME;
+    }
+    numSteps++;
+    unlock();
+
+    if(recorder){
+        recorder->addSample(simclock::nowMicros(), joints.data(), joints.size());
+    }
+    if(stateBus){
+        stateBus->publish(joints);
+    }
+    if(stateServer){
+        stateServer->push(joints);
+    }
+    poseRaw.swapBack();
+    poseProcessed.swapBack();
+}
+
+void SimulatedDriver::threadedFunction(){
+    RA_TRACE_THREAD_NAME("SimulatedDriver");
+    auto nextTick = std::chrono::steady_clock::now();
+    while(isThreadRunning()){
+        double dt = 1.0 / timing.controlRate;
+        nextTick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(dt));
+        auto now = std::chrono::steady_clock::now();
+        if(nextTick < now){
+            nextTick = now;
+        }else{
+            std::this_thread::sleep_until(nextTick);
+        }
+        timer.tick();
+        step(dt);
+    }
+}
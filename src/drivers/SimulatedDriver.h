@@ -0,0 +1,58 @@
+//
+//  SimulatedDriver.h
+//  ofxRobotArm
+//
+//  A robot that follows its commands exactly. Each step() is one control
+//  tick of a real driver: poll the state bus, run the commanded pose
+//  through makeAchievable at the profile's command rate (or integrate a
+//  speed command), report the result as the new joint state and hand it to
+//  the recorder, bus and server.
+//
+//  LockstepScheduler calls step() itself on virtual time. start() instead
+//  runs it on the driver thread at the profile's control rate, for using
+//  the simulation live.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "RobotDriver.h"
+
+namespace ofxRobotArm
+{
+    class SimulatedDriver : public RobotDriver
+    {
+    public:
+        SimulatedDriver();
+        ~SimulatedDriver();
+
+        /// \brief starts the simulated arm at initPose (radians)
+        void setup(vector<double> initPose);
+
+        void setAllowReconnect(bool bDoReconnect){};
+        void setup(){};
+        void setup(string ipAddress, int port, double minPayload = 0.0, double maxPayload = 1.0){};
+        void setup(string ipAddress, double minPayload = 0.0, double maxPayload = 1.0){};
+        void setup(int port, double minPayload = 0.0, double maxPayload = 1.0){};
+        void start();
+        bool isConnected();
+        void disconnect();
+        void stopThread();
+        void toggleTeachMode(){};
+        void setTeachMode(bool enabled){};
+        void threadedFunction();
+        vector<double> getInitPose();
+        bool supportsVelocityControl(){ return true; }
+
+        /// \brief one control tick, dt is the tick length in seconds
+        void step(double dt);
+
+        uint64_t getNumSteps();
+        /// \brief hash of every joint state reported so far, equal digests mean bit identical runs
+        uint64_t getDigest();
+
+    protected:
+        vector<double> joints;
+        uint64_t numSteps = 0;
+        uint64_t digest;
+    };
+}
@@ -8,9 +8,18 @@
 ////
 
 #include "URDriver.h"
+#include "ContactDetector.h"
+#include "CartesianVelocityController.h"
+#include "SimClock.h"
+#include "Trace.h"
+#include "AsyncLog.h"
 using namespace ofxRobotArm;
 URDriver::URDriver(){
     currentSpeed.assign(6, 0.0);
+    // sized up front, the driver thread only copies into them
+    currentPoseRadian.assign(6, 0.0);
+    calculatedSpeed.assign(6, 0.0);
+    bMove = false;
     acceleration = 0.0;
     robot       = NULL;
     bStarted    =false;
@@ -49,7 +58,7 @@ URDriver::URDriver(){
     toolPointRaw.getBack()[4] = foo[4];
     toolPointRaw.getBack()[5] = foo[5];
     
-    numDeccelSteps = 120;
+    setTimingProfile(TimingProfile::getDefault(UR5));
 }
 
 URDriver::~URDriver(){
@@ -127,6 +136,7 @@ void URDriver::setup(string ipAddress, double minPayload, double maxPayload){
     if( ipAddress != "" && ipAddress.length() > 3 ) {
         robot = new UrDriver(rt_msg_cond_,
                          msg_cond_, ipAddress);
+        robot->rt_interface_->setServoParams(timing.servoTime, timing.servoLookahead, timing.servoGain);
     } else {
         ofLogError( "ipAddress parameter is empty. Not initializing robot." );
     }
@@ -246,6 +256,13 @@ ofxRobotArm::Pose URDriver::getToolPose(){
 }
 
 
+void URDriver::setTimingProfile(const TimingProfile & profile){
+    RobotDriver::setTimingProfile(profile);
+    if(robot){
+        robot->rt_interface_->setServoParams(profile.servoTime, profile.servoLookahead, profile.servoGain);
+    }
+}
+
 void URDriver::setSpeed(vector<double> speeds, double accel){
     lock();
     currentSpeed = speeds;
@@ -267,22 +284,24 @@ void URDriver::setPose(vector<double> positions){
 }
 
 void URDriver::threadedFunction(){
+    RA_TRACE_THREAD_NAME("URDriver");
     while(isThreadRunning()){
         timer.tick();
+        syncAttachments();
         if(!bStarted && !bTriedOnce) {
             if( robot ) {
                 bStarted = robot->start();
                 if( bStarted ){
-                    cout << " about to upload " << endl;
+                    RA_LOG_VERBOSE("URDriver", "about to upload");
                     robot->uploadProg();
-                    cout << " uploaded = true " << endl;
+                    RA_LOG_VERBOSE("URDriver", "uploaded = true");
                 }
                 if(bStarted){
-                    ofLog(OF_LOG_NOTICE)<<"Robot Started"<<endl;
+                    RA_LOG_NOTICE("URDriver", "Robot Started");
                 } else {
-                    ofLog(OF_LOG_ERROR)<<"Robot Not Started"<<endl;
+                    RA_LOG_ERROR("URDriver", "Robot Not Started");
                     if( !bTryReconnect ){
-                        ofLog(OF_LOG_ERROR)<<"bTryReconnect is disabled - won't try again"<<endl;
+                        RA_LOG_ERROR("URDriver", "bTryReconnect is disabled - won't try again");
                         bTriedOnce = true;
                     }
                 }
@@ -295,12 +314,23 @@ void URDriver::threadedFunction(){
             bDataReady = false;
             std::mutex msg_lock;
             std::unique_lock<std::mutex> locker(msg_lock);
-            while (!robot->rt_interface_->robot_state_->getControllerUpdated()) {
-                rt_msg_cond_.wait(locker);
+            {
+                RA_TRACE_SCOPE("ur.receive");
+                while (!robot->rt_interface_->robot_state_->getControllerUpdated()) {
+                    rt_msg_cond_.wait(locker);
+                }
             }
             bDataReady = true;
+            RA_TRACE_SCOPE("ur.tick");
+            memory::TickScope tick;
             
-            jointsRaw.getBack() = robot->rt_interface_->robot_state_->getQActual();
+            robot->rt_interface_->robot_state_->getQActual(jointsRaw.getBack());
+            // controller time of the sample, not when it got here
+            double sampleTime = robot->rt_interface_->robot_state_->getTime();
+            updateJointState(jointsRaw.getBack(), sampleTime);
+            if(recorder){
+                recorder->addSample(jointsRaw.getBack());
+            }
             jointsProcessed.getBack() = jointsRaw.getBack();
             dtoolPoint.orientation = ofQuaternion();
             for(unsigned int i = 0; i < joints.size(); i++){
@@ -313,11 +343,11 @@ void URDriver::threadedFunction(){
                 dtoolPoint.orientation*=joints[i].orientation;
             }
             
-            currentRobotPositionRadians = jointsRaw.getBack();
+            currentPoseRadian = jointsRaw.getBack();
             
             //this is returning weird shit that doesn't return the same values.
             
-            toolPointRaw.getBack() = robot->rt_interface_->robot_state_->getToolVectorActual();
+            robot->rt_interface_->robot_state_->getToolVectorActual(toolPointRaw.getBack());
             toolPointRaw.getBack()[3] = toolPointRaw.getBack()[3]/PI*180;
             toolPointRaw.getBack()[4] = toolPointRaw.getBack()[4]/PI*180;
             toolPointRaw.getBack()[5] = toolPointRaw.getBack()[5]/PI*180;
@@ -332,14 +362,51 @@ void URDriver::threadedFunction(){
             
             tool.position = ofVec3f(toolPointRaw.getBack()[0], toolPointRaw.getBack()[1], toolPointRaw.getBack()[2]);
             
+            if(contactDetector){
+                // the controller's target currents already carry its own dynamics model
+                robot->rt_interface_->robot_state_->getITarget(contactExpected);
+                robot->rt_interface_->robot_state_->getIActual(contactMeasured);
+            }
             robot->rt_interface_->robot_state_->setControllerUpdated();
             
-            if(bMoveWithPos){
+            if(stateBus){
+                stateBus->publish(jointsRaw.getBack(), tool);
+                pollStateBus();
+            }
+            if(stateServer){
+                stateServer->push(jointsRaw.getBack());
+            }
+            
+            if(contactDetector && contactDetector->update(contactExpected.data(), contactMeasured.data(), sampleTime)){
+                if(!bContactStopped){
+                    RA_TRACE_SCOPE("ur.send");
+                    robot->setSpeed(0, 0, 0, 0, 0, 0, contactDetector->getStopAcceleration());
+                    bContactStopped = true;
+                    RA_LOG_WARNING("URDriver", "contact on joint %d, stopping", contactDetector->getTriggeredJoint());
+                }
+            }else{
+                bContactStopped = false;
+            }
+            
+            if(bContactStopped){
+                // held until the detector is reset, new moves are dropped and
+                // the old target isn't eased back into
+                bMove = false;
+                deccelCount = 0;
+            }else if(velocityControl){
+                velocityControl->update(jointsRaw.getBack(), velocitySpeeds);
+                RA_TRACE_SCOPE("ur.send");
+                robot->setSpeed(velocitySpeeds[0], velocitySpeeds[1], velocitySpeeds[2], velocitySpeeds[3], velocitySpeeds[4], velocitySpeeds[5], velocityControl->getAcceleration());
+            }else if(bVelocityStop){
+                robot->setSpeed(0, 0, 0, 0, 0, 0, ofDegToRad(timing.maxJointAccel));
+                bVelocityStop = false;
+            }else if(bMoveWithPos){
                 //if we aren't moving but deccelCount isn't 0 lets deccelerate 
                 if( (bMove && currentPosition.size()>0)|| (currentPosition.size()>0 && deccelCount>0) ){
-                    timeNow = ofGetElapsedTimef();
-                    if( bMove || timeNow-lastTimeSentMove >= 1.0/60.0){
-                        currentPosition = getAchievablePosition(currentPosition);
+                    timeNow = simclock::nowSeconds();
+                    if( bMove || timeNow-lastTimeSentMove >= 1.0/timing.commandRate){
+                        makeAchievable(currentPosition);
+                        RA_TRACE_SCOPE("ur.send");
                         robot->setPosition(currentPosition[0], currentPosition[1], currentPosition[2], currentPosition[3], currentPosition[4], currentPosition[5]);
                         if(!bMove){
                             deccelCount--;
@@ -36,11 +36,12 @@ public:
     vector<double>  getInitPose();
     bool isDataReady();
     float getThreadFPS();
-    bool bDataReady;
-    bool bStarted;
+    bool supportsVelocityControl(){ return true; }
+    bool supportsContactDetection(){ return true; }
 
     void setSpeed(vector<double> speeds, double acceleration = 100.0);
     void setPose(vector<double> positions);
+    void setTimingProfile(const TimingProfile & profile);
     
     ofxRobotArm::Pose getToolPose();
     // Robot Arm
@@ -56,42 +57,16 @@ public:
     string base_frame_;
     string tool_frame_;
     bool use_ros_control_;
-    bool bTryReconnect=true;
     std::thread* ros_control_thread_;
-    vector<double> currentSpeed;
+    // motion state (bMove, currentSpeed, currentPoseRadian, ...) is RobotDriver's,
+    // so makeAchievable limits against what this driver receives
     vector<double> currentPosition;
-    vector<double> targetPose;
-    vector<double> calculatedSpeed;
-    vector<double> currentRobotPositionRadians;
-
-    double acceleration;
-
-    RateTimer timer;
-    float epslion = 0.00000000000000001;
-    float lastTimeSentMove = -1;
-    float timeNow = 0;
     deque<vector<double> > posBuffer;
-    deque<vector<double> > speedBuffers;
-
 
-    bool bMove;
-    bool bTeachModeEnabled;
-    
     Synchronized<vector<double> > jointsProcessed;
     Synchronized<vector<double> > jointsRaw;
     Synchronized<vector<double> > toolPointRaw;
-    ofxRobotArm::Pose tool;
-    ofxRobotArm::Pose dtoolPoint;
     vector<ofxRobotArm::Pose> joints;
-    
-
-    bool bTriedOnce = false;
-    bool bMoveWithPos = false;
-    bool bMoveWithSpeed = false;
-    bool bStop = true;
-    float acceleratePct = 0.0;
-    int deccelCount = 0;
-    int numDeccelSteps = 60;
 
 };
 }
@@ -1,4 +1,8 @@
 #include "XARMDriver.h"
+#include "ContactDetector.h"
+#include "SimClock.h"
+#include "Trace.h"
+#include "AsyncLog.h"
 using namespace ofxRobotArm;
 XARMDriver::XARMDriver(){
 
@@ -16,11 +20,15 @@ XARMDriver::XARMDriver(RobotType type){
     poseProcessed.setup(foo);
     poseRaw.getBack().assign(numJoints, 0.0001);
     poseProcessed.getBack().assign(numJoints, 0.0001);
+    // sized up front, the driver thread only copies into them
+    currentPoseRadian.assign(numJoints, 0.0001);
+    calculatedSpeed.assign(numJoints, 0.0);
+    currentSpeed.assign(numJoints, 0.0);
     toolPoseRaw.getBack().assign(numJoints, 0.0001);
-    numDeccelSteps = 120;
+    setTimingProfile(TimingProfile::getDefault(type));
 }
 XARMDriver::~XARMDriver(){
-
+    disconnect();
 }
 void XARMDriver::setAllowReconnect(bool bDoReconnect) {
 
@@ -32,26 +40,110 @@ void XARMDriver::setup(string ipAddress, int port, double minPayload , double ma
 
 }
 void XARMDriver::setup(string ipAddress, double minPayload , double maxPayload ) {
-    robot = new XArmAPI(ipAddress);
+    // the rest of ofxRobotArm works in radians
+    robot = new XArmAPI(ipAddress, true);
     robot->connect();
-    robot->set_mode(0);
-    robot->set_state(0);
     robot->motion_enable(true);
+    robot->set_mode(bServoMode ? 1 : 0);
+    robot->set_state(0);
+    robot->register_report_frame_callback(&XARMDriver::onReportFrame, this);
+}
+void XARMDriver::setServoMode(bool enabled){
+    bServoMode = enabled;
+    if(robot){
+        robot->set_mode(bServoMode ? 1 : 0);
+        robot->set_state(0);
+    }
+}
+void XARMDriver::onReportFrame(const XArmReportFrame *frame, void *arg){
+    // report thread, keep it short
+    RA_TRACE_SCOPE("xarm.receive");
+    XARMDriver * driver = (XARMDriver *)arg;
+    uint64_t now = simclock::nowMicros();
+    // the report has no timestamp of its own, the tick looks this up by seq
+    FrameStamp & stamp = driver->frameStamps[frame->seq % NUM_FRAME_STAMPS];
+    stamp.seq = 0;
+    stamp.micros = now;
+    stamp.seq = frame->seq;
+    // not the driver thread, takes what onAttachmentsSynced published, never lock()
+    driver->framesEntered.fetch_add(1);
+    TrajectoryRecorder * recorder = driver->frameRecorder.load();
+    StateBus * stateBus = driver->frameStateBus.load();
+    StateServer * stateServer = driver->frameStateServer.load();
+    if(recorder || stateBus || stateServer){
+        double joints[7];
+        for(int i = 0; i < 7; i++){
+            joints[i] = frame->angle[i];
+        }
+        if(recorder){
+            recorder->addSample(now, joints, driver->numJoints);
+        }
+        if(stateBus){
+            stateBus->publish(joints, driver->numJoints);
+        }
+        if(stateServer){
+            stateServer->push(joints, driver->numJoints);
+        }
+    }
+    driver->framesDone.fetch_add(1);
+}
+void XARMDriver::onAttachmentsSynced(){
+    frameRecorder = recorder;
+    frameStateBus = stateBus;
+    frameStateServer = stateServer;
+    waitForFrame();
+}
+void XARMDriver::waitForFrame(){
+    // a frame that started before now may still hold the old pointers
+    uint64_t entered = framesEntered.load();
+    while(framesDone.load() < entered){
+        std::this_thread::yield();
+    }
+}
+double XARMDriver::getReceiptTime(unsigned long long seq){
+    const FrameStamp & stamp = frameStamps[seq % NUM_FRAME_STAMPS];
+    if(stamp.seq == seq){
+        uint64_t micros = stamp.micros;
+        // still the same frame's, onReportFrame clears seq before it rewrites a slot
+        if(stamp.seq == seq){
+            return micros * 1e-6;
+        }
+    }
+    return simclock::nowSeconds();
 }
 void XARMDriver::setup(int port, double minPayload , double maxPayload ) {
 
 }
 void XARMDriver::start() {
-
+    if(!robot){
+        ofLogError("XARMDriver") << "start: call setup with the arm's address first";
+        return;
+    }
+    if(!isThreadRunning()){
+        startThread();
+    }
 }
 bool  XARMDriver::isConnected() {
     return false;
 }
 void XARMDriver::disconnect() {
-
+    // the driver thread sends on robot, stop it first
+    stopThread();
+    if(robot){
+        // returns once onReportFrame isn't running
+        robot->release_report_frame_callback(&XARMDriver::onReportFrame, this);
+        robot->disconnect();
+        delete robot;
+        robot = nullptr;
+    }
 }
 void XARMDriver::stopThread() {
-
+    if(isThreadRunning()){
+        ofThread::stopThread();
+        if(!isCurrentThread()){
+            waitForThread(false);
+        }
+    }
 }
 void XARMDriver::toggleTeachMode() {
 
@@ -67,46 +159,88 @@ vector<double> XARMDriver::getInitPose(){
     return ret;
 }
 void XARMDriver::threadedFunction() {
+    RA_TRACE_THREAD_NAME("XARMDriver");
+    auto nextTick = std::chrono::steady_clock::now();
     while(isThreadRunning()){
+        // paced at the profile's control rate instead of spinning on the report stream
+        auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / timing.controlRate));
+        nextTick += period;
+        auto now = std::chrono::steady_clock::now();
+        if(nextTick < now){
+            nextTick = now;
+        }else{
+            std::this_thread::sleep_until(nextTick);
+        }
+        syncAttachments();
+        memory::TickScope tick;
         int ret;
-        unsigned char version[40];
-        ret = robot->get_version(version);
-//        printf("ret=%d, version: %s\n", ret, version);
-
-        int state;
-        ret = robot->get_state(&state);
-//        printf("ret=%d, state: %d, mode: %d\n", ret, state, robot->mode);
-
-        int cmdnum;
-        ret = robot->get_cmdnum(&cmdnum);
-//        printf("ret=%d, cmdnum: %d\n", ret, cmdnum);
-
-        int err_warn[2];
-        ret = robot->get_err_warn_code(err_warn);
-//        printf("ret=%d, err: %d, warn: %d\n", ret, err_warn[0], err_warn[1]);
-
-        fp32 pose[6];
-        ret = robot->get_position(pose);
-//        printf("ret=%d, ", ret);
-//        print_nvect("pose: ", pose, 6);
-
-        fp32 angles[7];
-        ret = robot->get_servo_angle(angles);
-//        printf("ret=%d, ", ret);
-//        print_nvect("angles: ", angles, 7);
+        pollStateBus();
+        // state, pose and joints come from the report stream, no request round trip needed
+        XArmReportFrame report;
+        {
+            RA_TRACE_SCOPE("xarm.decode");
+            ret = robot->get_report_frame(&report);
+        }
+        if(ret == 0 && report.seq != lastReportSeq){
+            lastReportSeq = report.seq;
+            double receiptTime = getReceiptTime(report.seq);
+            for(int i = 0; i < numJoints && i < 7; i++){
+                poseRaw.getBack()[i] = report.angle[i];
+            }
+            currentPoseRadian = poseRaw.getBack();
+            updateJointState(poseRaw.getBack(), receiptTime);
+            poseRaw.swapBack();
+            if(contactDetector){
+                // the report streams the joint torques, no get_joint_tau round trip
+                double q[7];
+                double tau[7];
+                for(int i = 0; i < 7; i++){
+                    q[i] = report.angle[i];
+                    tau[i] = report.tau[i];
+                }
+                contactDetector->updateModel(q, tau, receiptTime);
+            }
+        }else if(ret != 0){
+            RA_LOG_WARNING("XARMDriver", "get_report_frame, ret=%d", ret);
+        }
         
-        if(bMove && currentPose.size() > 0){
-            timeNow = ofGetElapsedTimef();
-            if( bMove || timeNow-lastTimeSentMove >= 1.0/60.0){
-                currentPose = getAchievablePosition(currentPose);
-                fp32 pose[currentPose.size()];
-                int i = 0;
-                for(auto angle : currentPose){
-                    pose[i] = angle;
-                    i++;
+        if(contactDetector && contactDetector->isTriggered()){
+            if(!bContactStopped){
+                // state 4 stops the motion and clears the queue, a request is fine this once
+                memory::HeapAllowed allow;
+                RA_TRACE_SCOPE("xarm.send");
+                robot->set_state(4);
+                bContactStopped = true;
+                RA_LOG_WARNING("XARMDriver", "contact on joint %d, stopping", contactDetector->getTriggeredJoint());
+            }
+        }else if(bContactStopped){
+            memory::HeapAllowed allow;
+            robot->set_mode(bServoMode ? 1 : 0);
+            robot->set_state(0);
+            bContactStopped = false;
+        }
+        if(bContactStopped){
+            // held until the detector is reset, new moves are dropped
+            bMove = false;
+            deccelCount = 0;
+        }else if( (bMove && currentPose.size()>0) || (currentPose.size()>0 && deccelCount>0) ){
+            //if we aren't moving but deccelCount isn't 0 lets deccelerate
+            timeNow = simclock::nowSeconds();
+            if( bMove || timeNow-lastTimeSentMove >= 1.0/timing.commandRate){
+                makeAchievable(currentPose);
+                fp32 pose[7] = {0};
+                for(int i = 0; i < (int)currentPose.size() && i < 7; i++){
+                    pose[i] = currentPose[i];
+                }
+                RA_TRACE_SCOPE("xarm.send");
+                if(bServoMode){
+                    ret = robot->set_servo_angle_j(pose);
+                }else{
+                    ret = robot->set_servo_angle(pose, false);
+                }
+                if(ret != 0){
+                    RA_LOG_WARNING("XARMDriver", "set_servo_angle, ret=%d", ret);
                 }
-                ret = robot->set_servo_angle(pose, false);
-                printf("set_servo_angle, ret=%d\n", ret);
                 if(!bMove){
                     deccelCount--;
                     if( deccelCount < 0){
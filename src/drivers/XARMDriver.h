@@ -23,8 +23,35 @@ namespace ofxRobotArm
          void setTeachMode(bool enabled) ;
          void threadedFunction() ;
         vector<double> getInitPose();
+        bool supportsContactDetection(){ return true; }
+        /// \brief stream poses with set_servo_angle_j (mode 1) instead of queued moves
+        void setServoMode(bool enabled);
         
         // Robot Arm
-        XArmAPI *robot;
+        XArmAPI *robot = nullptr;
+    protected:
+        static void onReportFrame(const XArmReportFrame *frame, void *arg);
+        /// \brief hands recorder, stateBus and stateServer on to the report thread
+        void onAttachmentsSynced();
+        /// \brief returns once no report frame from before the call is running
+        void waitForFrame();
+        /// \brief s, when frame seq was received, the poll time if it's no longer known
+        double getReceiptTime(unsigned long long seq);
+
+        /// \brief receipt time of a recent frame, written by onReportFrame
+        struct FrameStamp{
+            std::atomic<unsigned long long> seq{0};
+            std::atomic<uint64_t> micros{0};
+        };
+        static const int NUM_FRAME_STAMPS = 8;
+        FrameStamp frameStamps[NUM_FRAME_STAMPS];
+        unsigned long long lastReportSeq = 0;
+        // the report thread's copies, written by onAttachmentsSynced
+        std::atomic<TrajectoryRecorder *> frameRecorder{nullptr};
+        std::atomic<StateBus *> frameStateBus{nullptr};
+        std::atomic<StateServer *> frameStateServer{nullptr};
+        std::atomic<uint64_t> framesEntered{0};
+        std::atomic<uint64_t> framesDone{0};
+        bool bServoMode = false;
     };
 }
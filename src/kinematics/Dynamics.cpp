@@ -0,0 +1,344 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "Dynamics.h"
+#include "Trace.h"
+#include <type_traits>
+
+using namespace ofxRobotArm;
+using math::Mat3d;
+using math::Vec3d;
+
+namespace{
+    Mat3d add(const Mat3d & a, const Mat3d & b){
+        Mat3d r;
+        for(int i = 0; i < 9; i++){
+            r.m[i] = a.m[i] + b.m[i];
+        }
+        return r;
+    }
+
+    /// [v]x, the cross product as a matrix
+    Mat3d skew(const Vec3d & v){
+        return Mat3d(0, -v.z, v.y,
+                     v.z, 0, -v.x,
+                     -v.y, v.x, 0);
+    }
+
+    Mat3d scale(const Mat3d & a, double s){
+        Mat3d r;
+        for(int i = 0; i < 9; i++){
+            r.m[i] = a.m[i] * s;
+        }
+        return r;
+    }
+
+    /// adds a body of mass, center com and inertia about com, all in a frame placed at pose
+    void addInertia(Dynamics::Body & body, const math::Transformd & pose, double mass, const Vec3d & com, const Mat3d & inertia){
+        if(mass <= 0){
+            return;
+        }
+        Vec3d c = pose.transformPoint(com);
+        Mat3d r = Mat3d::fromQuat(pose.rotation);
+        // parallel axis: I_O = R I_c R^T - m [c]x [c]x
+        Mat3d shifted = scale(skew(c) * skew(c), -mass);
+        body.inertia = add(body.inertia, add(r * inertia * r.transposed(), shifted));
+        body.firstMoment += c * mass;
+        body.mass += mass;
+    }
+
+    /// each body's frame in its parent's at q
+    template<int N>
+    void frames(const Dynamics::Body * bodies, const double * q, Mat3d * rotation, Vec3d * translation){
+        for(int i = 0; i < N; i++){
+            const Dynamics::Body & b = bodies[i];
+            if(b.bPrismatic){
+                rotation[i] = b.rotation;
+                translation[i] = b.translation + b.rotation * (b.axis * q[i]);
+            }else{
+                rotation[i] = b.rotation * Mat3d::fromQuat(math::Quatd::fromAxisAngle(b.axis, q[i]));
+                translation[i] = b.translation;
+            }
+        }
+    }
+
+    /// Newton-Euler about each body's origin, gravity enters as a base acceleration.
+    /// qd and qdd may be null for zero.
+    template<int N>
+    void rnea(const Dynamics::Body * bodies, const Vec3d & gravity, const double * q, const double * qd, const double * qdd, double * tau){
+        Mat3d rotation[N];
+        Vec3d translation[N];
+        Vec3d w[N], dw[N], a[N];
+        frames<N>(bodies, q, rotation, translation);
+
+        Vec3d parentW, parentDw, parentA = -gravity;
+        for(int i = 0; i < N; i++){
+            const Dynamics::Body & b = bodies[i];
+            Mat3d e = rotation[i].transposed();
+            const Vec3d & p = translation[i];
+            double v = qd ? qd[i] : 0;
+            double acc = qdd ? qdd[i] : 0;
+            Vec3d inherited = e * parentW;
+            a[i] = e * (parentA + parentDw.cross(p) + parentW.cross(parentW.cross(p)));
+            if(b.bPrismatic){
+                w[i] = inherited;
+                dw[i] = e * parentDw;
+                a[i] += w[i].cross(b.axis * (2 * v)) + b.axis * acc;
+            }else{
+                w[i] = inherited + b.axis * v;
+                dw[i] = e * parentDw + b.axis * acc + inherited.cross(b.axis * v);
+            }
+            parentW = w[i];
+            parentDw = dw[i];
+            parentA = a[i];
+        }
+
+        Vec3d childF, childN;
+        for(int i = N - 1; i >= 0; i--){
+            const Dynamics::Body & b = bodies[i];
+            const Vec3d & h = b.firstMoment;
+            Vec3d f = a[i] * b.mass + dw[i].cross(h) + w[i].cross(w[i].cross(h));
+            Vec3d n = b.inertia * dw[i] + w[i].cross(b.inertia * w[i]) + h.cross(a[i]);
+            if(i + 1 < N){
+                Vec3d fc = rotation[i + 1] * childF;
+                f += fc;
+                n += rotation[i + 1] * childN + translation[i + 1].cross(fc);
+            }
+            tau[i] = b.bPrismatic ? f.dot(b.axis) : n.dot(b.axis);
+            childF = f;
+            childN = n;
+        }
+    }
+
+    /// composite rigid body algorithm, mass is row-major N x N
+    template<int N>
+    void crba(const Dynamics::Body * bodies, const double * q, double * mass){
+        Mat3d rotation[N];
+        Vec3d translation[N];
+        frames<N>(bodies, q, rotation, translation);
+
+        // composite inertia of each body and everything after it, in its own frame
+        double m[N];
+        Vec3d h[N];
+        Mat3d inertia[N];
+        for(int i = 0; i < N; i++){
+            m[i] = bodies[i].mass;
+            h[i] = bodies[i].firstMoment;
+            inertia[i] = bodies[i].inertia;
+        }
+        for(int i = N - 1; i > 0; i--){
+            const Mat3d & r = rotation[i];
+            const Vec3d & p = translation[i];
+            Vec3d rh = r * h[i];
+            // I_O' = R I_O R^T - m [p]x [p]x - [p]x [Rh]x - [Rh]x [p]x
+            Mat3d shifted = add(scale(skew(p) * skew(p), -m[i]), scale(add(skew(p) * skew(rh), skew(rh) * skew(p)), -1));
+            inertia[i - 1] = add(inertia[i - 1], add(r * inertia[i] * r.transposed(), shifted));
+            h[i - 1] += rh + p * m[i];
+            m[i - 1] += m[i];
+        }
+
+        for(int i = 0; i < N; i++){
+            // force and moment about the origin for a unit acceleration of joint i
+            const Vec3d & axis = bodies[i].axis;
+            Vec3d f, n;
+            if(bodies[i].bPrismatic){
+                f = axis * m[i];
+                n = h[i].cross(axis);
+            }else{
+                f = axis.cross(h[i]);
+                n = inertia[i] * axis;
+            }
+            mass[i * N + i] = bodies[i].bPrismatic ? f.dot(axis) : n.dot(axis);
+            for(int j = i; j > 0; j--){
+                f = rotation[j] * f;
+                n = rotation[j] * n + translation[j].cross(f);
+                const Dynamics::Body & parent = bodies[j - 1];
+                double value = parent.bPrismatic ? f.dot(parent.axis) : n.dot(parent.axis);
+                mass[i * N + j - 1] = value;
+                mass[(j - 1) * N + i] = value;
+            }
+        }
+    }
+
+    template<class F>
+    void dispatch(int n, F && f){
+        switch(n){
+            case 1: f(std::integral_constant<int, 1>()); break;
+            case 2: f(std::integral_constant<int, 2>()); break;
+            case 3: f(std::integral_constant<int, 3>()); break;
+            case 4: f(std::integral_constant<int, 4>()); break;
+            case 5: f(std::integral_constant<int, 5>()); break;
+            case 6: f(std::integral_constant<int, 6>()); break;
+            case 7: f(std::integral_constant<int, 7>()); break;
+            case 8: f(std::integral_constant<int, 8>()); break;
+            default: break;
+        }
+    }
+}
+
+Dynamics::Dynamics(){
+}
+
+Dynamics::~Dynamics(){
+}
+
+bool Dynamics::setup(const KinematicChain * chain){
+    this->chain = nullptr;
+    numJoints = 0;
+    chainBodies.clear();
+    bodies.clear();
+    if(!chain || !chain->isLoaded()){
+        ofLogError("Dynamics") << "setup: no chain";
+        return false;
+    }
+    if(chain->getNumJoints() > MAX_JOINTS){
+        ofLogError("Dynamics") << "setup: " << chain->getNumJoints() << " joints, supports up to " << MAX_JOINTS;
+        return false;
+    }
+
+    // links behind fixed joints ride on the body before them, links before the first joint don't move
+    chainBodies.reserve(chain->getNumJoints());
+    math::Transformd fixed;
+    double total = 0;
+    for(const auto & joint : chain->getJoints()){
+        fixed = fixed * joint.origin;
+        if(joint.index < 0){
+            if(!chainBodies.empty()){
+                addInertia(chainBodies.back(), fixed, joint.mass, joint.com, joint.inertia);
+                total += joint.mass;
+            }
+            continue;
+        }
+        Body body;
+        body.rotation = Mat3d::fromQuat(fixed.rotation);
+        body.translation = fixed.translation;
+        body.axis = joint.axis;
+        body.bPrismatic = joint.type == KinematicChain::PRISMATIC;
+        addInertia(body, math::Transformd(), joint.mass, joint.com, joint.inertia);
+        total += joint.mass;
+        chainBodies.push_back(body);
+        fixed = math::Transformd();
+    }
+    tipFrame = fixed;
+    if(total <= 0){
+        ofLogWarning("Dynamics") << "the URDF has no link masses, every torque will be zero";
+    }
+
+    this->chain = chain;
+    numJoints = chainBodies.size();
+    updateBodies();
+    return true;
+}
+
+bool Dynamics::isSetup() const{
+    return chain && numJoints > 0;
+}
+
+int Dynamics::getNumJoints() const{
+    return numJoints;
+}
+
+void Dynamics::setGravity(const math::Vec3d & gravity){
+    gravityVector = gravity;
+}
+
+void Dynamics::setPayload(double mass, const math::Vec3d & com){
+    payloadMass = mass;
+    payloadCom = com;
+    updateBodies();
+}
+
+void Dynamics::updateBodies(){
+    bodies = chainBodies;
+    if(!bodies.empty() && payloadMass > 0){
+        addInertia(bodies.back(), tipFrame, payloadMass, payloadCom, Mat3d(0, 0, 0, 0, 0, 0, 0, 0, 0));
+    }
+}
+
+void Dynamics::inverseDynamics(const double * q, const double * qd, const double * qdd, double * tau) const{
+    dispatch(numJoints, [&](auto n){
+        rnea<decltype(n)::value>(bodies.data(), gravityVector, q, qd, qdd, tau);
+    });
+}
+
+void Dynamics::gravity(const double * q, double * tau) const{
+    dispatch(numJoints, [&](auto n){
+        rnea<decltype(n)::value>(bodies.data(), gravityVector, q, nullptr, nullptr, tau);
+    });
+}
+
+void Dynamics::massMatrix(const double * q, double * mass) const{
+    dispatch(numJoints, [&](auto n){
+        crba<decltype(n)::value>(bodies.data(), q, mass);
+    });
+}
+
+vector<double> Dynamics::inverseDynamics(const vector<double> & q, const vector<double> & qd, const vector<double> & qdd) const{
+    vector<double> tau(numJoints, 0);
+    if((int)q.size() < numJoints || (int)qd.size() < numJoints || (int)qdd.size() < numJoints){
+        ofLogError("Dynamics") << "inverseDynamics: needs " << numJoints << " joints";
+        return tau;
+    }
+    inverseDynamics(q.data(), qd.data(), qdd.data(), tau.data());
+    return tau;
+}
+
+vector<double> Dynamics::gravity(const vector<double> & q) const{
+    vector<double> tau(numJoints, 0);
+    if((int)q.size() < numJoints){
+        ofLogError("Dynamics") << "gravity: needs " << numJoints << " joints";
+        return tau;
+    }
+    gravity(q.data(), tau.data());
+    return tau;
+}
+
+double Dynamics::getTimeScale(const JointTrajectory & trajectory, const vector<double> & effortLimits) const{
+    RA_TRACE_SCOPE("dynamics.timescale");
+    vector<double> limits = effortLimits;
+    if(limits.empty() && chain){
+        chain->getEffortLimits(limits);
+    }
+    if((int)limits.size() < numJoints || trajectory.getNumJoints() < numJoints){
+        ofLogError("Dynamics") << "getTimeScale: needs " << numJoints << " joints and effort limits";
+        return 1.0;
+    }
+
+    // stretching time by k divides velocities by k and accelerations by k^2, so
+    // tau(k) = g + (tau - g) / k^2 and each sample bounds k^2 from below
+    double scale2 = 0;
+    vector<double> previous, current, next;
+    double qd[MAX_JOINTS], qdd[MAX_JOINTS], tau[MAX_JOINTS], g[MAX_JOINTS];
+    for(size_t i = 1; i + 1 < trajectory.size(); i++){
+        double t0 = trajectory.getTime(i - 1);
+        double t1 = trajectory.getTime(i);
+        double t2 = trajectory.getTime(i + 1);
+        double dt1 = t1 - t0;
+        double dt2 = t2 - t1;
+        if(dt1 <= 0 || dt2 <= 0){
+            continue;
+        }
+        trajectory.getPoseAt(t0, previous);
+        trajectory.getPoseAt(t1, current);
+        trajectory.getPoseAt(t2, next);
+        for(int j = 0; j < numJoints; j++){
+            qd[j] = (next[j] - previous[j]) / (dt1 + dt2);
+            qdd[j] = 2 * ((next[j] - current[j]) / dt2 - (current[j] - previous[j]) / dt1) / (dt1 + dt2);
+        }
+        inverseDynamics(current.data(), qd, qdd, tau);
+        gravity(current.data(), g);
+        for(int j = 0; j < numJoints; j++){
+            if(limits[j] <= 0){
+                continue;
+            }
+            if(fabs(g[j]) >= limits[j]){
+                ofLogError("Dynamics") << "getTimeScale: joint " << j << " needs " << fabs(g[j]) << " to hold against gravity at " << t1 << " s, the limit is " << limits[j];
+                return -1;
+            }
+            double d = tau[j] - g[j];
+            double room = d > 0 ? limits[j] - g[j] : limits[j] + g[j];
+            scale2 = MAX(scale2, fabs(d) / room);
+        }
+    }
+    return sqrt(scale2);
+}
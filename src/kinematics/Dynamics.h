@@ -0,0 +1,86 @@
+//
+//  Dynamics.h
+//  ofxRobotArm
+//
+//  Rigid body dynamics of a KinematicChain from the URDF link inertials.
+//  Recursive Newton-Euler gives the inverse dynamics and the gravity
+//  torques, and the composite rigid body algorithm gives the mass matrix.
+//
+//  The kernels are templated on the number of joints (up to MAX_JOINTS),
+//  so the loops unroll and everything stays on the stack. They don't
+//  allocate and can run on the driver thread at control rate.
+//
+//  Joint values are radians (or meters for prismatic joints), torques are
+//  Nm (or N), and gravity is in the chain's base frame.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "KinematicChain.h"
+#include "JointTrajectory.h"
+#include "RobotMath.h"
+
+namespace ofxRobotArm{
+    class Dynamics{
+    public:
+        static const int MAX_JOINTS = 8;
+
+        /// \brief a moving joint and everything rigidly attached after it
+        struct Body{
+            /// \brief previous body's frame to this joint's frame, at zero
+            math::Mat3d rotation;
+            math::Vec3d translation;
+            math::Vec3d axis;
+            bool bPrismatic = false;
+            double mass = 0;
+            /// \brief mass times center of mass, in the body frame
+            math::Vec3d firstMoment;
+            /// \brief about the body frame origin
+            math::Mat3d inertia = math::Mat3d(0, 0, 0, 0, 0, 0, 0, 0, 0);
+        };
+
+        Dynamics();
+        ~Dynamics();
+
+        /// \brief chain has to outlive the dynamics, false past MAX_JOINTS
+        bool setup(const KinematicChain * chain);
+        bool isSetup() const;
+        int getNumJoints() const;
+
+        /// \brief defaults to (0, 0, -9.81), change it for a wall or ceiling mount
+        void setGravity(const math::Vec3d & gravity);
+        /// \brief a point mass at com in the tip frame, 0 to remove it
+        void setPayload(double mass, const math::Vec3d & com = math::Vec3d());
+
+        /// \brief tau = M(q) qdd + C(q, qd) qd + g(q)
+        void inverseDynamics(const double * q, const double * qd, const double * qdd, double * tau) const;
+        /// \brief the torques holding the arm still at q
+        void gravity(const double * q, double * tau) const;
+        /// \brief row-major numJoints x numJoints
+        void massMatrix(const double * q, double * mass) const;
+
+        vector<double> inverseDynamics(const vector<double> & q, const vector<double> & qd, const vector<double> & qdd) const;
+        vector<double> gravity(const vector<double> & q) const;
+
+        /// \brief factor the trajectory's duration has to be stretched by to
+        /// keep every joint within effortLimits (the URDF efforts if empty).
+        /// Below 1 it could run faster. Play it with TrajectoryPlayer::setSpeed(1 / scale).
+        /// Returns -1 where gravity alone exceeds a limit.
+        double getTimeScale(const JointTrajectory & trajectory, const vector<double> & effortLimits = vector<double>()) const;
+
+    protected:
+        void updateBodies();
+
+        const KinematicChain * chain = nullptr;
+        int numJoints = 0;
+        math::Vec3d gravityVector = math::Vec3d(0, 0, -9.81);
+        /// \brief from the URDF, and with the payload added
+        vector<Body> chainBodies;
+        vector<Body> bodies;
+        /// \brief last joint's frame to the tip
+        math::Transformd tipFrame;
+        double payloadMass = 0;
+        math::Vec3d payloadCom;
+    };
+}
@@ -43,14 +43,15 @@ namespace ofxRobotArm {
                  std::isfinite(qs[4]) && std::isfinite(qs[5]);
         };
         
+        /// \brief wraps every angle into (-PI, PI]
         vector<double> boundSolution(vector<double> thetas)
         {
-            for (auto theta : thetas)
+            for (auto & theta : thetas)
             {
-                if (abs(theta) > PI)
+                theta = remainder(theta, TWO_PI);
+                if (theta <= -PI)
                 {
-                    double sign = abs(theta) / theta;
-                    theta = theta - (sign * TWO_PI);
+                    theta += TWO_PI;
                 }
             }
             return thetas;
@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "IKCache.h"
+#include "RobotMathOF.h"
+
+using namespace ofxRobotArm;
+
+bool IKCache::Key::operator==(const Key & k) const {
+    return memcmp(position, k.position, sizeof(position)) == 0 &&
+           memcmp(orientation, k.orientation, sizeof(orientation)) == 0 &&
+           memcmp(tool, k.tool, sizeof(tool)) == 0 &&
+           robotType == k.robotType && ikType == k.ikType && branch == k.branch;
+}
+
+size_t IKCache::KeyHash::operator()(const Key & k) const {
+    // FNV-1a over the fields one by one, so padding never counts
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h](int64_t v){
+        for(int i = 0; i < 8; i++){
+            h = (h ^ ((v >> (i * 8)) & 0xff)) * 1099511628211ULL;
+        }
+    };
+    for(int i = 0; i < 3; i++) mix(k.position[i]);
+    for(int i = 0; i < 4; i++) mix(k.orientation[i]);
+    for(int i = 0; i < 3; i++) mix(k.tool[i]);
+    mix(k.robotType);
+    mix(k.ikType);
+    mix(k.branch);
+    return h;
+}
+
+IKCache::IKCache(size_t capacity) : hits(0), misses(0), rejected(0), inserts(0), evictions(0){
+    setCapacity(capacity);
+}
+
+void IKCache::setCapacity(size_t entries){
+    shardCapacity = MAX(entries / NUM_SHARDS, (size_t)1);
+    for(auto & shard : shards){
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        while(shard.lru.size() > shardCapacity){
+            shard.map.erase(shard.lru.back().key);
+            shard.lru.pop_back();
+            evictions++;
+        }
+    }
+}
+
+void IKCache::setQuantization(double meters, double quaternion){
+    positionStep = meters;
+    orientationStep = quaternion;
+    clear();
+}
+
+void IKCache::setTolerance(double meters, double radians){
+    positionTolerance = meters;
+    orientationTolerance = radians;
+}
+
+void IKCache::setForward(std::function<math::Mat4d(const vector<double> &)> forward){
+    this->forward = forward;
+}
+
+IKCache::Key IKCache::makeKey(const Pose & target, RobotType robotType, IKType ikType, const ofVec3f & tool, int branch) const {
+    Key key;
+    memset(&key, 0, sizeof(key));
+    math::Quatd q = math::toMath(target.orientation).normalized();
+    // q and -q are the same rotation
+    double sign = q.w < 0 ? -1 : 1;
+    double orientation[4] = {q.x * sign, q.y * sign, q.z * sign, q.w * sign};
+    for(int i = 0; i < 3; i++){
+        key.position[i] = llround(target.position[i] / positionStep);
+        key.tool[i] = llround(tool[i] / positionStep);
+    }
+    for(int i = 0; i < 4; i++){
+        key.orientation[i] = llround(orientation[i] / orientationStep);
+    }
+    key.robotType = robotType;
+    key.ikType = ikType;
+    key.branch = branch;
+    return key;
+}
+
+IKCache::Shard & IKCache::getShard(const Key & key){
+    // the low bits go to the unordered_map, shard on the high ones
+    return shards[(KeyHash()(key) >> 48) % NUM_SHARDS];
+}
+
+bool IKCache::verify(const vector<double> & q, const Pose & target){
+    if(!forward || q.empty()){
+        return false;
+    }
+    math::Transformd reached = math::Transformd::fromMatrix(forward(q));
+    math::Transformd wanted = math::toMath(target);
+    return (reached.translation - wanted.translation).length() <= positionTolerance &&
+           reached.rotation.angleTo(wanted.rotation.normalized()) <= orientationTolerance;
+}
+
+bool IKCache::find(const Key & key, const Pose & target, vector<vector<double>> & sols){
+    Shard & shard = getShard(key);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.map.find(key);
+        if(it == shard.map.end()){
+            misses++;
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        sols = it->second->sols;
+    }
+    if(sols.empty() || !verify(sols[0], target)){
+        rejected++;
+        misses++;
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+bool IKCache::insert(const Key & key, const Pose & target, const vector<vector<double>> & sols){
+    if(sols.empty() || !verify(sols[0], target)){
+        return false;
+    }
+    Shard & shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(key);
+    if(it != shard.map.end()){
+        it->second->sols = sols;
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return true;
+    }
+    shard.lru.push_front(Entry{key, sols});
+    shard.map[key] = shard.lru.begin();
+    inserts++;
+    while(shard.lru.size() > shardCapacity){
+        shard.map.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+        evictions++;
+    }
+    return true;
+}
+
+void IKCache::clear(){
+    for(auto & shard : shards){
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.map.clear();
+        shard.lru.clear();
+    }
+}
+
+IKCache::Stats IKCache::getStats(){
+    Stats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.rejected = rejected;
+    stats.inserts = inserts;
+    stats.evictions = evictions;
+    for(auto & shard : shards){
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.size += shard.lru.size();
+    }
+    return stats;
+}
+
+void IKCache::resetStats(){
+    hits = 0;
+    misses = 0;
+    rejected = 0;
+    inserts = 0;
+    evictions = 0;
+}
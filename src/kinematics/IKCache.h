@@ -0,0 +1,108 @@
+//
+//  IKCache.h
+//  ofxRobotArm
+//
+//  Remembers IK results for targets that come back, as in teach and repeat
+//  or palletizing jobs. Entries are keyed by the target pose quantized to a
+//  grid, the robot and solver, the tool offset and a caller chosen branch.
+//  A hit is only returned after forward kinematics confirms the cached
+//  solution reaches the requested (unquantized) target, and results are
+//  only stored if they reach theirs, so a RelaxedIK result that hasn't
+//  converged yet never gets in.
+//
+//  The map is split into shards with a lock and an LRU list each, so
+//  several threads can look up at once and memory stays bounded.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "Pose.h"
+#include "RobotMath.h"
+#include "RobotConstants.hpp"
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
+namespace ofxRobotArm{
+    class IKCache{
+    public:
+        struct Key{
+            int64_t position[3];
+            int64_t orientation[4];
+            int64_t tool[3];
+            int32_t robotType;
+            int32_t ikType;
+            int32_t branch;
+
+            bool operator==(const Key & k) const;
+        };
+
+        struct KeyHash{
+            size_t operator()(const Key & k) const;
+        };
+
+        struct Stats{
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            /// \brief entries found but failing the forward kinematics check
+            uint64_t rejected = 0;
+            uint64_t inserts = 0;
+            uint64_t evictions = 0;
+            size_t size = 0;
+            double getHitRate() const { return hits + misses > 0 ? hits / double(hits + misses) : 0; }
+        };
+
+        static const int NUM_SHARDS = 16;
+
+        IKCache(size_t capacity = 4096);
+
+        /// \brief entries kept in total, the least recently used go first
+        void setCapacity(size_t entries);
+        /// \brief grid the target is snapped to for the key, meters and quaternion units
+        void setQuantization(double meters, double quaternion);
+        /// \brief how close forward kinematics of a solution has to land on the target
+        void setTolerance(double meters, double radians);
+        /// \brief forward kinematics used for the check, without one nothing is cached
+        void setForward(std::function<math::Mat4d(const vector<double> &)> forward);
+
+        Key makeKey(const Pose & target, RobotType robotType, IKType ikType, const ofVec3f & tool, int branch = 0) const;
+
+        /// \brief fills sols from a verified entry
+        bool find(const Key & key, const Pose & target, vector<vector<double>> & sols);
+        /// \brief stores sols if the first one reaches target
+        bool insert(const Key & key, const Pose & target, const vector<vector<double>> & sols);
+        bool verify(const vector<double> & q, const Pose & target);
+
+        void clear();
+        Stats getStats();
+        void resetStats();
+
+    protected:
+        struct Entry{
+            Key key;
+            vector<vector<double>> sols;
+        };
+        struct Shard{
+            std::mutex mutex;
+            std::list<Entry> lru;
+            std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> map;
+        };
+
+        Shard & getShard(const Key & key);
+
+        Shard shards[NUM_SHARDS];
+        std::atomic<size_t> shardCapacity;
+        double positionStep = 1e-5;
+        double orientationStep = 1e-5;
+        double positionTolerance = 1e-4;
+        double orientationTolerance = 1e-3;
+        std::function<math::Mat4d(const vector<double> &)> forward;
+
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> rejected;
+        std::atomic<uint64_t> inserts;
+        std::atomic<uint64_t> evictions;
+    };
+}
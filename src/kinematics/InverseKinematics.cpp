@@ -1,10 +1,14 @@
 #include "InverseKinematics.h"
+#include "Trace.h"
+#include "RobotMathOF.h"
 //
 // Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
 ////
 using namespace ofxRobotArm;
 const static double ANGLE_THRESH = ofDegToRad(30);
 const double ZERO_THRESH = 0.00000001;
+// solutions right on a limit still count as within it
+const static double LIMIT_EPSILON = 1e-9;
 
 InverseKinematics::InverseKinematics()
 {
@@ -19,33 +23,17 @@ int SIGN(double x)
     return (x > 0) - (x < 0);
 }
 
-/// \brief Converts a 4x4 matrix to a 1D array
+/// \brief Converts a 4x4 matrix to the row-major layout the solvers use
 /// \param input ofMatrix4x4 to convert
-/// \return row-major array in UR World Cords
-double*InverseKinematics::toIK(ofMatrix4x4 input)
+/// \return transform in UR World Cords
+math::Mat4d InverseKinematics::toIK(const ofMatrix4x4 & input)
 {
-    double *T = new double[16];
-    for (int i = 0; i < 4; i++)
-    {
-        T[i] = (double)input._mat[i][0];
-        T[i + (4)] = (double)input._mat[i][1];
-        T[i + (8)] = (double)input._mat[i][2];
-        T[i + (12)] = (double)input._mat[i][3];
-    }
-    return T;
+    return math::toMath(input);
 }
 
-ofMatrix4x4 InverseKinematics::toOF(double *T)
+ofMatrix4x4 InverseKinematics::toOF(const math::Mat4d & T)
 {
-    ofMatrix4x4 output;
-    for (int i = 0; i < 4; i++)
-    {
-        output._mat[i][0] = T[i];
-        output._mat[i][1] = T[i + (4)];
-        output._mat[i][2] = T[i + (8)];
-        output._mat[i][3] = T[i + (12)];
-    }
-    return output;
+    return math::toOF(T);
 }
 
 void InverseKinematics::harmonizeTowardZero(vector<double>& qs)
@@ -67,17 +55,119 @@ bool InverseKinematics::isValid(vector<double>& qs)
 
 vector<double> InverseKinematics::boundSolution(vector<double> thetas)
 {
-    for (auto theta : thetas)
+    for (auto & theta : thetas)
     {
-        if (abs(theta) > PI)
+        theta = remainder(theta, TWO_PI);
+        if (theta <= -PI)
         {
-            double sign = abs(theta) / theta;
-            theta = theta - (sign * TWO_PI);
+            theta += TWO_PI;
         }
     }
     return thetas;
 };
 
+bool InverseKinematics::getJointLimits(int joint, double & lower, double & upper)
+{
+    if (joint < (int)joint_limit_min.size() && joint < (int)joint_limit_max.size() && joint_limit_min[joint] < joint_limit_max[joint])
+    {
+        lower = ofDegToRad(joint_limit_min[joint]) - LIMIT_EPSILON;
+        upper = ofDegToRad(joint_limit_max[joint]) + LIMIT_EPSILON;
+        return true;
+    }
+    // no limits set for this robot, only the principal angle
+    lower = -PI - LIMIT_EPSILON;
+    upper = PI + LIMIT_EPSILON;
+    return false;
+}
+
+bool InverseKinematics::nearestEquivalent(int joint, double q, double seed, double & out)
+{
+    double lower, upper;
+    getJointLimits(joint, lower, upper);
+    // q + k * TWO_PI for kMin <= k <= kMax is every equivalent within the limits,
+    // the one nearest the seed is the rounded k clamped to that range
+    double kMin = ceil((lower - q) / TWO_PI);
+    double kMax = floor((upper - q) / TWO_PI);
+    if (kMin > kMax)
+    {
+        return false;
+    }
+    double k = ofClamp(round((seed - q) / TWO_PI), kMin, kMax);
+    out = q + k * TWO_PI;
+    return true;
+}
+
+double InverseKinematics::getSelectionCost(const vector<double> & from, const vector<double> & to)
+{
+    double travel = 0;
+    double time = 0;
+    for (size_t j = 0; j < from.size() && j < to.size(); j++)
+    {
+        double delta = fabs(to[j] - from[j]);
+        travel += (j < travelWeights.size() ? travelWeights[j] : 1.0) * delta;
+        if (j < maxJointSpeeds.size() && maxJointSpeeds[j] > 0)
+        {
+            time = MAX(time, delta / maxJointSpeeds[j]);
+        }
+    }
+    return travel + timeWeight * time;
+}
+
+int InverseKinematics::selectSolution(const vector<vector<double>> & sols, const vector<double> & seed, vector<double> & out)
+{
+    // the cost adds up per joint travel and takes the slowest joint's time,
+    // both are smallest when every joint takes its own nearest equivalent,
+    // so each principal solution only needs that one expansion scored
+    int best = -1;
+    double bestCost = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < sols.size(); i++)
+    {
+        const vector<double> & sol = sols[i];
+        if (sol.size() != seed.size())
+        {
+            continue;
+        }
+        candidate.resize(sol.size());
+        bool valid = true;
+        for (size_t j = 0; j < sol.size() && valid; j++)
+        {
+            valid = nearestEquivalent(j, sol[j], seed[j], candidate[j]);
+        }
+        if (!valid)
+        {
+            continue;
+        }
+        double cost = getSelectionCost(seed, candidate);
+        if (cost < bestCost)
+        {
+            best = i;
+            bestCost = cost;
+        }
+    }
+    if (best >= 0)
+    {
+        // per joint, seed[j] is read before out[j] is written, so out may be the seed
+        const vector<double> & sol = sols[best];
+        out.resize(sol.size());
+        for (size_t j = 0; j < sol.size(); j++)
+        {
+            nearestEquivalent(j, sol[j], seed[j], out[j]);
+        }
+    }
+    return best;
+}
+
+void InverseKinematics::setSelectionWeights(const vector<double> & travelWeights, double timeWeight)
+{
+    this->travelWeights = travelWeights;
+    this->timeWeight = timeWeight;
+}
+
+void InverseKinematics::setMaxJointSpeeds(const vector<double> & speeds)
+{
+    maxJointSpeeds = speeds;
+}
+
 
 
 void InverseKinematics::setup(ofxRobotArm::RobotType robotType, ofxRobotArm::IKType ikType, vector<double> pose, RobotModel * model)
@@ -111,6 +201,7 @@ void InverseKinematics::setup(ofxRobotArm::RobotType robotType, ofxRobotArm::IKT
     setIKType(ikType);
     setRelaxedPose(pose);
     initPose = pose;
+    numericSeed = pose;
     
 }
 
@@ -143,6 +234,16 @@ void InverseKinematics::setIKType(ofxRobotArm::IKType type){
 
 }
 
+bool InverseKinematics::loadChain(string urdfPath, string baseLink, string tipLink)
+{
+    if (!chain.load(urdfPath, baseLink, tipLink))
+    {
+        return false;
+    }
+    numericIK.setup(&chain);
+    return true;
+}
+
 void InverseKinematics::setRobotType(ofxRobotArm::RobotType type)
 {
     robotType = type;
@@ -317,6 +418,38 @@ void InverseKinematics::setRobotType(ofxRobotArm::RobotType type)
         joint_limit_max[5] = 400;
     }
     vector<double> pose(6.0, 0);
+
+    // rated joint speeds (deg/s), the time term of selectSolution
+    vector<double> speeds;
+    if (robotType == UR3)
+    {
+        speeds = {180, 180, 180, 360, 360, 360};
+    }
+    else if (robotType == UR5)
+    {
+        speeds = {180, 180, 180, 180, 180, 180};
+    }
+    else if (robotType == UR10)
+    {
+        speeds = {120, 120, 180, 180, 180, 180};
+    }
+    else if (robotType == IRB120)
+    {
+        speeds = {250, 250, 250, 320, 320, 420};
+    }
+    else if (robotType == IRB4600)
+    {
+        speeds = {175, 175, 175, 250, 250, 360};
+    }
+    else if (robotType == IRB6700)
+    {
+        speeds = {110, 110, 110, 190, 150, 210};
+    }
+    maxJointSpeeds.resize(speeds.size());
+    for (size_t i = 0; i < speeds.size(); i++)
+    {
+        maxJointSpeeds[i] = ofDegToRad(speeds[i]);
+    }
 }
 
 void InverseKinematics::setRelaxedPose(vector<double> pose)
@@ -324,102 +457,177 @@ void InverseKinematics::setRelaxedPose(vector<double> pose)
     relaxedIK.setInitialPose(pose);
 }
 
+void InverseKinematics::setLockstep(bool lockstep)
+{
+    bLockstep = lockstep;
+    if (bLockstep && relaxedIK.isThreadRunning())
+    {
+        relaxedIK.stop();
+        relaxedIK.waitForThread(false);
+    }
+}
+
 vector<vector<double>> InverseKinematics::inverseKinematics(Pose targetPose, Pose currentPose)
 {
+    vector<vector<double>> sols;
+    inverseKinematics(targetPose, currentPose, sols);
+    return sols;
+}
+
+void InverseKinematics::inverseKinematics(const Pose & targetPose, const Pose & currentPose, vector<vector<double>> & sols)
+{
+    if (!bCacheEnabled)
+    {
+        solve(targetPose, currentPose, sols);
+        return;
+    }
+    IKCache::Key key = cache.makeKey(targetPose, robotType, ikType, toolOffset, cacheBranch);
+    if (cache.find(key, targetPose, sols))
+    {
+        if (ikType == NUMERIC && !sols.empty())
+        {
+            // as if solved, so the next solve starts from here
+            numericSeed = sols[0];
+        }
+        if (ikType == RELAXED && !bLockstep && relaxedIK.isThreadRunning())
+        {
+            // keeps the solver warm for the next target that misses
+            relaxedIK.setPose(targetPose, currentPose);
+        }
+        return;
+    }
+    solve(targetPose, currentPose, sols);
+    cache.insert(key, targetPose, sols);
+}
+
+void InverseKinematics::setCacheEnabled(bool enabled, string urdfPath)
+{
+    bCacheEnabled = enabled;
+    if (enabled && ikType == RELAXED && !chain.isLoaded())
+    {
+        // forward() has no analytic model for the RELAXED arms, without a chain no hit would verify
+        if (urdfPath.empty() || !loadChain(urdfPath))
+        {
+            ofLogWarning("InverseKinematics") << "setCacheEnabled: no chain for forward kinematics, RELAXED results won't be cached";
+        }
+    }
+    cache.setForward([this](const vector<double> & q) { return forward(q); });
+}
+
+void InverseKinematics::setToolOffset(const ofVec3f & offset)
+{
+    toolOffset = offset;
+}
+
+void InverseKinematics::setCacheBranch(int branch)
+{
+    cacheBranch = branch;
+}
 
-    ofMatrix4x4 translate;
-    ofMatrix4x4 rotate;
-    ofMatrix4x4 mat;
+void InverseKinematics::solve(const Pose & targetPose, const Pose & currentPose, vector<vector<double>> & sols)
+{
+    RA_TRACE_SCOPE("ik.solve");
 
-    translate.makeTranslationMatrix(targetPose.position);
-    rotate.makeRotationMatrix(targetPose.orientation);
-    mat = rotate * translate;
+    math::Mat4d mat = math::toMath(targetPose).toMatrix();
 
     double q_sols[8 * 6];
-    vector<vector<double>> sols;
+    int num_sols = 0;
+    size_t count = 0;
 
     if (ikType == SW)
     {
-        int num_sols = inverseSW(mat, q_sols);
-        for (int i = 0; i < num_sols; i++)
-        {
-            vector<double> fooSol;
-            fooSol.push_back(q_sols[i * 6]);
-            fooSol.push_back(q_sols[i * 6 + 1]);
-            fooSol.push_back(q_sols[i * 6 + 2]);
-            fooSol.push_back(q_sols[i * 6 + 3]);
-            fooSol.push_back(q_sols[i * 6 + 4]);
-            fooSol.push_back(q_sols[i * 6 + 5]);
-            if (isValid(fooSol))
-            {
-                harmonizeTowardZero(fooSol);
-                sols.push_back(fooSol);
-            }
-        }
+        num_sols = inverseSW(mat, q_sols);
     }
     else if (ikType == HK)
     {
-        double *T = new double[16];
-        T = toIK(mat);
-        int num_sols = inverseHK(T, q_sols);
-        for (int i = 0; i < num_sols; i++)
+        num_sols = inverseHK(mat.data(), q_sols);
+    }
+    else if (ikType == NUMERIC)
+    {
+        // a single solution, seeded from the last one so the branch carries over
+        sols.resize(1);
+        if (!numericIK.isSetup() || !numericIK.solve(math::toMath(targetPose), numericSeed, sols[0]))
         {
-            vector<double> fooSol;
-            fooSol.push_back(q_sols[i * 6]);
-            fooSol.push_back(q_sols[i * 6 + 1]);
-            fooSol.push_back(q_sols[i * 6 + 2]);
-            fooSol.push_back(q_sols[i * 6 + 3]);
-            fooSol.push_back(q_sols[i * 6 + 4]);
-            fooSol.push_back(q_sols[i * 6 + 5]);
-            if (isValid(fooSol))
-            {
-                harmonizeTowardZero(fooSol);
-                sols.push_back(fooSol);
-            }
+            sols.clear();
+            return;
         }
+        numericSeed = sols[0];
+        return;
     }
     else if (ikType == RELAXED)
     {
+        if (bLockstep)
+        {
+            relaxedIK.setPose(targetPose, currentPose);
+            relaxedIK.solveOnce();
+            sols.resize(1);
+            sols[0] = relaxedIK.getCurrentPose();
+            return;
+        }
         if (!relaxedIK.isThreadRunning())
         {
             relaxedIK.start();
         }
         relaxedIK.setPose(targetPose, currentPose);
-        sols.push_back(relaxedIK.getCurrentPose());
+        sols.resize(1);
+        sols[0] = relaxedIK.getCurrentPose();
+        return;
     }
 
-    return sols;
+    // rows already in sols keep their capacity, so a steady number of
+    // solutions doesn't allocate from tick to tick
+    for (int i = 0; i < num_sols; i++)
+    {
+        if (count == sols.size())
+        {
+            sols.emplace_back();
+        }
+        vector<double> & sol = sols[count];
+        sol.assign(q_sols + i * 6, q_sols + i * 6 + 6);
+        if (isValid(sol))
+        {
+            harmonizeTowardZero(sol);
+            count++;
+        }
+    }
+    sols.resize(count);
 }
 
 ofMatrix4x4 InverseKinematics::forwardKinematics(vector<double> pose)
 {
+    return toOF(forward(pose));
+}
+
+math::Mat4d InverseKinematics::forward(const vector<double> & pose)
+{
+    bool bChain = chain.isLoaded() && (int)pose.size() >= chain.getNumJoints();
+    if (ikType == NUMERIC && bChain)
+    {
+        return chain.forward(pose).toMatrix();
+    }
     if (robotType == UR3 || robotType == UR5 || robotType == UR10)
     {
         return forwardHK(pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]);
     }
     if (robotType == IRB120 || robotType == IRB4600 || robotType == IRB6700)
     {
-        ofMatrix4x4 mat;
         return forwardSW(pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]);
     }
-    return ofMatrix4x4();
+    if (bChain)
+    {
+        return chain.forward(pose).toMatrix();
+    }
+    return math::Mat4d();
 }
 
 #pragma mark - HK
 
-ofMatrix4x4 InverseKinematics::forwardHK(double o, double t, double th, double f, double fi, double s)
+math::Mat4d InverseKinematics::forwardHK(double o, double t, double th, double f, double fi, double s)
 {
-
     double q[6] = {o, t, th, f, fi, s};
-    double *transform1 = new double[16];
-    double *transform2 = new double[16];
-    double *transform3 = new double[16];
-    double *transform4 = new double[16];
-    double *transform5 = new double[16];
-    double *transform6 = new double[16];
-
-    forwardHK(q, transform6);
-    return toOF(transform6);
+    math::Mat4d T;
+    forwardHK(q, T.data());
+    return T;
 }
 
 
@@ -887,9 +1095,8 @@ int InverseKinematics::inverseHK(double *T, double *q_sols, double q6_des)
 #pragma mark - SW
 
 // ----------------------------------------------------------
-ofMatrix4x4 InverseKinematics::forwardSW(double t1, double t2, double t3, double t4, double t5, double t6)
+math::Mat4d InverseKinematics::forwardSW(double t1, double t2, double t3, double t4, double t5, double t6)
 {
-    ofMatrix4x4 sol;
     double q[6];
     q[0] = t1 * sign_corrections[0] - offsets[0];
     q[1] = t2 * sign_corrections[1] - offsets[1];
@@ -923,31 +1130,28 @@ ofMatrix4x4 InverseKinematics::forwardSW(double t1, double t2, double t3, double
     double c5_2 = std::cos(q[4]);
     double c6_2 = std::cos(q[5]);
 
-    ofMatrix4x4 r_0c;
-    r_0c.set(c1_2 * c2_2 * c3_2 - c1_2 * s2 * s3, -s1, c1_2 * c2_2 * s3 + c1_2 * s2 * c3_2, 0,
-             s1 * c2_2 * c3_2 - s1 * s2 * s3, c1_2, s1 * c2_2 * s3 + s1 * s2 * c3_2, 0,
-             -s2 * c3_2 - c2_2 * s3, 0, -s2 * s3 + c2_2 * c3_2, 0,
-             0, 0, 0, 1);
+    math::Mat3d r_0c(c1_2 * c2_2 * c3_2 - c1_2 * s2 * s3, -s1, c1_2 * c2_2 * s3 + c1_2 * s2 * c3_2,
+                     s1 * c2_2 * c3_2 - s1 * s2 * s3, c1_2, s1 * c2_2 * s3 + s1 * s2 * c3_2,
+                     -s2 * c3_2 - c2_2 * s3, 0, -s2 * s3 + c2_2 * c3_2);
 
-    ofMatrix4x4 r_ce;
-    r_ce.set(c4_2 * c5_2 * c6_2 - s4 * s6, -c4_2 * c5_2 * s6 - s4 * c6_2, c4_2 * s5, 0,
-             s4 * c5_2 * c6_2 + c4_2 * s6, -s4 * c5_2 * s6 + c4_2 * c6_2, s4 * s5, 0,
-             -s5 * c6_2, s5 * s6, c5_2, 0,
-             0, 0, 0, 1);
+    math::Mat3d r_ce(c4_2 * c5_2 * c6_2 - s4 * s6, -c4_2 * c5_2 * s6 - s4 * c6_2, c4_2 * s5,
+                     s4 * c5_2 * c6_2 + c4_2 * s6, -s4 * c5_2 * s6 + c4_2 * c6_2, s4 * s5,
+                     -s5 * c6_2, s5 * s6, c5_2);
 
-    ofMatrix4x4 r_oe = r_0c * r_ce;
+    math::Mat3d r_oe = r_0c * r_ce;
 
-    ofVec3f u = ofVec3f(cx0, cy0, cz0) + r_oe * ofVec3f(0, 0, 1) * c4;
-    ofMatrix4x4 mat;
-    mat.makeTranslationMatrix(u);
-    sol = r_oe * mat;
+    math::Vec3d u = math::Vec3d(cx0, cy0, cz0) + r_oe.column(2) * c4;
 
-    return sol;
+    // the SW solver's rotation is the transpose of the transform's, see inverseSW
+    return math::Mat4d(r_oe.transposed(), u);
 }
 
-int InverseKinematics::inverseSW(ofMatrix4x4 pose, double *sol)
+int InverseKinematics::inverseSW(const math::Mat4d & T, double *sol)
 {
-    ofVec3f c = pose.getTranslation() - ofMatrix4x4::transform3x3(pose, ofVec3f(0, 0, 1)) * c4;
+    // the OPW formulation below indexes the rotation in the element order it
+    // had when this took an ofMatrix4x4, which is the transpose of T's
+    math::Mat3d pose = T.getRotation().transposed();
+    math::Vec3d c = T.getTranslation() - pose.column(2) * c4;
     double nx1 = std::sqrt(pow(c.x, 2) + pow(c.y, 2) - pow(b, 2)) - a1;
 
     // Compute theta1_i, theta1_ii
@@ -1014,22 +1218,22 @@ int InverseKinematics::inverseSW(ofMatrix4x4 pose, double *sol)
     c23[3] = std::cos(theta2_iv + theta3_iv);
 
     double m[4];
-    m[0] = get(pose, 0, 2) * s23[0] * cos1[0] + get(pose, 1, 2) * s23[0] * sin1[0] + get(pose, 2, 2) * c23[0];
-    m[1] = get(pose, 0, 2) * s23[1] * cos1[1] + get(pose, 1, 2) * s23[1] * sin1[1] + get(pose, 2, 2) * c23[1];
-    m[2] = get(pose, 0, 2) * s23[2] * cos1[2] + get(pose, 1, 2) * s23[2] * sin1[2] + get(pose, 2, 2) * c23[2];
-    m[3] = get(pose, 0, 2) * s23[3] * cos1[3] + get(pose, 1, 2) * s23[3] * sin1[3] + get(pose, 2, 2) * c23[3];
+    m[0] = pose(0, 2) * s23[0] * cos1[0] + pose(1, 2) * s23[0] * sin1[0] + pose(2, 2) * c23[0];
+    m[1] = pose(0, 2) * s23[1] * cos1[1] + pose(1, 2) * s23[1] * sin1[1] + pose(2, 2) * c23[1];
+    m[2] = pose(0, 2) * s23[2] * cos1[2] + pose(1, 2) * s23[2] * sin1[2] + pose(2, 2) * c23[2];
+    m[3] = pose(0, 2) * s23[3] * cos1[3] + pose(1, 2) * s23[3] * sin1[3] + pose(2, 2) * c23[3];
 
-    double theta4_i = std::atan2(get(pose, 1, 2) * cos1[0] - get(pose, 0, 2) * sin1[0],
-                                 get(pose, 0, 2) * c23[0] * cos1[0] + get(pose, 1, 2) * c23[0] * sin1[0] - get(pose, 2, 2) * s23[0]);
+    double theta4_i = std::atan2(pose(1, 2) * cos1[0] - pose(0, 2) * sin1[0],
+                                 pose(0, 2) * c23[0] * cos1[0] + pose(1, 2) * c23[0] * sin1[0] - pose(2, 2) * s23[0]);
 
-    double theta4_ii = std::atan2(get(pose, 1, 2) * cos1[1] - get(pose, 0, 2) * sin1[1],
-                                  get(pose, 0, 2) * c23[1] * cos1[1] + get(pose, 1, 2) * c23[1] * sin1[1] - get(pose, 2, 2) * s23[1]);
+    double theta4_ii = std::atan2(pose(1, 2) * cos1[1] - pose(0, 2) * sin1[1],
+                                  pose(0, 2) * c23[1] * cos1[1] + pose(1, 2) * c23[1] * sin1[1] - pose(2, 2) * s23[1]);
 
-    double theta4_iii = std::atan2(get(pose, 1, 2) * cos1[2] - get(pose, 0, 2) * sin1[2],
-                                   get(pose, 0, 2) * c23[2] * cos1[2] + get(pose, 1, 2) * c23[2] * sin1[2] - get(pose, 2, 2) * s23[2]);
+    double theta4_iii = std::atan2(pose(1, 2) * cos1[2] - pose(0, 2) * sin1[2],
+                                   pose(0, 2) * c23[2] * cos1[2] + pose(1, 2) * c23[2] * sin1[2] - pose(2, 2) * s23[2]);
 
-    double theta4_iv = std::atan2(get(pose, 1, 2) * cos1[3] - get(pose, 0, 2) * sin1[3],
-                                  get(pose, 0, 2) * c23[3] * cos1[3] + get(pose, 1, 2) * c23[3] * sin1[3] - get(pose, 2, 2) * s23[3]);
+    double theta4_iv = std::atan2(pose(1, 2) * cos1[3] - pose(0, 2) * sin1[3],
+                                  pose(0, 2) * c23[3] * cos1[3] + pose(1, 2) * c23[3] * sin1[3] - pose(2, 2) * s23[3]);
 
     double theta4_v = theta4_i + PI;
     double theta4_vi = theta4_ii + PI;
@@ -1051,20 +1255,20 @@ int InverseKinematics::inverseSW(ofMatrix4x4 pose, double *sol)
     if (std::abs(theta5_i) < zero_threshold)
     {
         theta4_i = 0;
-        glm::vec3 xe(get(pose, 0, 0), get(pose, 1, 0), get(pose, 2, 0));
-        glm::vec3 col1 = glm::vec3(-std::sin(theta1_i), std::cos(theta1_i), 0);  // yc
-        glm::vec3 col2  = glm::vec3(get(pose, 0, 2), get(pose, 1, 2), get(pose, 2, 2)); // zc and ze are equal
-        glm::vec3 col3 = glm::cross(col1, col2);// xc
-        glm::mat3x3 Rc = glm::mat3x3(col1.x, col1.y, col1.z, col2.x, col2.y, col2.z, col3.x, col3.y, col3.z);
-        glm::vec3 xec = glm::transpose(Rc) * xe;
+        math::Vec3d xe = pose.column(0);
+        math::Vec3d col1(-std::sin(theta1_i), std::cos(theta1_i), 0);  // yc
+        math::Vec3d col2 = pose.column(2); // zc and ze are equal
+        math::Vec3d col3 = col1.cross(col2);// xc
+        math::Mat3d Rc = math::Mat3d::fromColumns(col1, col2, col3);
+        math::Vec3d xec = Rc.transposed() * xe;
         theta6_i = std::atan2(xec.y, xec.x);
     }else{
-       double theta4_iy = get(pose, 1, 2) * cos1[0] - get(pose, 0, 2) * sin1[0];
-       double theta4_ix = get(pose, 0, 2) * c23[0] * cos1[0] + get(pose, 1, 2) * c23[0] * sin1[0] - get(pose, 2, 2) * s23[0];
+       double theta4_iy = pose(1, 2) * cos1[0] - pose(0, 2) * sin1[0];
+       double theta4_ix = pose(0, 2) * c23[0] * cos1[0] + pose(1, 2) * c23[0] * sin1[0] - pose(2, 2) * s23[0];
        theta4_i = std::atan2(theta4_iy, theta4_ix);
 
-       double theta6_iy = get(pose, 0, 1) * s23[0] * cos1[0] + get(pose, 1, 1) * s23[0] * sin1[0] + get(pose, 2, 1) * c23[0];
-       double theta6_ix = -get(pose, 0, 0) * s23[0] * cos1[0] - get(pose, 1, 0) * s23[0] * sin1[0] - get(pose, 2, 0) * c23[0];
+       double theta6_iy = pose(0, 1) * s23[0] * cos1[0] + pose(1, 1) * s23[0] * sin1[0] + pose(2, 1) * c23[0];
+       double theta6_ix = -pose(0, 0) * s23[0] * cos1[0] - pose(1, 0) * s23[0] * sin1[0] - pose(2, 0) * c23[0];
        theta6_i = std::atan2(theta6_iy, theta6_ix);
     }
     
@@ -1072,22 +1276,22 @@ int InverseKinematics::inverseSW(ofMatrix4x4 pose, double *sol)
     if (std::abs(theta5_ii) < zero_threshold)
     {
         theta4_ii = 0;
-        glm::vec3 xe(get(pose, 0, 0), get(pose, 1, 0), get(pose, 2, 0));
-        glm::vec3 col1 = glm::vec3(-std::sin(theta1_i), std::cos(theta1_i), 0);  // yc
-        glm::vec3 col2  = glm::vec3(get(pose, 0, 2), get(pose, 1, 2), get(pose, 2, 2)); // zc and ze are equal
-        glm::vec3 col3 = glm::cross(col1, col2);// xc
-        glm::mat3x3 Rc = glm::mat3x3(col1.x, col1.y, col1.z, col2.x, col2.y, col2.z, col3.x, col3.y, col3.z);
-        glm::vec3 xec = glm::transpose(Rc) * xe;
+        math::Vec3d xe = pose.column(0);
+        math::Vec3d col1(-std::sin(theta1_i), std::cos(theta1_i), 0);  // yc
+        math::Vec3d col2 = pose.column(2); // zc and ze are equal
+        math::Vec3d col3 = col1.cross(col2);// xc
+        math::Mat3d Rc = math::Mat3d::fromColumns(col1, col2, col3);
+        math::Vec3d xec = Rc.transposed() * xe;
         theta6_ii = std::atan2(xec.y, xec.x);
     }
     else
     {
-        double theta4_iiy = get(pose, 1, 2) * cos1[1] - get(pose, 0, 2) * sin1[1];
-        double theta4_iix = get(pose, 0, 2) * c23[1] * cos1[1] + get(pose,1, 2) * c23[1] * sin1[1] - get(pose, 2, 2) * s23[1];
+        double theta4_iiy = pose(1, 2) * cos1[1] - pose(0, 2) * sin1[1];
+        double theta4_iix = pose(0, 2) * c23[1] * cos1[1] + pose(1, 2) * c23[1] * sin1[1] - pose(2, 2) * s23[1];
         theta4_ii = std::atan2(theta4_iiy, theta4_iix);
 
-        double theta6_iiy = get(pose, 0, 1) * s23[1] * cos1[1] + get(pose, 1, 1) * s23[1] * sin1[1] + get(pose, 2, 1) * c23[1];
-        double theta6_iix = -get(pose, 0, 0) * s23[1] * cos1[1] - get(pose, 1, 0) * s23[1] * sin1[1] - get(pose, 2, 0) * c23[1];
+        double theta6_iiy = pose(0, 1) * s23[1] * cos1[1] + pose(1, 1) * s23[1] * sin1[1] + pose(2, 1) * c23[1];
+        double theta6_iix = -pose(0, 0) * s23[1] * cos1[1] - pose(1, 0) * s23[1] * sin1[1] - pose(2, 0) * c23[1];
         theta6_ii = std::atan2(theta6_iiy, theta6_iix);
     }
 
@@ -1095,22 +1299,22 @@ int InverseKinematics::inverseSW(ofMatrix4x4 pose, double *sol)
     if (std::abs(theta5_iii) < zero_threshold)
     {
         theta4_iii = 0;
-        glm::vec3 xe(get(pose, 0, 0), get(pose, 1, 0), get(pose, 2, 0));
-        glm::vec3 col1 = glm::vec3(-std::sin(theta1_ii), std::cos(theta1_ii), 0);  // yc
-        glm::vec3 col2  = glm::vec3(get(pose, 0, 2), get(pose, 1, 2), get(pose, 2, 2)); // zc and ze are equal
-        glm::vec3 col3 = glm::cross(col1, col2);// xc
-        glm::mat3x3 Rc = glm::mat3x3(col1.x, col1.y, col1.z, col2.x, col2.y, col2.z, col3.x, col3.y, col3.z);
-        glm::vec3 xec = glm::transpose(Rc) * xe;
+        math::Vec3d xe = pose.column(0);
+        math::Vec3d col1(-std::sin(theta1_ii), std::cos(theta1_ii), 0);  // yc
+        math::Vec3d col2 = pose.column(2); // zc and ze are equal
+        math::Vec3d col3 = col1.cross(col2);// xc
+        math::Mat3d Rc = math::Mat3d::fromColumns(col1, col2, col3);
+        math::Vec3d xec = Rc.transposed() * xe;
         theta6_iii = std::atan2(xec.y, xec.x);
     }
     else
     {
-        double theta4_iiiy = get(pose, 1, 2) * cos1[1] - get(pose, 0, 2) * sin1[1];
-        double theta4_iiix = get(pose, 0, 2) * c23[1] * cos1[1] + get(pose,1, 2) * c23[1] * sin1[1] - get(pose, 2, 2) * s23[1];
+        double theta4_iiiy = pose(1, 2) * cos1[1] - pose(0, 2) * sin1[1];
+        double theta4_iiix = pose(0, 2) * c23[1] * cos1[1] + pose(1, 2) * c23[1] * sin1[1] - pose(2, 2) * s23[1];
         theta4_iii = std::atan2(theta4_iiiy, theta4_iiix);
 
-        double theta6_iiiy = get(pose, 0, 1) * s23[1] * cos1[1] + get(pose, 1, 1) * s23[1] * sin1[1] + get(pose, 2, 1) * c23[1];
-        double theta6_iiix = -get(pose, 0, 0) * s23[1] * cos1[1] - get(pose, 1, 0) * s23[1] * sin1[1] - get(pose, 2, 0) * c23[1];
+        double theta6_iiiy = pose(0, 1) * s23[1] * cos1[1] + pose(1, 1) * s23[1] * sin1[1] + pose(2, 1) * c23[1];
+        double theta6_iiix = -pose(0, 0) * s23[1] * cos1[1] - pose(1, 0) * s23[1] * sin1[1] - pose(2, 0) * c23[1];
         theta6_iii = std::atan2(theta6_iiiy, theta6_iiix);
     }
 
@@ -1119,22 +1323,22 @@ int InverseKinematics::inverseSW(ofMatrix4x4 pose, double *sol)
     if (std::abs(theta5_iv) < zero_threshold)
     {
         theta4_iv = 0;
-        glm::vec3 xe(get(pose, 0, 0), get(pose, 1, 0), get(pose, 2, 0));
-        glm::vec3 col1 = glm::vec3(-std::sin(theta1_ii), std::cos(theta1_ii), 0);  // yc
-        glm::vec3 col2  = glm::vec3(get(pose, 0, 2), get(pose, 1, 2), get(pose, 2, 2)); // zc and ze are equal
-        glm::vec3 col3 = glm::cross(col1, col2);// xc
-        glm::mat3x3 Rc = glm::mat3x3(col1.x, col1.y, col1.z, col2.x, col2.y, col2.z, col3.x, col3.y, col3.z);
-        glm::vec3 xec = glm::transpose(Rc) * xe;
+        math::Vec3d xe = pose.column(0);
+        math::Vec3d col1(-std::sin(theta1_ii), std::cos(theta1_ii), 0);  // yc
+        math::Vec3d col2 = pose.column(2); // zc and ze are equal
+        math::Vec3d col3 = col1.cross(col2);// xc
+        math::Mat3d Rc = math::Mat3d::fromColumns(col1, col2, col3);
+        math::Vec3d xec = Rc.transposed() * xe;
         theta6_iv = std::atan2(xec.y, xec.x);
     }
     else
     {
-        double theta4_ivy = get(pose, 1, 2) * cos1[1] - get(pose, 0, 2) * sin1[1];
-        double theta4_ivx = get(pose, 0, 2) * c23[1] * cos1[1] + get(pose,1, 2) * c23[1] * sin1[1] - get(pose, 2, 2) * s23[1];
+        double theta4_ivy = pose(1, 2) * cos1[1] - pose(0, 2) * sin1[1];
+        double theta4_ivx = pose(0, 2) * c23[1] * cos1[1] + pose(1, 2) * c23[1] * sin1[1] - pose(2, 2) * s23[1];
         theta4_iv = std::atan2(theta4_ivy, theta4_ivx);
 
-        double theta6_ivy = get(pose, 0, 1) * s23[1] * cos1[1] + get(pose, 1, 1) * s23[1] * sin1[1] + get(pose, 2, 1) * c23[1];
-        double theta6_ivx = -get(pose, 0, 0) * s23[1] * cos1[1] - get(pose, 1, 0) * s23[1] * sin1[1] - get(pose, 2, 0) * c23[1];
+        double theta6_ivy = pose(0, 1) * s23[1] * cos1[1] + pose(1, 1) * s23[1] * sin1[1] + pose(2, 1) * c23[1];
+        double theta6_ivx = -pose(0, 0) * s23[1] * cos1[1] - pose(1, 0) * s23[1] * sin1[1] - pose(2, 0) * c23[1];
         theta6_iv = std::atan2(theta6_ivy, theta6_ivx);
     }
     
@@ -1220,12 +1424,6 @@ int InverseKinematics::inverseSW(ofMatrix4x4 pose, double *sol)
 
 #pragma mark - IK Utils
 
-float InverseKinematics::get(ofMatrix4x4 mat, int row, int col)
-{
-
-    return (mat.getPtr())[row * 4 + col];
-}
-
 // ----------------------------------------------------------
 void InverseKinematics::setSWParams(float a1, float a2, float b, float c1, float c2, float c3, float c4)
 {
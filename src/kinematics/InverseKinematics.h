@@ -4,6 +4,10 @@
 #include "Pose.h"
 #include "RobotConstants.hpp"
 #include "RelaxedIKSolver.h"
+#include "IKCache.h"
+#include "KinematicChain.h"
+#include "NumericIK.h"
+#include "RobotMath.h"
 //
 // Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
 //
@@ -38,19 +42,51 @@ namespace ofxRobotArm
         void setDHParams(float d1, float a2, float a3, float d4, float d5, float d6);
         void setRobotType(ofxRobotArm::RobotType type);
         void setIKType(ofxRobotArm::IKType type);
-        //int selectSolution(vector<vector<double> > & inversePosition, vector<double> currentQ, vector<double> weight);
+        /// \brief chain for the NUMERIC solver, also used for forward kinematics of
+        /// arms without an analytic solver. Empty links pick the defaults, see KinematicChain.
+        bool loadChain(string urdfPath, string baseLink = "", string tipLink = "");
+        /// \brief picks the solution cheapest to reach from seed (usually the last
+        /// commanded pose), shifting each joint by the multiple of 2PI nearest
+        /// the seed that stays within its limits. Writes it to out (which may
+        /// be seed) and returns its index, -1 if none fits the limits.
+        int selectSolution(const vector<vector<double>> & sols, const vector<double> & seed, vector<double> & out);
+        /// \brief sum of weighted joint travel (rad) plus timeWeight times the
+        /// time (s) the slowest joint needs at its max speed
+        double getSelectionCost(const vector<double> & from, const vector<double> & to);
+        void setSelectionWeights(const vector<double> & travelWeights, double timeWeight = 1.0);
+        /// \brief rad/s per joint, set per robot type by setRobotType
+        void setMaxJointSpeeds(const vector<double> & speeds);
+        bool getJointLimits(int joint, double & lower, double & upper);
+        bool nearestEquivalent(int joint, double q, double seed, double & out);
+        /// \brief forward kinematics as an ofMatrix4x4, for drawing and ofNodes
         ofMatrix4x4 forwardKinematics(vector<double> pose);
+        math::Mat4d forward(const vector<double> & pose);
         vector<vector<double>> inverseKinematics(ofxRobotArm::Pose targetPose, ofxRobotArm::Pose currentPose);
+        /// \brief fills sols in place, reusing its rows. Goes through the cache when enabled.
+        void inverseKinematics(const ofxRobotArm::Pose & targetPose, const ofxRobotArm::Pose & currentPose, vector<vector<double>> & sols);
+        /// \brief the solver itself, never cached
+        void solve(const ofxRobotArm::Pose & targetPose, const ofxRobotArm::Pose & currentPose, vector<vector<double>> & sols);
+        /// \brief off by default. Only pays off when targets repeat, a target that
+        /// keeps moving costs a lookup and an insert per solve. Hits are checked
+        /// with forward(), so RELAXED arms need a chain: urdfPath is loaded with
+        /// loadChain if none is loaded yet.
+        void setCacheEnabled(bool enabled, string urdfPath = "");
+        /// \brief tool offset the targets are for, part of the cache key
+        void setToolOffset(const ofVec3f & offset);
+        /// \brief separates cached results for the same target, e.g. per arm configuration
+        void setCacheBranch(int branch);
         void forward(double *q, double *T);
         void setRelaxedPose(vector<double> pose);
+        /// \brief solves RELAXED on the calling thread instead of its own, for lockstep simulation
+        void setLockstep(bool lockstep);
         vector<double> inverseRelaxed(Pose targetPose, Pose currentPose);
         vector<vector<double>> inverseHK(ofxRobotArm::Pose targetPose);
         vector<vector<double>> inverseSW(ofxRobotArm::Pose targetPose);
         //adapted from https://github.com/Jmeyer1292/opw_kinematics/blob/master/include/opw_kinematics/opw_kinematics_impl.h
         // based upon An Analytical Solution of the Inverse Kinematics Problem of Industrial Serial Manipulators with an Ortho-parallel Basis and a Spherical Wrist
-        ofMatrix4x4 forwardSW(double t1, double t2, double t3, double t4, double t5, double t6);
-        int inverseSW(ofMatrix4x4 pose, double *sol);
-        ofMatrix4x4 forwardHK(double o, double t, double th, double f, double fi, double s);
+        math::Mat4d forwardSW(double t1, double t2, double t3, double t4, double t5, double t6);
+        int inverseSW(const math::Mat4d & pose, double *sol);
+        math::Mat4d forwardHK(double o, double t, double th, double f, double fi, double s);
         void forwardHK(double *q, double *T);
         void forward_allHK(double *q, double *T1, double *T2, double *T3, double *T4, double *T5, double *T6);
         int inverseHK(double *T, double *q_sols, double q6_des = 0.0);
@@ -60,8 +96,8 @@ namespace ofxRobotArm
         void inverse(ofMatrix4x4 *target, vector<vector<double>> &sol);
 
         vector<double> boundSolution(vector<double> thetas);
-        double * toIK(ofMatrix4x4 input);
-        ofMatrix4x4 toOF(double *T);
+        math::Mat4d toIK(const ofMatrix4x4 & input);
+        ofMatrix4x4 toOF(const math::Mat4d & T);
 
         vector<double> initPose;
         ofxRobotArm::RobotType robotType;
@@ -71,8 +107,14 @@ namespace ofxRobotArm
         vector<vector<double>> preSol;
 
         RelaxedIKSolver relaxedIK;
-        // Retrive a specific value from a 4x4 matrix
-        float get(ofMatrix4x4 mat, int row, int col);
+        KinematicChain chain;
+        NumericIK numericIK;
+        vector<double> numericSeed;
+        IKCache cache;
+        bool bCacheEnabled = false;
+        ofVec3f toolOffset;
+        int cacheBranch = 0;
+        bool bLockstep = false;
 
         double d1;
         double a2;
@@ -86,6 +128,10 @@ namespace ofxRobotArm
         vector<double> sign_corrections;
         vector<double> joint_limit_min;
         vector<double> joint_limit_max;
+        vector<double> maxJointSpeeds;
+        vector<double> travelWeights;
+        double timeWeight = 1.0;
+        vector<double> candidate;
         vector<vector<double>> preInversePosition;
     };
 }
@@ -0,0 +1,179 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "JointStateEstimator.h"
+
+using namespace ofxRobotArm;
+
+namespace{
+    // a gap this long is a stall or a reconnect, not a late sample, s
+    const double MAX_GAP = 0.5;
+    // prior spread of the velocity (rad/s) and acceleration (rad/s^2) at the first sample
+    const double INITIAL_VELOCITY = 1.0;
+    const double INITIAL_ACCELERATION = 10.0;
+    // weight of a new interval in the running sample period
+    const double PERIOD_SMOOTHING = 0.05;
+    const int READY_SAMPLES = 3;
+}
+
+vector<double> JointState::extrapolate(double seconds) const{
+    vector<double> ret(position.size());
+    for(size_t i = 0; i < ret.size(); i++){
+        ret[i] = position[i] + (velocity[i] + 0.5 * acceleration[i] * seconds) * seconds;
+    }
+    return ret;
+}
+
+JointStateEstimator::JointStateEstimator(){
+    reset();
+}
+
+JointStateEstimator::~JointStateEstimator(){
+}
+
+void JointStateEstimator::setup(int numJoints){
+    this->numJoints = ofClamp(numJoints, 0, MAX_JOINTS);
+    reset();
+}
+
+int JointStateEstimator::getNumJoints() const{
+    return numJoints;
+}
+
+void JointStateEstimator::setPositionNoise(double radians){
+    positionNoise = MAX(radians, 1e-9);
+}
+
+void JointStateEstimator::setJerkNoise(double radiansPerSecond3){
+    jerkNoise = MAX(radiansPerSecond3, 0.0);
+}
+
+void JointStateEstimator::reset(){
+    numSamples = 0;
+    lastTime = 0;
+    samplePeriod = 0;
+    for(int j = 0; j < MAX_JOINTS; j++){
+        std::fill(x[j], x[j] + 3, 0.0);
+        std::fill(p[j], p[j] + 9, 0.0);
+    }
+}
+
+void JointStateEstimator::update(const double * q, double seconds){
+    double dt = seconds - lastTime;
+    if(numSamples > 0){
+        if(dt == 0){
+            return;
+        }
+        if(dt < 0 || dt > MAX_GAP){
+            // the clock restarted or the stream stalled, start over from this sample
+            numSamples = 0;
+        }
+    }
+    lastTime = seconds;
+    double r = positionNoise * positionNoise;
+    if(numSamples == 0){
+        for(int j = 0; j < numJoints; j++){
+            x[j][0] = q[j];
+            x[j][1] = 0;
+            x[j][2] = 0;
+            std::fill(p[j], p[j] + 9, 0.0);
+            p[j][0] = r;
+            p[j][4] = INITIAL_VELOCITY * INITIAL_VELOCITY;
+            p[j][8] = INITIAL_ACCELERATION * INITIAL_ACCELERATION;
+        }
+        numSamples = 1;
+        return;
+    }
+    samplePeriod += MAX(1.0 / numSamples, PERIOD_SMOOTHING) * (dt - samplePeriod);
+
+    // white jerk process noise, integrated over dt
+    double s = jerkNoise * jerkNoise;
+    double dt2 = dt * dt;
+    double dt3 = dt2 * dt;
+    double q00 = s * dt3 * dt2 / 20.0;
+    double q01 = s * dt2 * dt2 / 8.0;
+    double q02 = s * dt3 / 6.0;
+    double q11 = s * dt3 / 3.0;
+    double q12 = s * dt2 / 2.0;
+    double q22 = s * dt;
+    double h = 0.5 * dt2;
+
+    for(int j = 0; j < numJoints; j++){
+        double * xj = x[j];
+        double * pj = p[j];
+
+        // predict, x = F x and P = F P F^T + Q with F = [1 dt dt^2/2; 0 1 dt; 0 0 1]
+        xj[0] += dt * xj[1] + h * xj[2];
+        xj[1] += dt * xj[2];
+
+        double fp[9];
+        for(int c = 0; c < 3; c++){
+            fp[c] = pj[c] + dt * pj[3 + c] + h * pj[6 + c];
+            fp[3 + c] = pj[3 + c] + dt * pj[6 + c];
+            fp[6 + c] = pj[6 + c];
+        }
+        for(int r0 = 0; r0 < 3; r0++){
+            const double * row = fp + r0 * 3;
+            pj[r0 * 3] = row[0] + dt * row[1] + h * row[2];
+            pj[r0 * 3 + 1] = row[1] + dt * row[2];
+            pj[r0 * 3 + 2] = row[2];
+        }
+        pj[0] += q00;
+        pj[1] += q01; pj[3] += q01;
+        pj[2] += q02; pj[6] += q02;
+        pj[4] += q11;
+        pj[5] += q12; pj[7] += q12;
+        pj[8] += q22;
+
+        // correct with the measured position
+        double innovation = q[j] - xj[0];
+        double inverse = 1.0 / (pj[0] + r);
+        double k[3] = {pj[0] * inverse, pj[3] * inverse, pj[6] * inverse};
+        double top[3] = {pj[0], pj[1], pj[2]};
+        for(int r0 = 0; r0 < 3; r0++){
+            xj[r0] += k[r0] * innovation;
+            for(int c = 0; c < 3; c++){
+                pj[r0 * 3 + c] -= k[r0] * top[c];
+            }
+        }
+        // keep it symmetric against rounding
+        pj[1] = pj[3] = 0.5 * (pj[1] + pj[3]);
+        pj[2] = pj[6] = 0.5 * (pj[2] + pj[6]);
+        pj[5] = pj[7] = 0.5 * (pj[5] + pj[7]);
+    }
+    numSamples++;
+}
+
+bool JointStateEstimator::isReady() const{
+    return numSamples >= READY_SAMPLES;
+}
+
+double JointStateEstimator::getSamplePeriod() const{
+    return samplePeriod;
+}
+
+double JointStateEstimator::getPosition(int joint) const{
+    return x[joint][0];
+}
+
+double JointStateEstimator::getVelocity(int joint) const{
+    return x[joint][1];
+}
+
+double JointStateEstimator::getAcceleration(int joint) const{
+    return x[joint][2];
+}
+
+void JointStateEstimator::getState(JointState & state) const{
+    if((int)state.position.size() != numJoints){
+        state.position.resize(numJoints);
+        state.velocity.resize(numJoints);
+        state.acceleration.resize(numJoints);
+    }
+    state.time = lastTime;
+    for(int j = 0; j < numJoints; j++){
+        state.position[j] = x[j][0];
+        state.velocity[j] = x[j][1];
+        state.acceleration[j] = x[j][2];
+    }
+}
@@ -0,0 +1,77 @@
+//
+//  JointStateEstimator.h
+//  ofxRobotArm
+//
+//  Per joint constant acceleration Kalman filter over the measured joint
+//  positions. It gives filtered position, velocity and acceleration from
+//  the real sample timestamps, so the estimates hold up when the loop
+//  rate drifts or a sample is late.
+//
+//  The state is position, velocity and acceleration, driven by white jerk
+//  noise. jerkNoise sets how quickly the filter believes the acceleration
+//  changes: higher tracks faster, lower is smoother. positionNoise is the
+//  encoder's standard deviation. Every driver runs one on its thread and
+//  publishes the result with RobotDriver::getJointState.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+
+namespace ofxRobotArm{
+    /// \brief filtered joint state at a sample time
+    struct JointState{
+        /// \brief s, in the clock of the samples
+        double time = 0;
+        vector<double> position;
+        vector<double> velocity;
+        vector<double> acceleration;
+
+        /// \brief positions seconds after time, e.g. to make up for command latency
+        vector<double> extrapolate(double seconds) const;
+    };
+
+    class JointStateEstimator{
+    public:
+        static const int MAX_JOINTS = 8;
+
+        JointStateEstimator();
+        ~JointStateEstimator();
+
+        void setup(int numJoints);
+        int getNumJoints() const;
+        /// \brief rad, standard deviation of a position sample
+        void setPositionNoise(double radians);
+        /// \brief rad/s^3, standard deviation of the jerk over a second
+        void setJerkNoise(double radiansPerSecond3);
+        /// \brief restarts from the next sample
+        void reset();
+
+        /// \brief driver thread: one position sample per joint at time seconds,
+        /// repeated timestamps are skipped. Never allocates.
+        void update(const double * q, double seconds);
+
+        /// \brief true once a few samples are in
+        bool isReady() const;
+        /// \brief s, running mean of the time between samples
+        double getSamplePeriod() const;
+        double getPosition(int joint) const;
+        double getVelocity(int joint) const;
+        double getAcceleration(int joint) const;
+        /// \brief writes into state, no allocation once its vectors are sized
+        void getState(JointState & state) const;
+
+    protected:
+        int numJoints = 0;
+        double positionNoise = 1e-4;
+        double jerkNoise = 50;
+
+        int numSamples = 0;
+        double lastTime = 0;
+        double samplePeriod = 0;
+        /// \brief position, velocity, acceleration
+        double x[MAX_JOINTS][3];
+        /// \brief symmetric covariance, row-major
+        double p[MAX_JOINTS][9];
+    };
+}
@@ -0,0 +1,293 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "KinematicChain.h"
+#include "tinyxml2.h"
+
+using namespace ofxRobotArm;
+using namespace tinyxml2;
+
+namespace{
+    struct UrdfJointInfo{
+        KinematicChain::Joint joint;
+        string parent;
+        string child;
+    };
+
+    struct UrdfInertial{
+        double mass = 0;
+        math::Vec3d com;
+        math::Mat3d inertia = math::Mat3d(0, 0, 0, 0, 0, 0, 0, 0, 0);
+    };
+
+    math::Vec3d readVec3(const XMLElement * element, const char * attribute, const math::Vec3d & fallback){
+        const char * text = element ? element->Attribute(attribute) : nullptr;
+        if(!text){
+            return fallback;
+        }
+        math::Vec3d v;
+        std::istringstream stream(text);
+        stream >> v.x >> v.y >> v.z;
+        return v;
+    }
+
+    // a link splitting into branches this short is a hand, its fingers aren't part of the arm
+    const int MAX_FINGER_JOINTS = 3;
+
+    int countMoving(const string & link, const std::map<string, vector<const UrdfJointInfo *>> & children, string & tip){
+        // moving joints on the best path from link down to a leaf, tip gets that leaf
+        tip = link;
+        auto found = children.find(link);
+        if(found == children.end()){
+            return 0;
+        }
+        int best = 0;
+        int branches = 0;
+        string bestTip = link;
+        for(const UrdfJointInfo * info : found->second){
+            string leaf;
+            int count = countMoving(info->child, children, leaf) + (info->joint.type == KinematicChain::FIXED ? 0 : 1);
+            if(count > 0){
+                branches++;
+            }
+            if(count > best || bestTip == link){
+                best = count;
+                bestTip = leaf;
+            }
+        }
+        if(branches > 1 && best <= MAX_FINGER_JOINTS){
+            return 0;
+        }
+        tip = bestTip;
+        return best;
+    }
+}
+
+KinematicChain::KinematicChain(){
+}
+
+KinematicChain::~KinematicChain(){
+}
+
+math::Quatd KinematicChain::fromRPY(double roll, double pitch, double yaw){
+    return math::Quatd::fromAxisAngle(math::Vec3d(0, 0, 1), yaw) *
+           math::Quatd::fromAxisAngle(math::Vec3d(0, 1, 0), pitch) *
+           math::Quatd::fromAxisAngle(math::Vec3d(1, 0, 0), roll);
+}
+
+bool KinematicChain::load(string path, string baseLink, string tipLink){
+    clear();
+    XMLDocument doc;
+    if(doc.LoadFile(ofToDataPath(path).c_str()) != XML_SUCCESS){
+        ofLogError("KinematicChain") << "could not load " << path;
+        return false;
+    }
+    const XMLElement * robot = doc.FirstChildElement("robot");
+    if(!robot){
+        ofLogError("KinematicChain") << path << " has no robot element";
+        return false;
+    }
+
+    vector<UrdfJointInfo> infos;
+    for(const XMLElement * e = robot->FirstChildElement("joint"); e; e = e->NextSiblingElement("joint")){
+        UrdfJointInfo info;
+        Joint & j = info.joint;
+        j.name = e->Attribute("name") ? e->Attribute("name") : "";
+        string type = e->Attribute("type") ? e->Attribute("type") : "fixed";
+        if(type == "revolute"){
+            j.type = REVOLUTE;
+        }else if(type == "continuous"){
+            j.type = CONTINUOUS;
+        }else if(type == "prismatic"){
+            j.type = PRISMATIC;
+        }else if(type == "fixed"){
+            j.type = FIXED;
+        }else{
+            ofLogWarning("KinematicChain") << "joint " << j.name << " is " << type << ", treating it as fixed";
+            j.type = FIXED;
+        }
+        const XMLElement * parent = e->FirstChildElement("parent");
+        const XMLElement * child = e->FirstChildElement("child");
+        if(!parent || !child || !parent->Attribute("link") || !child->Attribute("link")){
+            ofLogWarning("KinematicChain") << "joint " << j.name << " has no parent or child link, skipping it";
+            continue;
+        }
+        info.parent = parent->Attribute("link");
+        info.child = child->Attribute("link");
+
+        const XMLElement * origin = e->FirstChildElement("origin");
+        math::Vec3d xyz = readVec3(origin, "xyz", math::Vec3d());
+        math::Vec3d rpy = readVec3(origin, "rpy", math::Vec3d());
+        j.origin = math::Transformd(fromRPY(rpy.x, rpy.y, rpy.z), xyz);
+        j.axis = readVec3(e->FirstChildElement("axis"), "xyz", math::Vec3d(1, 0, 0)).normalized();
+
+        const XMLElement * limit = e->FirstChildElement("limit");
+        if(j.type == CONTINUOUS){
+            j.lower = -std::numeric_limits<double>::infinity();
+            j.upper = std::numeric_limits<double>::infinity();
+        }else if(j.type != FIXED){
+            j.lower = limit ? limit->DoubleAttribute("lower", -TWO_PI) : -TWO_PI;
+            j.upper = limit ? limit->DoubleAttribute("upper", TWO_PI) : TWO_PI;
+        }
+        j.velocity = limit ? limit->DoubleAttribute("velocity", 0) : 0;
+        j.effort = limit ? limit->DoubleAttribute("effort", 0) : 0;
+        infos.push_back(info);
+    }
+
+    // inertials are given in their own frame, rotated into the link frame here
+    std::map<string, UrdfInertial> inertials;
+    for(const XMLElement * e = robot->FirstChildElement("link"); e; e = e->NextSiblingElement("link")){
+        const XMLElement * inertial = e->FirstChildElement("inertial");
+        if(!e->Attribute("name") || !inertial){
+            continue;
+        }
+        UrdfInertial & link = inertials[e->Attribute("name")];
+        const XMLElement * mass = inertial->FirstChildElement("mass");
+        link.mass = mass ? mass->DoubleAttribute("value", 0) : 0;
+        const XMLElement * origin = inertial->FirstChildElement("origin");
+        math::Vec3d rpy = readVec3(origin, "rpy", math::Vec3d());
+        link.com = readVec3(origin, "xyz", math::Vec3d());
+        const XMLElement * i = inertial->FirstChildElement("inertia");
+        if(i){
+            double xy = i->DoubleAttribute("ixy", 0);
+            double xz = i->DoubleAttribute("ixz", 0);
+            double yz = i->DoubleAttribute("iyz", 0);
+            math::Mat3d local(i->DoubleAttribute("ixx", 0), xy, xz,
+                              xy, i->DoubleAttribute("iyy", 0), yz,
+                              xz, yz, i->DoubleAttribute("izz", 0));
+            math::Mat3d r = math::Mat3d::fromQuat(fromRPY(rpy.x, rpy.y, rpy.z));
+            link.inertia = r * local * r.transposed();
+        }
+    }
+    for(auto & info : infos){
+        auto found = inertials.find(info.child);
+        if(found != inertials.end()){
+            info.joint.mass = found->second.mass;
+            info.joint.com = found->second.com;
+            info.joint.inertia = found->second.inertia;
+        }
+    }
+
+    std::map<string, const UrdfJointInfo *> parentJoint;
+    std::map<string, vector<const UrdfJointInfo *>> children;
+    for(const auto & info : infos){
+        parentJoint[info.child] = &info;
+        children[info.parent].push_back(&info);
+    }
+
+    if(baseLink.empty()){
+        for(const auto & info : infos){
+            if(parentJoint.find(info.parent) == parentJoint.end()){
+                baseLink = info.parent;
+                break;
+            }
+        }
+    }
+    if(tipLink.empty()){
+        countMoving(baseLink, children, tipLink);
+    }
+
+    // tip back up to the base
+    vector<const UrdfJointInfo *> chain;
+    string link = tipLink;
+    while(link != baseLink){
+        auto found = parentJoint.find(link);
+        if(found == parentJoint.end()){
+            ofLogError("KinematicChain") << path << ": " << tipLink << " is not below " << baseLink;
+            return false;
+        }
+        chain.push_back(found->second);
+        link = found->second->parent;
+    }
+    std::reverse(chain.begin(), chain.end());
+
+    for(const UrdfJointInfo * info : chain){
+        addJoint(info->joint);
+    }
+    this->baseLink = baseLink;
+    this->tipLink = tipLink;
+    ofLogNotice("KinematicChain") << "loaded " << numJoints << " joints from " << baseLink << " to " << tipLink;
+    return numJoints > 0;
+}
+
+void KinematicChain::clear(){
+    joints.clear();
+    numJoints = 0;
+    baseLink.clear();
+    tipLink.clear();
+}
+
+void KinematicChain::addJoint(Joint joint){
+    joint.index = joint.type == FIXED ? -1 : numJoints++;
+    joints.push_back(joint);
+}
+
+bool KinematicChain::isLoaded() const{
+    return numJoints > 0;
+}
+
+int KinematicChain::getNumJoints() const{
+    return numJoints;
+}
+
+const vector<KinematicChain::Joint> & KinematicChain::getJoints() const{
+    return joints;
+}
+
+string KinematicChain::getBaseLink() const{
+    return baseLink;
+}
+
+string KinematicChain::getTipLink() const{
+    return tipLink;
+}
+
+void KinematicChain::getLimits(vector<double> & lower, vector<double> & upper) const{
+    lower.resize(numJoints);
+    upper.resize(numJoints);
+    for(const Joint & j : joints){
+        if(j.index >= 0){
+            lower[j.index] = j.lower;
+            upper[j.index] = j.upper;
+        }
+    }
+}
+
+void KinematicChain::getEffortLimits(vector<double> & effort) const{
+    effort.resize(numJoints);
+    for(const Joint & j : joints){
+        if(j.index >= 0){
+            effort[j.index] = j.effort;
+        }
+    }
+}
+
+math::Transformd KinematicChain::forward(const vector<double> & q) const{
+    return forward(q.data(), nullptr, nullptr);
+}
+
+math::Transformd KinematicChain::forward(const double * q) const{
+    return forward(q, nullptr, nullptr);
+}
+
+math::Transformd KinematicChain::forward(const double * q, math::Vec3d * axes, math::Vec3d * origins) const{
+    math::Transformd t;
+    for(const Joint & j : joints){
+        t = t * j.origin;
+        if(j.index < 0){
+            continue;
+        }
+        if(axes){
+            axes[j.index] = t.rotation.rotate(j.axis);
+            origins[j.index] = t.translation;
+        }
+        double value = q[j.index];
+        if(j.type == PRISMATIC){
+            t.translation += t.rotation.rotate(j.axis * value);
+        }else{
+            double s = sin(value * 0.5);
+            t.rotation = t.rotation * math::Quatd(j.axis.x * s, j.axis.y * s, j.axis.z * s, cos(value * 0.5));
+        }
+    }
+    return t;
+}
@@ -0,0 +1,90 @@
+//
+//  KinematicChain.h
+//  ofxRobotArm
+//
+//  Serial chain from a base link to a tip link of a URDF, in double
+//  precision, for the numeric solvers. Works for any arm the URDF
+//  describes, not just the ones with analytic IK.
+//
+//  load() reads the joints with tinyxml2 and walks from the base to the
+//  tip. By default the base is the root link. The default tip is the leaf
+//  with the most moving joints on its path. The walk stops where the chain
+//  splits into short branches (a hand), so finger joints don't end up in
+//  the arm chain. Fixed joints fold into the chain's transforms.
+//  Mimic joints count as independent joints.
+//
+//  Each joint also carries the inertial of its child link, for Dynamics.
+//  Links off the chain (fingers) are left out.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "RobotMath.h"
+
+namespace ofxRobotArm{
+    class KinematicChain{
+    public:
+        enum JointType{
+            FIXED,
+            REVOLUTE,
+            CONTINUOUS,
+            PRISMATIC
+        };
+
+        struct Joint{
+            string name;
+            JointType type = FIXED;
+            /// \brief parent link to joint frame, at zero
+            math::Transformd origin;
+            /// \brief unit axis in the joint frame
+            math::Vec3d axis = math::Vec3d(0, 0, 1);
+            /// \brief rad or m, CONTINUOUS joints are -inf to inf
+            double lower = 0;
+            double upper = 0;
+            /// \brief URDF velocity limit, 0 if none
+            double velocity = 0;
+            /// \brief URDF effort limit in Nm or N, 0 if none
+            double effort = 0;
+            /// \brief child link mass, center of mass and inertia about it, in
+            /// the frame after the joint
+            double mass = 0;
+            math::Vec3d com;
+            math::Mat3d inertia = math::Mat3d(0, 0, 0, 0, 0, 0, 0, 0, 0);
+            /// \brief into the joint vector, -1 for fixed joints
+            int index = -1;
+        };
+
+        KinematicChain();
+        ~KinematicChain();
+
+        /// \brief empty links pick the defaults described above
+        bool load(string path, string baseLink = "", string tipLink = "");
+        void clear();
+        /// \brief appends a joint, for chains built by hand
+        void addJoint(Joint joint);
+
+        bool isLoaded() const;
+        /// \brief moving joints, the size of q
+        int getNumJoints() const;
+        const vector<Joint> & getJoints() const;
+        string getBaseLink() const;
+        string getTipLink() const;
+        void getLimits(vector<double> & lower, vector<double> & upper) const;
+        void getEffortLimits(vector<double> & effort) const;
+
+        math::Transformd forward(const vector<double> & q) const;
+        math::Transformd forward(const double * q) const;
+        /// \brief also fills the base frame axis and origin of each moving joint, for Jacobians
+        math::Transformd forward(const double * q, math::Vec3d * axes, math::Vec3d * origins) const;
+
+        /// \brief URDF origin rpy, fixed axes roll about x, then pitch about y, then yaw about z
+        static math::Quatd fromRPY(double roll, double pitch, double yaw);
+
+    protected:
+        vector<Joint> joints;
+        int numJoints = 0;
+        string baseLink;
+        string tipLink;
+    };
+}
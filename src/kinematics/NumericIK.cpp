@@ -0,0 +1,327 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "NumericIK.h"
+#include "Trace.h"
+#include <random>
+
+using namespace ofxRobotArm;
+
+namespace{
+    const double LAMBDA_START = 1e-3;
+    const double LAMBDA_MIN = 1e-9;
+    const double LAMBDA_MAX = 1e9;
+
+    /// in place lower Cholesky factor of an n x n row-major matrix, false if not positive definite
+    bool cholesky(double * a, int n){
+        for(int j = 0; j < n; j++){
+            double d = a[j * n + j];
+            for(int k = 0; k < j; k++){
+                d -= a[j * n + k] * a[j * n + k];
+            }
+            if(d <= 0){
+                return false;
+            }
+            d = sqrt(d);
+            a[j * n + j] = d;
+            for(int i = j + 1; i < n; i++){
+                double s = a[i * n + j];
+                for(int k = 0; k < j; k++){
+                    s -= a[i * n + k] * a[j * n + k];
+                }
+                a[i * n + j] = s / d;
+            }
+        }
+        return true;
+    }
+
+    /// solves L L^T x = b in place
+    void choleskySolve(const double * l, double * b, int n){
+        for(int i = 0; i < n; i++){
+            for(int k = 0; k < i; k++){
+                b[i] -= l[i * n + k] * b[k];
+            }
+            b[i] /= l[i * n + i];
+        }
+        for(int i = n - 1; i >= 0; i--){
+            for(int k = i + 1; k < n; k++){
+                b[i] -= l[k * n + i] * b[k];
+            }
+            b[i] /= l[i * n + i];
+        }
+    }
+}
+
+NumericIK::NumericIK() : lastIterations(0){
+}
+
+NumericIK::~NumericIK(){
+}
+
+void NumericIK::setup(const KinematicChain * chain, ThreadPool * pool){
+    this->chain = chain;
+    this->pool = pool ? pool : &ThreadPool::getDefault();
+    numJoints = chain ? chain->getNumJoints() : 0;
+    if(chain){
+        chain->getLimits(lower, upper);
+    }
+    workspaces.resize(this->pool->getNumWorkers());
+    for(auto & w : workspaces){
+        w.q.assign(numJoints, 0);
+        w.trial.assign(numJoints, 0);
+        w.jacobian.assign(6 * numJoints, 0);
+        w.jtj.assign(numJoints * numJoints, 0);
+        w.a.assign(numJoints * numJoints, 0);
+        w.gradient.assign(numJoints, 0);
+        w.axes.resize(numJoints);
+        w.origins.resize(numJoints);
+    }
+}
+
+bool NumericIK::isSetup(){
+    return chain && numJoints > 0;
+}
+
+void NumericIK::setTolerance(double meters, double radians){
+    positionTolerance = meters;
+    orientationTolerance = radians;
+}
+
+void NumericIK::setMaxIterations(int iterations){
+    maxIterations = iterations;
+}
+
+void NumericIK::setNumStarts(int starts){
+    numStarts = MAX(1, starts);
+}
+
+void NumericIK::setRandomSeed(uint32_t seed){
+    randomSeed = seed;
+}
+
+int NumericIK::getLastStart(){
+    return lastStart;
+}
+
+int NumericIK::getLastIterations(){
+    return lastIterations;
+}
+
+void NumericIK::randomStart(uint32_t stream, vector<double> & q){
+    std::mt19937 rng(randomSeed * 2654435761u ^ stream);
+    for(int i = 0; i < numJoints; i++){
+        double lo = std::isfinite(lower[i]) ? lower[i] : -PI;
+        double hi = std::isfinite(upper[i]) ? upper[i] : PI;
+        q[i] = std::uniform_real_distribution<double>(lo, hi)(rng);
+    }
+}
+
+void NumericIK::clamp(vector<double> & q){
+    for(int i = 0; i < numJoints; i++){
+        q[i] = MIN(MAX(q[i], lower[i]), upper[i]);
+    }
+}
+
+double NumericIK::getError(const math::Transformd & target, const double * q, double * e, double & position, double & rotation){
+    math::Transformd actual = chain->forward(q);
+    math::Vec3d p = target.translation - actual.translation;
+
+    // rotation taking actual to target, as axis * angle in the base frame
+    math::Quatd d = target.rotation * actual.rotation.conjugate();
+    if(d.w < 0){
+        d = math::Quatd(-d.x, -d.y, -d.z, -d.w);
+    }
+    math::Vec3d v(d.x, d.y, d.z);
+    double s = v.length();
+    double angle = 2.0 * atan2(s, d.w);
+    math::Vec3d r = s > 1e-12 ? v * (angle / s) : v * 2.0;
+
+    e[0] = p.x;
+    e[1] = p.y;
+    e[2] = p.z;
+    e[3] = r.x;
+    e[4] = r.y;
+    e[5] = r.z;
+    position = p.length();
+    rotation = angle;
+    return p.lengthSquared() + r.lengthSquared();
+}
+
+bool NumericIK::refine(const math::Transformd & target, Workspace & w, const std::atomic<bool> * cancel, int & iterations){
+    const int n = numJoints;
+    double e[6], trialError[6];
+    double position, rotation;
+    double error = getError(target, w.q.data(), e, position, rotation);
+    double lambda = LAMBDA_START;
+    bool bJacobian = false;
+
+    for(; iterations < maxIterations; iterations++){
+        if(position < positionTolerance && rotation < orientationTolerance){
+            return true;
+        }
+        if(cancel && cancel->load(std::memory_order_relaxed)){
+            return false;
+        }
+
+        if(!bJacobian){
+            // geometric Jacobian, J^T J and J^T e at the current joints
+            math::Vec3d tip = chain->forward(w.q.data(), w.axes.data(), w.origins.data()).translation;
+            const auto & joints = chain->getJoints();
+            for(const auto & joint : joints){
+                int i = joint.index;
+                if(i < 0){
+                    continue;
+                }
+                math::Vec3d linear, angular;
+                if(joint.type == KinematicChain::PRISMATIC){
+                    linear = w.axes[i];
+                }else{
+                    linear = w.axes[i].cross(tip - w.origins[i]);
+                    angular = w.axes[i];
+                }
+                for(int r = 0; r < 3; r++){
+                    w.jacobian[r * n + i] = linear[r];
+                    w.jacobian[(r + 3) * n + i] = angular[r];
+                }
+            }
+            for(int i = 0; i < n; i++){
+                double g = 0;
+                for(int r = 0; r < 6; r++){
+                    g += w.jacobian[r * n + i] * e[r];
+                }
+                w.gradient[i] = g;
+                for(int j = 0; j <= i; j++){
+                    double s = 0;
+                    for(int r = 0; r < 6; r++){
+                        s += w.jacobian[r * n + i] * w.jacobian[r * n + j];
+                    }
+                    w.jtj[i * n + j] = s;
+                    w.jtj[j * n + i] = s;
+                }
+            }
+            bJacobian = true;
+        }
+
+        // (J^T J + lambda diag(J^T J)) delta = J^T e
+        for(int i = 0; i < n * n; i++){
+            w.a[i] = w.jtj[i];
+        }
+        for(int i = 0; i < n; i++){
+            w.a[i * n + i] += lambda * w.jtj[i * n + i] + LAMBDA_MIN;
+            w.trial[i] = w.gradient[i];
+        }
+        if(!cholesky(w.a.data(), n)){
+            lambda *= 10;
+            continue;
+        }
+        choleskySolve(w.a.data(), w.trial.data(), n);
+        for(int i = 0; i < n; i++){
+            w.trial[i] += w.q[i];
+        }
+        clamp(w.trial);
+
+        double trialPosition, trialRotation;
+        double trial = getError(target, w.trial.data(), trialError, trialPosition, trialRotation);
+        if(trial < error){
+            std::swap(w.q, w.trial);
+            error = trial;
+            position = trialPosition;
+            rotation = trialRotation;
+            std::copy(trialError, trialError + 6, e);
+            lambda = MAX(lambda * 0.1, LAMBDA_MIN);
+            bJacobian = false;
+        }else{
+            lambda *= 10;
+            if(lambda > LAMBDA_MAX){
+                // stuck in a local minimum, or pinned against a limit
+                return false;
+            }
+        }
+    }
+    return position < positionTolerance && rotation < orientationTolerance;
+}
+
+bool NumericIK::solveStarts(const math::Transformd & target, const vector<double> & seed, uint32_t stream, Workspace & w, int & iterations){
+    for(int start = 0; start < numStarts; start++){
+        if(start == 0){
+            for(int i = 0; i < numJoints; i++){
+                w.q[i] = i < (int)seed.size() ? seed[i] : 0;
+            }
+            clamp(w.q);
+        }else{
+            randomStart(stream * numStarts + start, w.q);
+        }
+        int it = 0;
+        bool converged = refine(target, w, nullptr, it);
+        iterations += it;
+        if(converged){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NumericIK::solve(const math::Transformd & target, const vector<double> & seed, vector<double> & out){
+    RA_TRACE_SCOPE("numericik.solve");
+    lastStart = -1;
+    lastIterations = 0;
+    if(!isSetup()){
+        ofLogError("NumericIK") << "solve: no chain, call setup first";
+        return false;
+    }
+
+    // a tracking target is usually a few iterations from the seed, no need to wake the pool
+    Workspace & first = workspaces[0];
+    for(int i = 0; i < numJoints; i++){
+        first.q[i] = i < (int)seed.size() ? seed[i] : 0;
+    }
+    clamp(first.q);
+    int iterations = 0;
+    bool converged = refine(target, first, nullptr, iterations);
+    lastIterations = iterations;
+    if(converged){
+        out = first.q;
+        lastStart = 0;
+        return true;
+    }
+
+    std::atomic<bool> done(false);
+    std::atomic<int> winner(-1);
+    pool->parallelFor(numStarts - 1, [&](int index, int worker){
+        if(done){
+            return;
+        }
+        Workspace & w = workspaces[worker];
+        randomStart(index + 1, w.q);
+        int it = 0;
+        bool ok = refine(target, w, &done, it);
+        lastIterations += it;
+        if(ok && !done.exchange(true)){
+            winner = index + 1;
+            out = w.q;
+        }
+    });
+    lastStart = winner;
+    return winner >= 0;
+}
+
+int NumericIK::solve(const vector<math::Transformd> & targets, const vector<double> & seed, vector<vector<double>> & out){
+    RA_TRACE_SCOPE("numericik.batch");
+    out.resize(targets.size());
+    if(!isSetup()){
+        ofLogError("NumericIK") << "solve: no chain, call setup first";
+        return 0;
+    }
+    std::atomic<int> solved(0);
+    pool->parallelFor(targets.size(), [&](int index, int worker){
+        Workspace & w = workspaces[worker];
+        int iterations = 0;
+        if(solveStarts(targets[index], seed, index, w, iterations)){
+            out[index] = w.q;
+            solved++;
+        }else{
+            out[index].clear();
+        }
+    });
+    return solved;
+}
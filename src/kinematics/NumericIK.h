@@ -0,0 +1,90 @@
+//
+//  NumericIK.h
+//  ofxRobotArm
+//
+//  Levenberg-Marquardt IK over a KinematicChain, for arms without an
+//  analytic solver. Joint limits are enforced by clamping every step.
+//
+//  A solve starts from the seed alone, which is all a tracking target
+//  needs. Only when that fails to converge are the random restarts spread
+//  over the thread pool. They stop as soon as the first one converges, so
+//  the latency stays bounded by maxIterations rather than by luck.
+//
+//  Batches run one target per pool task, each with its own restarts.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "KinematicChain.h"
+#include "ThreadPool.h"
+#include "RobotMath.h"
+#include <atomic>
+
+namespace ofxRobotArm{
+    class NumericIK{
+    public:
+        NumericIK();
+        ~NumericIK();
+
+        /// \brief chain has to outlive the solver, pool defaults to ThreadPool::getDefault()
+        void setup(const KinematicChain * chain, ThreadPool * pool = nullptr);
+        bool isSetup();
+
+        /// \brief converged once within meters and radians of the target
+        void setTolerance(double meters, double radians);
+        /// \brief per start, each one solves a small linear system
+        void setMaxIterations(int iterations);
+        /// \brief starts per target, the seed plus numStarts - 1 random ones
+        void setNumStarts(int starts);
+        /// \brief the random starts are reproducible for a given seed
+        void setRandomSeed(uint32_t seed);
+
+        /// \brief writes the solution to out, false if no start converged.
+        /// Not reentrant, one solve per NumericIK at a time.
+        bool solve(const math::Transformd & target, const vector<double> & seed, vector<double> & out);
+        /// \brief solves every target from seed, out[i] is left empty where none
+        /// converged. Returns the number solved.
+        int solve(const vector<math::Transformd> & targets, const vector<double> & seed, vector<vector<double>> & out);
+
+        /// \brief of the last single target solve: which start converged (0 is
+        /// the seed, -1 none) and the iterations all starts took together
+        int getLastStart();
+        int getLastIterations();
+
+    protected:
+        struct Workspace{
+            vector<double> q;
+            vector<double> trial;
+            vector<double> jacobian;
+            vector<double> jtj;
+            vector<double> a;
+            vector<double> gradient;
+            vector<math::Vec3d> axes;
+            vector<math::Vec3d> origins;
+        };
+
+        void randomStart(uint32_t stream, vector<double> & q);
+        void clamp(vector<double> & q);
+        double getError(const math::Transformd & target, const double * q, double * e, double & position, double & rotation);
+        /// \brief refines w.q in place, gives up when cancel turns true
+        bool refine(const math::Transformd & target, Workspace & w, const std::atomic<bool> * cancel, int & iterations);
+        bool solveStarts(const math::Transformd & target, const vector<double> & seed, uint32_t stream, Workspace & w, int & iterations);
+
+        const KinematicChain * chain = nullptr;
+        ThreadPool * pool = nullptr;
+        int numJoints = 0;
+        vector<double> lower;
+        vector<double> upper;
+        vector<Workspace> workspaces;
+
+        double positionTolerance = 1e-5;
+        double orientationTolerance = 1e-4;
+        int maxIterations = 100;
+        int numStarts = 8;
+        uint32_t randomSeed = 1;
+
+        int lastStart = -1;
+        std::atomic<int> lastIterations;
+    };
+}
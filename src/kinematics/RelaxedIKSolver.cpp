@@ -7,6 +7,7 @@
 
 #include "RelaxedIKSolver.h"
 #include "RelaxedIK.hpp"
+#include "Trace.h"
 using namespace ofxRobotArm;
 
 RelaxedIKSolver::RelaxedIKSolver(){
@@ -16,6 +17,7 @@ RelaxedIKSolver::RelaxedIKSolver(){
     currentPose.getBack().assign(6, 0.0);
     currentPose.swapBack();
     frameNum = 0;
+    bThreadStarted = false;
 }
 
 RelaxedIKSolver::~RelaxedIKSolver(){
@@ -57,38 +59,48 @@ vector<double> RelaxedIKSolver::getCurrentPose(){
 void RelaxedIKSolver::setInitialPose(vector<double> pose){
     lock();
     // set_starting_config(pose.data(), pose.size());
+    // one value per joint, the 7 axis arms don't fit the default 6
+    currentPose.setup(pose);
+    unlock();
+}
+
+void RelaxedIKSolver::solveOnce(){
+    lock();
+            
+    ofVec3f difPos = (desiredPose.position - actualPose.position);
+    ofQuaternion rot  = (actualPose.orientation * desiredPose.orientation);
+    ofVec4f r = ofVec4f(rot.x(), rot.y(), rot.z(), rot.w());
+
+    std::vector<double> pos(3, 0.0);
+    pos[0] = difPos.x;
+    pos[1] = difPos.y;
+    pos[2] = difPos.z;
+    
+    std::vector<double> quat(4, 0.0);
+    quat[0] = r.x;
+    quat[1] = r.y;
+    quat[2] = r.z;
+    quat[3] = r.w;
+    
+    Opt x;
+    {
+        RA_TRACE_SCOPE("relaxedik.solve");
+        x = solve(pos.data(), (int) pos.size(), quat.data(), (int) quat.size());
+    }
+    for (int i = 0; i < x.length && i < (int)currentPose.getBack().size(); i++) {
+        currentPose.getBack()[i] = x.data[i];
+    }
+    frameNum++;
+    if(frameNum > 4000)
+        frameNum = 0;
+    currentPose.swapBack();
     unlock();
 }
 
 void RelaxedIKSolver::threadedFunction(){
+    RA_TRACE_THREAD_NAME("RelaxedIKSolver");
     while(isThreadRunning()){
-        lock();
-                
-        ofVec3f difPos = (desiredPose.position - actualPose.position);
-        ofQuaternion rot  = (actualPose.orientation * desiredPose.orientation);
-        ofVec4f r = ofVec4f(rot.x(), rot.y(), rot.z(), rot.w());
-   
-        std::vector<double> pos(3, 0.0);
-        pos[0] = difPos.x;
-        pos[1] = difPos.y;
-        pos[2] = difPos.z;
-        
-        std::vector<double> quat(4, 0.0);
-        quat[0] = r.x;
-        quat[1] = r.y;
-        quat[2] = r.z;
-        quat[3] = r.w;
-        
-        Opt x = solve(pos.data(), (int) pos.size(), quat.data(), (int) quat.size());
-        for (int i = 0; i < x.length; i++) {
-            currentPose.getBack()[i] = x.data[i];
-        }
-        frameNum++;
-        if(frameNum > 4000)
-            frameNum = 0;
-        currentPose.swapBack();
-        unlock();
-        
+        solveOnce();
         ofSleepMillis(1);
     }
 }
@@ -24,6 +24,8 @@ public:
     void setPose(Pose desiredPose, Pose actualPose);
    
     vector<double> getCurrentPose();
+    /// \brief one solve on the calling thread, what the solver thread does each loop
+    void solveOnce();
     void threadedFunction();
     bool isThreadRunning();
     bool bThreadStarted;
@@ -0,0 +1,312 @@
+//
+//  RobotMath.h
+//  ofxRobotArm
+//
+//  Fixed size double precision types for the kinematics core. No OF or glm
+//  dependency, conversions to the OF types live in RobotMathOF.h and should
+//  only be needed where a pose leaves the core (drawing, ofNode, GUI).
+//
+//  Mat4d is row-major with column vectors, the same element order as the
+//  double[16] arrays the UR kinematics (forwardHK/inverseHK) work on, so
+//  data() can be handed to them directly. Angles are radians throughout.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+namespace ofxRobotArm{
+    namespace math{
+
+        struct Vec3d{
+            double x, y, z;
+
+            Vec3d() : x(0), y(0), z(0){}
+            Vec3d(double x, double y, double z) : x(x), y(y), z(z){}
+
+            double & operator[](int i){ return (&x)[i]; }
+            double operator[](int i) const { return (&x)[i]; }
+
+            Vec3d operator+(const Vec3d & v) const { return Vec3d(x + v.x, y + v.y, z + v.z); }
+            Vec3d operator-(const Vec3d & v) const { return Vec3d(x - v.x, y - v.y, z - v.z); }
+            Vec3d operator-() const { return Vec3d(-x, -y, -z); }
+            Vec3d operator*(double s) const { return Vec3d(x * s, y * s, z * s); }
+            Vec3d operator/(double s) const { return Vec3d(x / s, y / s, z / s); }
+            Vec3d & operator+=(const Vec3d & v){ x += v.x; y += v.y; z += v.z; return *this; }
+            Vec3d & operator-=(const Vec3d & v){ x -= v.x; y -= v.y; z -= v.z; return *this; }
+            Vec3d & operator*=(double s){ x *= s; y *= s; z *= s; return *this; }
+
+            double dot(const Vec3d & v) const { return x * v.x + y * v.y + z * v.z; }
+            Vec3d cross(const Vec3d & v) const { return Vec3d(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+            double lengthSquared() const { return dot(*this); }
+            double length() const { return std::sqrt(lengthSquared()); }
+            Vec3d normalized() const {
+                double l = length();
+                return l > 0 ? *this / l : *this;
+            }
+        };
+
+        inline Vec3d operator*(double s, const Vec3d & v){ return v * s; }
+
+        /// \brief fixed length vector for joint space values, padded so rows line up for SIMD
+        template<int N>
+        struct alignas(32) Vecd{
+            double v[N];
+
+            Vecd(){ for(int i = 0; i < N; i++) v[i] = 0; }
+            static Vecd fill(double value){ Vecd r; for(int i = 0; i < N; i++) r.v[i] = value; return r; }
+            template<class Container>
+            static Vecd from(const Container & c){
+                Vecd r;
+                for(int i = 0; i < N && i < (int)c.size(); i++) r.v[i] = c[i];
+                return r;
+            }
+
+            static constexpr int size(){ return N; }
+            double & operator[](int i){ return v[i]; }
+            double operator[](int i) const { return v[i]; }
+            double * data(){ return v; }
+            const double * data() const { return v; }
+
+            Vecd operator+(const Vecd & o) const { Vecd r; for(int i = 0; i < N; i++) r.v[i] = v[i] + o.v[i]; return r; }
+            Vecd operator-(const Vecd & o) const { Vecd r; for(int i = 0; i < N; i++) r.v[i] = v[i] - o.v[i]; return r; }
+            Vecd operator*(double s) const { Vecd r; for(int i = 0; i < N; i++) r.v[i] = v[i] * s; return r; }
+            Vecd & operator+=(const Vecd & o){ for(int i = 0; i < N; i++) v[i] += o.v[i]; return *this; }
+            Vecd & operator-=(const Vecd & o){ for(int i = 0; i < N; i++) v[i] -= o.v[i]; return *this; }
+
+            double dot(const Vecd & o) const { double s = 0; for(int i = 0; i < N; i++) s += v[i] * o.v[i]; return s; }
+            double length() const { return std::sqrt(dot(*this)); }
+            double maxAbs() const { double m = 0; for(int i = 0; i < N; i++) m = std::fmax(m, std::fabs(v[i])); return m; }
+        };
+
+        typedef Vecd<6> Joints6d;
+        typedef Vecd<7> Joints7d;
+
+        struct alignas(32) Quatd{
+            double x, y, z, w;
+
+            Quatd() : x(0), y(0), z(0), w(1){}
+            Quatd(double x, double y, double z, double w) : x(x), y(y), z(z), w(w){}
+
+            static Quatd fromAxisAngle(const Vec3d & axis, double radians){
+                Vec3d a = axis.normalized();
+                double s = std::sin(radians * 0.5);
+                return Quatd(a.x * s, a.y * s, a.z * s, std::cos(radians * 0.5));
+            }
+
+            Quatd operator*(const Quatd & q) const {
+                return Quatd(w * q.x + x * q.w + y * q.z - z * q.y,
+                             w * q.y - x * q.z + y * q.w + z * q.x,
+                             w * q.z + x * q.y - y * q.x + z * q.w,
+                             w * q.w - x * q.x - y * q.y - z * q.z);
+            }
+            Quatd conjugate() const { return Quatd(-x, -y, -z, w); }
+            double dot(const Quatd & q) const { return x * q.x + y * q.y + z * q.z + w * q.w; }
+            double length() const { return std::sqrt(dot(*this)); }
+            Quatd normalized() const {
+                double l = length();
+                return l > 0 ? Quatd(x / l, y / l, z / l, w / l) : Quatd();
+            }
+
+            Vec3d rotate(const Vec3d & v) const {
+                // v + 2w(u x v) + 2u x (u x v)
+                Vec3d u(x, y, z);
+                Vec3d t = u.cross(v) * 2.0;
+                return v + t * w + u.cross(t);
+            }
+
+            /// \brief angle of the rotation taking this to q, in [0, PI]
+            double angleTo(const Quatd & q) const {
+                double d = std::fabs(dot(q));
+                return 2.0 * std::acos(d > 1.0 ? 1.0 : d);
+            }
+
+            static Quatd slerp(const Quatd & a, const Quatd & b, double t){
+                double d = a.dot(b);
+                Quatd c = b;
+                if(d < 0){
+                    d = -d;
+                    c = Quatd(-b.x, -b.y, -b.z, -b.w);
+                }
+                double ka, kb;
+                if(d > 0.9995){
+                    ka = 1.0 - t;
+                    kb = t;
+                }else{
+                    double theta = std::acos(d);
+                    double s = std::sin(theta);
+                    ka = std::sin((1.0 - t) * theta) / s;
+                    kb = std::sin(t * theta) / s;
+                }
+                return Quatd(a.x * ka + c.x * kb, a.y * ka + c.y * kb, a.z * ka + c.z * kb, a.w * ka + c.w * kb).normalized();
+            }
+        };
+
+        /// \brief row-major 3x3, column vectors
+        struct Mat3d{
+            double m[9];
+
+            Mat3d(){ setIdentity(); }
+            Mat3d(double m00, double m01, double m02,
+                  double m10, double m11, double m12,
+                  double m20, double m21, double m22){
+                m[0] = m00; m[1] = m01; m[2] = m02;
+                m[3] = m10; m[4] = m11; m[5] = m12;
+                m[6] = m20; m[7] = m21; m[8] = m22;
+            }
+            static Mat3d fromColumns(const Vec3d & c0, const Vec3d & c1, const Vec3d & c2){
+                return Mat3d(c0.x, c1.x, c2.x,
+                             c0.y, c1.y, c2.y,
+                             c0.z, c1.z, c2.z);
+            }
+            static Mat3d fromQuat(const Quatd & q){
+                double xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+                double xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+                double wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+                return Mat3d(1 - 2 * (yy + zz), 2 * (xy - wz), 2 * (xz + wy),
+                             2 * (xy + wz), 1 - 2 * (xx + zz), 2 * (yz - wx),
+                             2 * (xz - wy), 2 * (yz + wx), 1 - 2 * (xx + yy));
+            }
+
+            void setIdentity(){
+                for(int i = 0; i < 9; i++) m[i] = (i % 4 == 0) ? 1.0 : 0.0;
+            }
+            double & operator()(int row, int col){ return m[row * 3 + col]; }
+            double operator()(int row, int col) const { return m[row * 3 + col]; }
+            Vec3d column(int col) const { return Vec3d(m[col], m[3 + col], m[6 + col]); }
+
+            Mat3d operator*(const Mat3d & b) const {
+                Mat3d r;
+                for(int i = 0; i < 3; i++){
+                    for(int j = 0; j < 3; j++){
+                        r.m[i * 3 + j] = m[i * 3] * b.m[j] + m[i * 3 + 1] * b.m[3 + j] + m[i * 3 + 2] * b.m[6 + j];
+                    }
+                }
+                return r;
+            }
+            Vec3d operator*(const Vec3d & v) const {
+                return Vec3d(m[0] * v.x + m[1] * v.y + m[2] * v.z,
+                             m[3] * v.x + m[4] * v.y + m[5] * v.z,
+                             m[6] * v.x + m[7] * v.y + m[8] * v.z);
+            }
+            Mat3d transposed() const {
+                return Mat3d(m[0], m[3], m[6],
+                             m[1], m[4], m[7],
+                             m[2], m[5], m[8]);
+            }
+
+            Quatd toQuat() const {
+                // Shepperd's method, branch on the largest diagonal term for stability
+                double trace = m[0] + m[4] + m[8];
+                Quatd q;
+                if(trace > 0){
+                    double s = std::sqrt(trace + 1.0) * 2.0;
+                    q = Quatd((m[7] - m[5]) / s, (m[2] - m[6]) / s, (m[3] - m[1]) / s, 0.25 * s);
+                }else if(m[0] > m[4] && m[0] > m[8]){
+                    double s = std::sqrt(1.0 + m[0] - m[4] - m[8]) * 2.0;
+                    q = Quatd(0.25 * s, (m[1] + m[3]) / s, (m[2] + m[6]) / s, (m[7] - m[5]) / s);
+                }else if(m[4] > m[8]){
+                    double s = std::sqrt(1.0 + m[4] - m[0] - m[8]) * 2.0;
+                    q = Quatd((m[1] + m[3]) / s, 0.25 * s, (m[5] + m[7]) / s, (m[2] - m[6]) / s);
+                }else{
+                    double s = std::sqrt(1.0 + m[8] - m[0] - m[4]) * 2.0;
+                    q = Quatd((m[2] + m[6]) / s, (m[5] + m[7]) / s, 0.25 * s, (m[3] - m[1]) / s);
+                }
+                return q.normalized();
+            }
+        };
+
+        /// \brief homogeneous transform, row-major, column vectors
+        struct alignas(32) Mat4d{
+            double m[16];
+
+            Mat4d(){ setIdentity(); }
+            explicit Mat4d(const double * rowMajor){
+                for(int i = 0; i < 16; i++) m[i] = rowMajor[i];
+            }
+            Mat4d(const Mat3d & r, const Vec3d & t){
+                setIdentity();
+                setRotation(r);
+                setTranslation(t);
+            }
+
+            void setIdentity(){
+                for(int i = 0; i < 16; i++) m[i] = (i % 5 == 0) ? 1.0 : 0.0;
+            }
+            double & operator()(int row, int col){ return m[row * 4 + col]; }
+            double operator()(int row, int col) const { return m[row * 4 + col]; }
+            double * data(){ return m; }
+            const double * data() const { return m; }
+
+            Mat3d getRotation() const {
+                return Mat3d(m[0], m[1], m[2],
+                             m[4], m[5], m[6],
+                             m[8], m[9], m[10]);
+            }
+            Vec3d getTranslation() const { return Vec3d(m[3], m[7], m[11]); }
+            void setRotation(const Mat3d & r){
+                for(int i = 0; i < 3; i++){
+                    for(int j = 0; j < 3; j++){
+                        m[i * 4 + j] = r(i, j);
+                    }
+                }
+            }
+            void setTranslation(const Vec3d & t){ m[3] = t.x; m[7] = t.y; m[11] = t.z; }
+
+            Mat4d operator*(const Mat4d & b) const {
+                Mat4d r;
+                for(int i = 0; i < 4; i++){
+                    for(int j = 0; j < 4; j++){
+                        r.m[i * 4 + j] = m[i * 4] * b.m[j] + m[i * 4 + 1] * b.m[4 + j] + m[i * 4 + 2] * b.m[8 + j] + m[i * 4 + 3] * b.m[12 + j];
+                    }
+                }
+                return r;
+            }
+            Vec3d transformPoint(const Vec3d & p) const {
+                return Vec3d(m[0] * p.x + m[1] * p.y + m[2] * p.z + m[3],
+                             m[4] * p.x + m[5] * p.y + m[6] * p.z + m[7],
+                             m[8] * p.x + m[9] * p.y + m[10] * p.z + m[11]);
+            }
+            Vec3d transformDirection(const Vec3d & d) const {
+                return Vec3d(m[0] * d.x + m[1] * d.y + m[2] * d.z,
+                             m[4] * d.x + m[5] * d.y + m[6] * d.z,
+                             m[8] * d.x + m[9] * d.y + m[10] * d.z);
+            }
+            /// \brief inverse assuming the upper 3x3 is a rotation
+            Mat4d inverseRigid() const {
+                Mat3d rt = getRotation().transposed();
+                return Mat4d(rt, -(rt * getTranslation()));
+            }
+        };
+
+        /// \brief rotation followed by translation, cheaper than a Mat4d to compose and invert
+        struct Transformd{
+            Quatd rotation;
+            Vec3d translation;
+
+            Transformd(){}
+            Transformd(const Quatd & rotation, const Vec3d & translation) : rotation(rotation), translation(translation){}
+            static Transformd fromMatrix(const Mat4d & mat){
+                return Transformd(mat.getRotation().toQuat(), mat.getTranslation());
+            }
+
+            Transformd operator*(const Transformd & b) const {
+                return Transformd(rotation * b.rotation, translation + rotation.rotate(b.translation));
+            }
+            Transformd inverse() const {
+                Quatd inv = rotation.conjugate();
+                return Transformd(inv, -inv.rotate(translation));
+            }
+            Vec3d transformPoint(const Vec3d & p) const { return rotation.rotate(p) + translation; }
+            Mat4d toMatrix() const { return Mat4d(Mat3d::fromQuat(rotation), translation); }
+        };
+
+        /// \brief wraps an angle into (-PI, PI]
+        inline double wrapAngle(double a){
+            a = std::fmod(a + M_PI, 2.0 * M_PI);
+            if(a <= 0) a += 2.0 * M_PI;
+            return a - M_PI;
+        }
+    }
+}
@@ -0,0 +1,46 @@
+//
+//  RobotMathOF.h
+//  ofxRobotArm
+//
+//  Conversions between the kinematics math types and OF/glm. ofMatrix4x4
+//  stores the transpose (row vectors), toMath/toOF take care of that.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "RobotMath.h"
+#include "Pose.h"
+
+namespace ofxRobotArm{
+    namespace math{
+        inline Vec3d toMath(const ofVec3f & v){ return Vec3d(v.x, v.y, v.z); }
+        inline Vec3d toMath(const glm::vec3 & v){ return Vec3d(v.x, v.y, v.z); }
+        inline Quatd toMath(const ofQuaternion & q){ return Quatd(q.x(), q.y(), q.z(), q.w()); }
+        inline Mat4d toMath(const ofMatrix4x4 & mat){
+            Mat4d r;
+            for(int i = 0; i < 4; i++){
+                for(int j = 0; j < 4; j++){
+                    r(i, j) = mat._mat[j][i];
+                }
+            }
+            return r;
+        }
+        inline Transformd toMath(const Pose & pose){
+            return Transformd(toMath(pose.orientation), toMath(pose.position));
+        }
+
+        inline ofVec3f toOF(const Vec3d & v){ return ofVec3f(v.x, v.y, v.z); }
+        inline ofQuaternion toOF(const Quatd & q){ return ofQuaternion(q.x, q.y, q.z, q.w); }
+        inline ofMatrix4x4 toOF(const Mat4d & mat){
+            ofMatrix4x4 r;
+            for(int i = 0; i < 4; i++){
+                for(int j = 0; j < 4; j++){
+                    r._mat[j][i] = mat(i, j);
+                }
+            }
+            return r;
+        }
+        inline ofMatrix4x4 toOF(const Transformd & t){ return toOF(t.toMatrix()); }
+    }
+}
@@ -44,7 +44,8 @@ void HKIK::computeParams(RobotModel model){
 }
 
 ofMatrix4x4 HKIK::forward(vector<double> pose){
-    double *q = new double[6];
+    double q_storage[6];
+    double *q = q_storage;
     for (int j = 0; j < 6; j++)
     {
         pose[j] = pose[j] * sign_corrections[j] - offsets[j];
@@ -60,7 +61,8 @@ ofMatrix4x4 HKIK::forward(vector<double> pose){
     double s6 = sin(*q), c6 = cos(*q);
     double s23 = sin(q23), c23 = cos(q23);
     double s234 = sin(q234), c234 = cos(q234);
-    double *T = new double[16];
+    math::Mat4d sol;
+    double *T = sol.data();
     *T = c234*c1*s5 - c5*s1;
     T++;
     *T = c6*(s1*s5 + c234*c1*c5) - s234*c1*s6; T++;
@@ -75,13 +77,12 @@ ofMatrix4x4 HKIK::forward(vector<double> pose){
     *T = s234*c5*s6 - c234*c6; T++;
     *T = d1 + a3*s23 + a2*s2 - d5*(c23*c4 - s23*s4) - d6*s5*(c23*s4 + s23*c4); T++;
     *T = 0.0; T++; *T = 0.0; T++; *T = 0.0; T++; *T = 1.0;
-    ofMatrix4x4 sol = toOF(T);
-    return sol;
+    return toOF(sol);
 }
 
 vector<vector<double>> HKIK::inverse(ofMatrix4x4 pose){
-    double *T = new double[16];
-    T = toIK(pose);
+    math::Mat4d mat = toIK(pose);
+    const double *T = mat.data();
     double q_sols[8 * 6];
     int num_sols = 0;
     double T02 = -*T;
@@ -9,6 +9,7 @@
 #pragma once
 #include "ofMain.h"
 #include "IK.h"
+#include "RobotMathOF.h"
 namespace ofxRobotArm {
     class HKIK : public IK{
         public:
@@ -24,33 +25,9 @@ namespace ofxRobotArm {
             ofMatrix4x4 forward(vector<double> pose);
             vector<vector<double> > inverse(ofMatrix4x4 pose);
         
-            double *toIK(ofMatrix4x4 input)
-            {
-                double *T = new double[16];
-                for (int i = 0; i < 4; i++)
-                {
-                    T[i] = (double)input._mat[i][0];
-                    T[i + (4)] = (double)input._mat[i][1];
-                    T[i + (8)] = (double)input._mat[i][2];
-                    T[i + (12)] = (double)input._mat[i][3];
-                }
-                return T;
-            };
-            
-            ofMatrix4x4 toOF(double *T)
-            {
-                ofMatrix4x4 output;
-                for (int i = 0; i < 4; i++)
-                {
-                    output._mat[i][0] = T[i];
-                    output._mat[i][1] = T[i + (4)];
-                    output._mat[i][2] = T[i + (8)];
-                    output._mat[i][3] = T[i + (12)];
-                }
-                return output;
-            };
+            math::Mat4d toIK(const ofMatrix4x4 & input){ return math::toMath(input); };
+            ofMatrix4x4 toOF(const math::Mat4d & T){ return math::toOF(T); };
 
-        
         private:
             double d1, a2, a3, d4, d5, d6;
     };
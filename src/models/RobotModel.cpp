@@ -7,6 +7,7 @@
 //
 
 #include "RobotModel.h"
+#include "Trace.h"
 using namespace ofxRobotArm;
 RobotModel::RobotModel()
 {
@@ -218,6 +219,7 @@ Pose RobotModel::getModifiedTCPPose()
 
 void RobotModel::setPose(vector<double> pose)
 {
+    RA_TRACE_SCOPE("model.setPose");
     
     int i = 0;
     for (auto pdouble : pose)
@@ -0,0 +1,201 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "JointTrajectory.h"
+using namespace ofxRobotArm;
+
+static const char TRAJECTORY_MAGIC[8] = {'O', 'R', 'A', 'T', 'R', 'A', 'J', '\0'};
+
+JointTrajectory::JointTrajectory(){
+    robotType = UR5;
+    numJoints = 6;
+}
+
+JointTrajectory::JointTrajectory(RobotType type, int numJoints){
+    setup(type, numJoints);
+}
+
+JointTrajectory::~JointTrajectory(){
+
+}
+
+void JointTrajectory::setup(RobotType type, int numJoints){
+    robotType = type;
+    this->numJoints = numJoints;
+    clear();
+}
+
+void JointTrajectory::clear(){
+    times.clear();
+    joints.clear();
+}
+
+void JointTrajectory::reserve(size_t numSamples){
+    times.reserve(numSamples);
+    joints.reserve(numSamples * numJoints);
+}
+
+void JointTrajectory::addSample(double time, const double * pose){
+    if(times.size() && time < times.back()){
+        time = times.back();
+    }
+    times.push_back(time);
+    for(int i = 0; i < numJoints; i++){
+        joints.push_back((float)pose[i]);
+    }
+}
+
+void JointTrajectory::addSample(double time, const vector<double> & pose){
+    if((int)pose.size() < numJoints){
+        ofLogWarning("JointTrajectory") << "addSample: got " << pose.size() << " joints, expected " << numJoints;
+        return;
+    }
+    addSample(time, pose.data());
+}
+
+vector<double> JointTrajectory::getPoseAt(double time) const{
+    vector<double> ret;
+    getPoseAt(time, ret);
+    return ret;
+}
+
+void JointTrajectory::getPoseAt(double time, vector<double> & pose) const{
+    pose.resize(numJoints);
+    if(times.empty()){
+        std::fill(pose.begin(), pose.end(), 0.0);
+        return;
+    }
+
+    // index of the first sample after time
+    size_t hi = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+    if(hi == 0){
+        for(int i = 0; i < numJoints; i++) pose[i] = joints[i];
+        return;
+    }
+    if(hi >= times.size()){
+        const float * last = &joints[(times.size() - 1) * numJoints];
+        for(int i = 0; i < numJoints; i++) pose[i] = last[i];
+        return;
+    }
+
+    size_t lo = hi - 1;
+    double span = times[hi] - times[lo];
+    double t = span > 0 ? (time - times[lo]) / span : 0.0;
+    const float * a = &joints[lo * numJoints];
+    const float * b = &joints[hi * numJoints];
+    for(int i = 0; i < numJoints; i++){
+        pose[i] = a[i] + (b[i] - a[i]) * t;
+    }
+}
+
+double JointTrajectory::getDuration() const{
+    if(times.empty()) return 0;
+    return times.back() - times.front();
+}
+
+size_t JointTrajectory::size() const{
+    return times.size();
+}
+
+int JointTrajectory::getNumJoints() const{
+    return numJoints;
+}
+
+RobotType JointTrajectory::getRobotType() const{
+    return robotType;
+}
+
+double JointTrajectory::getTime(size_t index) const{
+    return times[index];
+}
+
+bool JointTrajectory::save(string path) const{
+    ofFile file(path, ofFile::WriteOnly, true);
+    if(!file.is_open()){
+        ofLogError("JointTrajectory") << "save: could not open " << path;
+        return false;
+    }
+    FileHeader header;
+    memcpy(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic));
+    header.version = FILE_VERSION;
+    header.robotType = robotType;
+    header.numJoints = numJoints;
+    header.numSamples = times.size();
+    file.write((const char *)&header, sizeof(header));
+
+    double t0 = times.empty() ? 0 : times.front();
+    for(size_t s = 0; s < times.size(); s++){
+        double t = times[s] - t0;
+        file.write((const char *)&t, sizeof(t));
+        file.write((const char *)&joints[s * numJoints], sizeof(float) * numJoints);
+    }
+    return file.good();
+}
+
+bool JointTrajectory::load(string path){
+    ofFile file(path, ofFile::ReadOnly, true);
+    if(!file.is_open()){
+        ofLogError("JointTrajectory") << "load: could not open " << path;
+        return false;
+    }
+    FileHeader header;
+    file.read((char *)&header, sizeof(header));
+    if(!file.good() || memcmp(header.magic, TRAJECTORY_MAGIC, sizeof(header.magic)) != 0){
+        ofLogError("JointTrajectory") << "load: " << path << " is not a trajectory file";
+        return false;
+    }
+    if(header.version != FILE_VERSION || header.numJoints == 0 || header.numJoints > 32){
+        ofLogError("JointTrajectory") << "load: unsupported version " << header.version << " or joint count " << header.numJoints;
+        return false;
+    }
+
+    setup((RobotType)header.robotType, header.numJoints);
+    times.resize(header.numSamples);
+    joints.resize((size_t)header.numSamples * numJoints);
+    for(size_t s = 0; s < header.numSamples; s++){
+        file.read((char *)&times[s], sizeof(double));
+        file.read((char *)&joints[s * numJoints], sizeof(float) * numJoints);
+        if(!file.good()){
+            ofLogWarning("JointTrajectory") << "load: " << path << " truncated after " << s << " samples";
+            times.resize(s);
+            joints.resize(s * numJoints);
+            break;
+        }
+    }
+    return true;
+}
+
+bool JointTrajectory::sampleTrapezoid(double & time, double length, double v0, double v1, double cap, double accel, double sampleTime, const std::function<void(double, double)> & sample){
+    double peak = MIN(cap, sqrt((2 * accel * length + v0 * v0 + v1 * v1) * 0.5));
+    peak = MAX(peak, MAX(v0, v1));
+    if(peak <= 0){
+        return false;
+    }
+    double accelTime = (peak - v0) / accel;
+    double accelDistance = (peak * peak - v0 * v0) / (2 * accel);
+    double decelTime = (peak - v1) / accel;
+    double decelDistance = (peak * peak - v1 * v1) / (2 * accel);
+    double cruiseDistance = MAX(0.0, length - accelDistance - decelDistance);
+    double cruiseTime = cruiseDistance / peak;
+
+    if(sampleTime > 0){
+        for(double t = sampleTime; t < accelTime; t += sampleTime){
+            sample(time + t, v0 * t + 0.5 * accel * t * t);
+        }
+    }
+    if(accelTime > 0 && cruiseTime + decelTime > 0){
+        sample(time + accelTime, accelDistance);
+    }
+    double decelStart = accelTime + cruiseTime;
+    double decelFrom = accelDistance + cruiseDistance;
+    if(cruiseTime > 0 && decelTime > 0){
+        sample(time + decelStart, decelFrom);
+    }
+    if(sampleTime > 0){
+        for(double t = sampleTime; t < decelTime; t += sampleTime){
+            sample(time + decelStart + t, decelFrom + peak * t - 0.5 * accel * t * t);
+        }
+    }
+    time += decelStart + decelTime;
+    return true;
+}
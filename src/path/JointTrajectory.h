@@ -0,0 +1,66 @@
+//
+//  JointTrajectory.h
+//  ofxRobotArm
+//
+//  Timestamped joint samples in the same binary format for every arm brand.
+//  Joints are stored in radians, times in seconds from the first sample.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "RobotConstants.hpp"
+namespace ofxRobotArm{
+    class JointTrajectory{
+    public:
+        /// \brief on-disk header, followed by numSamples records of
+        /// one double time plus numJoints floats
+        struct FileHeader{
+            char magic[8];
+            uint32_t version;
+            int32_t robotType;
+            uint32_t numJoints;
+            uint32_t numSamples;
+        };
+        static const uint32_t FILE_VERSION = 1;
+
+        JointTrajectory();
+        JointTrajectory(RobotType type, int numJoints);
+        ~JointTrajectory();
+
+        void setup(RobotType type, int numJoints);
+        void clear();
+        void reserve(size_t numSamples);
+
+        /// \brief append a sample, times must not go backwards
+        void addSample(double time, const double * joints);
+        void addSample(double time, const vector<double> & joints);
+
+        /// \brief linearly interpolated joints at time (clamped to the ends)
+        vector<double> getPoseAt(double time) const;
+        void getPoseAt(double time, vector<double> & joints) const;
+
+        double getDuration() const;
+        size_t size() const;
+        int getNumJoints() const;
+        RobotType getRobotType() const;
+        double getTime(size_t index) const;
+
+        bool save(string path) const;
+        bool load(string path);
+
+        /// \brief one segment of a trapezoidal profile along a path parameter:
+        /// from speed v0 up to at most cap at accel, cruise, then down to v1 over
+        /// length. sample(time, distance) is called every sampleTime on the ramps
+        /// (JointTrajectory interpolates linearly, so cruising needs only its
+        /// ends) and time is moved to the segment's end. False if the segment
+        /// can't move, otherwise the caller adds the end sample at time.
+        static bool sampleTrapezoid(double & time, double length, double v0, double v1, double cap, double accel, double sampleTime, const std::function<void(double, double)> & sample);
+
+    protected:
+        RobotType robotType;
+        int numJoints;
+        vector<double> times;
+        vector<float> joints;
+    };
+}
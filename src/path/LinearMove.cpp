@@ -0,0 +1,237 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "LinearMove.h"
+#include "RobotMathOF.h"
+#include "Trace.h"
+
+using namespace ofxRobotArm;
+
+namespace{
+    // interior points of a segment checked against the line
+    const double CHECK_POINTS[] = {0.25, 0.5, 0.75};
+
+    void lerp(const vector<double> & a, const vector<double> & b, double t, vector<double> & out){
+        out.resize(a.size());
+        for(size_t j = 0; j < a.size(); j++){
+            out[j] = a[j] + (b[j] - a[j]) * t;
+        }
+    }
+}
+
+LinearMove::LinearMove(){
+}
+
+LinearMove::~LinearMove(){
+}
+
+void LinearMove::setup(InverseKinematics * ik){
+    this->ik = ik;
+}
+
+void LinearMove::setTolerance(double meters, double radians){
+    positionTolerance = meters;
+    orientationTolerance = radians;
+}
+
+void LinearMove::setSpeed(double metersPerSecond, double radiansPerSecond){
+    maxSpeed = metersPerSecond;
+    maxAngularSpeed = radiansPerSecond;
+}
+
+void LinearMove::setAcceleration(double metersPerSecond2, double radiansPerSecond2){
+    maxAccel = metersPerSecond2;
+    maxAngularAccel = radiansPerSecond2;
+}
+
+void LinearMove::setInitialStep(double meters, double radians){
+    initialStep = meters;
+    initialAngleStep = radians;
+}
+
+void LinearMove::setMaxDepth(int depth){
+    maxDepth = depth;
+}
+
+void LinearMove::setSampleTime(double seconds){
+    sampleTime = seconds;
+}
+
+int LinearMove::getNumSolves(){
+    return numSolves;
+}
+
+int LinearMove::getNumKnots(){
+    return knots.size();
+}
+
+bool LinearMove::plan(const vector<double> & start, const Pose & target, JointTrajectory & out){
+    return plan(start, math::toMath(target), out);
+}
+
+bool LinearMove::plan(const vector<double> & start, const math::Transformd & target, JointTrajectory & out){
+    RA_TRACE_SCOPE("movel.plan");
+    out.setup(ik ? ik->robotType : UR5, start.size());
+    knots.clear();
+    numSolves = 0;
+    if(!ik || ik->ikType == RELAXED){
+        ofLogError("LinearMove") << "plan: needs an InverseKinematics set up with HK, SW or NUMERIC";
+        return false;
+    }
+
+    math::Transformd from = math::Transformd::fromMatrix(ik->forward(start));
+    startPosition = from.translation;
+    startRotation = from.rotation.normalized();
+    endPosition = target.translation;
+    endRotation = target.rotation.normalized();
+    length = (endPosition - startPosition).length();
+    angle = startRotation.angleTo(endRotation);
+
+    // first pass, each sample seeded by the one before so the branch carries along the line
+    int steps = 1;
+    if(initialStep > 0){
+        steps = MAX(steps, (int)ceil(length / initialStep));
+    }
+    if(initialAngleStep > 0){
+        steps = MAX(steps, (int)ceil(angle / initialAngleStep));
+    }
+    coarse.resize(steps + 1);
+    coarse[0].s = 0;
+    coarse[0].q = start;
+    for(int i = 1; i <= steps; i++){
+        coarse[i].s = (double)i / steps;
+        if(!solveAt(coarse[i].s, coarse[i - 1].q, coarse[i].q)){
+            knots.clear();
+            return false;
+        }
+    }
+
+    knots.push_back(coarse[0]);
+    for(int i = 0; i < steps; i++){
+        if(!refine(coarse[i], coarse[i + 1], 0)){
+            knots.clear();
+            return false;
+        }
+    }
+
+    timeParameterize(out);
+    return true;
+}
+
+math::Transformd LinearMove::getPoseAt(double s){
+    return math::Transformd(math::Quatd::slerp(startRotation, endRotation, s), startPosition + (endPosition - startPosition) * s);
+}
+
+bool LinearMove::solveAt(double s, const vector<double> & seed, vector<double> & q){
+    math::Transformd pose = getPoseAt(s);
+    target.position = math::toOF(pose.translation);
+    target.orientation = math::toOF(pose.rotation);
+    ik->solve(target, target, sols);
+    numSolves++;
+    if(sols.empty()){
+        ofLogError("LinearMove") << "no IK solution at " << (s * 100) << "% of the line, target out of reach";
+        return false;
+    }
+    if(ik->selectSolution(sols, seed, q) < 0){
+        ofLogError("LinearMove") << "no IK solution within the joint limits at " << (s * 100) << "% of the line";
+        return false;
+    }
+    return true;
+}
+
+bool LinearMove::isOnLine(const Knot & a, const Knot & b){
+    for(double t : CHECK_POINTS){
+        lerp(a.q, b.q, t, interpolated);
+        math::Transformd actual = math::Transformd::fromMatrix(ik->forward(interpolated));
+        math::Transformd expected = getPoseAt(a.s + (b.s - a.s) * t);
+        if((actual.translation - expected.translation).length() > positionTolerance ||
+           actual.rotation.angleTo(expected.rotation) > orientationTolerance){
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LinearMove::refine(const Knot & a, const Knot & b, int depth){
+    // a is already the last knot; appends whatever is needed up to and including b
+    if(isOnLine(a, b)){
+        knots.push_back(b);
+        return true;
+    }
+    if(depth >= maxDepth){
+        ofLogError("LinearMove") << "could not stay within tolerance between " << (a.s * 100) << "% and " << (b.s * 100) << "% of the line, singular or changing branch";
+        return false;
+    }
+    Knot mid;
+    mid.s = (a.s + b.s) * 0.5;
+    lerp(a.q, b.q, 0.5, interpolated);
+    if(!solveAt(mid.s, interpolated, mid.q)){
+        return false;
+    }
+    return refine(a, mid, depth + 1) && refine(mid, b, depth + 1);
+}
+
+void LinearMove::addSample(JointTrajectory & out, const Knot & a, const Knot & b, double time, double ds){
+    double span = b.s - a.s;
+    lerp(a.q, b.q, span > 0 ? ofClamp(ds / span, 0, 1) : 1, interpolated);
+    out.addSample(time, interpolated);
+}
+
+void LinearMove::timeParameterize(JointTrajectory & out){
+    // the profile runs on s in [0, 1], so the TCP limits become limits on ds/dt
+    double speed = std::numeric_limits<double>::max();
+    double accel = std::numeric_limits<double>::max();
+    if(length > 1e-9){
+        speed = MIN(speed, maxSpeed / length);
+        accel = MIN(accel, maxAccel / length);
+    }
+    if(angle > 1e-9){
+        speed = MIN(speed, maxAngularSpeed / angle);
+        accel = MIN(accel, maxAngularAccel / angle);
+    }
+
+    out.reserve(knots.size() * 4);
+    out.addSample(0, knots[0].q);
+    size_t n = knots.size();
+    if(n < 2 || speed == std::numeric_limits<double>::max()){
+        return;
+    }
+
+    // each segment is also held to the joint speeds it needs at that ds/dt
+    segmentCaps.resize(n - 1);
+    for(size_t i = 0; i + 1 < n; i++){
+        double ds = knots[i + 1].s - knots[i].s;
+        double cap = speed;
+        for(size_t j = 0; j < knots[i].q.size() && j < ik->maxJointSpeeds.size(); j++){
+            double dq = fabs(knots[i + 1].q[j] - knots[i].q[j]);
+            if(dq > 0 && ik->maxJointSpeeds[j] > 0){
+                cap = MIN(cap, ik->maxJointSpeeds[j] * ds / dq);
+            }
+        }
+        segmentCaps[i] = cap;
+    }
+
+    // fastest speed at each knot that can still start and stop in time
+    knotSpeeds.assign(n, 0);
+    for(size_t i = 1; i + 1 < n; i++){
+        knotSpeeds[i] = MIN(segmentCaps[i - 1], segmentCaps[i]);
+    }
+    for(size_t i = 0; i + 1 < n; i++){
+        double ds = knots[i + 1].s - knots[i].s;
+        knotSpeeds[i + 1] = MIN(knotSpeeds[i + 1], sqrt(knotSpeeds[i] * knotSpeeds[i] + 2 * accel * ds));
+    }
+    for(size_t i = n - 1; i > 0; i--){
+        double ds = knots[i].s - knots[i - 1].s;
+        knotSpeeds[i - 1] = MIN(knotSpeeds[i - 1], sqrt(knotSpeeds[i] * knotSpeeds[i] + 2 * accel * ds));
+    }
+
+    double time = 0;
+    for(size_t i = 0; i + 1 < n; i++){
+        const Knot & a = knots[i];
+        const Knot & b = knots[i + 1];
+        auto sample = [&](double t, double ds){ addSample(out, a, b, t, ds); };
+        if(JointTrajectory::sampleTrapezoid(time, b.s - a.s, knotSpeeds[i], knotSpeeds[i + 1], segmentCaps[i], accel, sampleTime, sample)){
+            out.addSample(time, b.q);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+//
+//  LinearMove.h
+//  ofxRobotArm
+//
+//  Plans a straight line TCP move (MoveL) as a JointTrajectory that
+//  TrajectoryPlayer can stream to any driver.
+//
+//  The segment from the start pose to the target is first solved at a
+//  coarse spacing, each sample seeded by the one before so the arm stays on
+//  one IK branch. Between two solved samples the arm moves linearly in
+//  joint space; where forward kinematics of that interpolation strays from
+//  the line by more than the tolerance, the midpoint is solved and both
+//  halves are checked again. Straight-ish stretches stay at the coarse
+//  spacing, only wrist-heavy or near-singular parts get dense.
+//
+//  Positions in meters, in the IK frame (the same frame as
+//  InverseKinematics::forward). Needs HK, SW or NUMERIC,
+//  RELAXED has no forward kinematics to check against.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "InverseKinematics.h"
+#include "JointTrajectory.h"
+#include "RobotMath.h"
+
+namespace ofxRobotArm{
+    class LinearMove{
+    public:
+        LinearMove();
+        ~LinearMove();
+
+        void setup(InverseKinematics * ik);
+
+        /// \brief largest distance (m) and angle (rad) the arm may stray from the line
+        void setTolerance(double meters, double radians);
+        /// \brief TCP speed limits along the line; joints are also held to the
+        /// IK's max joint speeds
+        void setSpeed(double metersPerSecond, double radiansPerSecond);
+        void setAcceleration(double metersPerSecond2, double radiansPerSecond2);
+        /// \brief spacing of the first pass, before any subdivision
+        void setInitialStep(double meters, double radians);
+        /// \brief subdivisions allowed below a first pass sample before the move is
+        /// given up on (a singularity or branch change on the line)
+        void setMaxDepth(int depth);
+        /// \brief time between samples written while accelerating or decelerating,
+        /// cruising stretches only get the solved samples
+        void setSampleTime(double seconds);
+
+        /// \brief plans from joints start to target, replacing out. Returns false
+        /// (and leaves out empty) if some part of the line can't be reached on
+        /// the branch of start within the joint limits.
+        bool plan(const vector<double> & start, const math::Transformd & target, JointTrajectory & out);
+        bool plan(const vector<double> & start, const Pose & target, JointTrajectory & out);
+
+        /// \brief IK solves of the last plan
+        int getNumSolves();
+        /// \brief solved samples the last plan kept on the line
+        int getNumKnots();
+
+    protected:
+        struct Knot{
+            double s;
+            vector<double> q;
+        };
+
+        math::Transformd getPoseAt(double s);
+        bool solveAt(double s, const vector<double> & seed, vector<double> & q);
+        bool isOnLine(const Knot & a, const Knot & b);
+        bool refine(const Knot & a, const Knot & b, int depth);
+        void timeParameterize(JointTrajectory & out);
+        void addSample(JointTrajectory & out, const Knot & a, const Knot & b, double time, double ds);
+
+        InverseKinematics * ik = nullptr;
+
+        double positionTolerance = 0.0005;
+        double orientationTolerance = 0.005;
+        double maxSpeed = 0.25;
+        double maxAngularSpeed = 1.0;
+        double maxAccel = 1.0;
+        double maxAngularAccel = 4.0;
+        double initialStep = 0.05;
+        double initialAngleStep = 0.25;
+        int maxDepth = 8;
+        double sampleTime = 0.008;
+
+        math::Vec3d startPosition, endPosition;
+        math::Quatd startRotation, endRotation;
+        double length = 0;
+        double angle = 0;
+
+        vector<Knot> coarse;
+        vector<Knot> knots;
+        vector<double> knotSpeeds;
+        vector<double> segmentCaps;
+        vector<vector<double>> sols;
+        vector<double> interpolated;
+        Pose target;
+        int numSolves = 0;
+    };
+}
@@ -0,0 +1,418 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "MotionPlanner.h"
+#include "Trace.h"
+
+using namespace ofxRobotArm;
+
+namespace{
+    // below this many checks an edge isn't worth waking the pool for
+    const int PARALLEL_MIN_CHECKS = 32;
+
+    double distance(const double * a, const double * b, int n){
+        double d = 0;
+        for(int j = 0; j < n; j++){
+            d += (b[j] - a[j]) * (b[j] - a[j]);
+        }
+        return sqrt(d);
+    }
+}
+
+MotionPlanner::MotionPlanner() : numChecks(0){
+}
+
+MotionPlanner::~MotionPlanner(){
+}
+
+void MotionPlanner::setup(const CollisionChecker * checker, RobotType type, ThreadPool * pool){
+    this->checker = checker;
+    this->pool = pool ? pool : &ThreadPool::getDefault();
+    robotType = type;
+    const KinematicChain * chain = checker ? checker->getChain() : nullptr;
+    numJoints = chain ? chain->getNumJoints() : 0;
+    if(chain){
+        chain->getLimits(lower, upper);
+    }
+    maxJointSpeeds.assign(numJoints, PI);
+    if(chain){
+        for(const auto & joint : chain->getJoints()){
+            if(joint.index >= 0 && joint.velocity > 0){
+                maxJointSpeeds[joint.index] = joint.velocity;
+            }
+        }
+    }
+    scratch.resize(this->pool->getNumWorkers());
+    interpolated.assign(this->pool->getNumWorkers(), vector<double>(numJoints, 0));
+    step.assign(numJoints, 0);
+    for(auto & tree : trees){
+        tree.numJoints = numJoints;
+    }
+}
+
+void MotionPlanner::setTimeBudget(double seconds){
+    timeBudget = seconds;
+}
+
+void MotionPlanner::setMaxStep(double radians){
+    maxStep = radians;
+}
+
+void MotionPlanner::setResolution(double radians){
+    resolution = MAX(radians, 1e-4);
+}
+
+void MotionPlanner::setShortcutIterations(int iterations){
+    shortcutIterations = iterations;
+}
+
+void MotionPlanner::setSpeed(double fraction){
+    speed = fraction;
+}
+
+void MotionPlanner::setAcceleration(double radiansPerSecond2){
+    acceleration = radiansPerSecond2;
+}
+
+void MotionPlanner::setSampleTime(double seconds){
+    sampleTime = seconds;
+}
+
+void MotionPlanner::setRandomSeed(uint32_t seed){
+    randomSeed = seed;
+}
+
+const vector<vector<double>> & MotionPlanner::getWaypoints(){
+    return waypoints;
+}
+
+int MotionPlanner::getNumNodes(){
+    return trees[0].size() + trees[1].size();
+}
+
+int MotionPlanner::getNumChecks(){
+    return numChecks;
+}
+
+double MotionPlanner::getPlanningTime(){
+    return planningTime;
+}
+
+bool MotionPlanner::plan(const vector<double> & start, const vector<double> & goal, JointTrajectory & out){
+    RA_TRACE_SCOPE("planner.plan");
+    auto begin = std::chrono::steady_clock::now();
+    deadline = begin + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeBudget));
+    out.setup(robotType, numJoints);
+    waypoints.clear();
+    for(auto & tree : trees){
+        tree.q.clear();
+        tree.parent.clear();
+    }
+    numChecks = 0;
+    planningTime = 0;
+
+    if(!checker || numJoints == 0){
+        ofLogError("MotionPlanner") << "plan: no collision checker, call setup first";
+        return false;
+    }
+    if((int)start.size() < numJoints || (int)goal.size() < numJoints){
+        ofLogError("MotionPlanner") << "plan: start and goal need " << numJoints << " joints";
+        return false;
+    }
+    vector<double> from(start.begin(), start.begin() + numJoints);
+    vector<double> to(goal.begin(), goal.begin() + numJoints);
+    if(!checker->isValid(from.data(), scratch[0])){
+        ofLogError("MotionPlanner") << "plan: the start pose is in collision";
+        return false;
+    }
+    if(!checker->isValid(to.data(), scratch[0])){
+        ofLogError("MotionPlanner") << "plan: the goal pose is in collision";
+        return false;
+    }
+
+    rng.seed(randomSeed);
+    if(isEdgeValid(from.data(), to.data())){
+        waypoints = {from, to};
+    }else if(search(from, to)){
+        shortcut();
+    }else{
+        planningTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        ofLogError("MotionPlanner") << "plan: no path found in " << planningTime << " s (" << getNumNodes() << " nodes)";
+        return false;
+    }
+    planningTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    timeParameterize(out);
+    return true;
+}
+
+bool MotionPlanner::isExpired(){
+    return std::chrono::steady_clock::now() > deadline;
+}
+
+bool MotionPlanner::isEdgeValid(const double * a, const double * b){
+    // a is already known to be valid, checks up to and including b
+    double maxDelta = 0;
+    for(int j = 0; j < numJoints; j++){
+        maxDelta = MAX(maxDelta, fabs(b[j] - a[j]));
+    }
+    int n = MAX(1, (int)ceil(maxDelta / resolution));
+
+    // bisecting order: the middle, then the quarters, and so on
+    order.clear();
+    int top = 1;
+    while(top * 2 <= n){
+        top *= 2;
+    }
+    for(int s = top; s >= 1; s /= 2){
+        for(int k = s; k <= n; k += 2 * s){
+            order.push_back(k);
+        }
+    }
+
+    auto check = [&](int k, int worker){
+        vector<double> & q = interpolated[worker];
+        double t = (double)k / n;
+        for(int j = 0; j < numJoints; j++){
+            q[j] = a[j] + (b[j] - a[j]) * t;
+        }
+        numChecks++;
+        return checker->isValid(q.data(), scratch[worker]);
+    };
+
+    if(n < PARALLEL_MIN_CHECKS || pool->getNumWorkers() == 1){
+        for(int k : order){
+            if(!check(k, 0)){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::atomic<bool> hit(false);
+    pool->parallelFor(order.size(), [&](int index, int worker){
+        if(hit.load(std::memory_order_relaxed)){
+            return;
+        }
+        if(!check(order[index], worker)){
+            hit = true;
+        }
+    });
+    return !hit;
+}
+
+void MotionPlanner::sample(vector<double> & q){
+    for(int j = 0; j < numJoints; j++){
+        double lo = std::isfinite(lower[j]) ? lower[j] : -PI;
+        double hi = std::isfinite(upper[j]) ? upper[j] : PI;
+        q[j] = std::uniform_real_distribution<double>(lo, hi)(rng);
+    }
+}
+
+int MotionPlanner::nearest(const Tree & tree, const double * q){
+    int best = 0;
+    double bestDistance = std::numeric_limits<double>::max();
+    for(int i = 0; i < tree.size(); i++){
+        const double * p = tree.at(i);
+        double d = 0;
+        for(int j = 0; j < numJoints && d < bestDistance; j++){
+            d += (q[j] - p[j]) * (q[j] - p[j]);
+        }
+        if(d < bestDistance){
+            bestDistance = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+MotionPlanner::ExtendResult MotionPlanner::extend(Tree & tree, const double * target){
+    int near = nearest(tree, target);
+    const double * from = tree.at(near);
+    double d = distance(from, target, numJoints);
+    ExtendResult result = REACHED;
+    double t = 1;
+    if(d > maxStep){
+        t = maxStep / d;
+        result = ADVANCED;
+    }
+    for(int j = 0; j < numJoints; j++){
+        step[j] = from[j] + (target[j] - from[j]) * t;
+    }
+    if(!isEdgeValid(from, step.data())){
+        return TRAPPED;
+    }
+    tree.q.insert(tree.q.end(), step.begin(), step.end());
+    tree.parent.push_back(near);
+    return result;
+}
+
+MotionPlanner::ExtendResult MotionPlanner::connect(Tree & tree, const double * target){
+    ExtendResult result;
+    do{
+        result = extend(tree, target);
+    }while(result == ADVANCED && !isExpired());
+    return result;
+}
+
+bool MotionPlanner::search(const vector<double> & start, const vector<double> & goal){
+    RA_TRACE_SCOPE("planner.search");
+    trees[0].q = start;
+    trees[0].parent.assign(1, -1);
+    trees[1].q = goal;
+    trees[1].parent.assign(1, -1);
+
+    Tree * a = &trees[0];
+    Tree * b = &trees[1];
+    vector<double> target(numJoints);
+    while(!isExpired()){
+        sample(target);
+        if(extend(*a, target.data()) != TRAPPED){
+            // b's copy of the new node, a isn't touched while b grows towards it
+            std::copy(a->at(a->size() - 1), a->at(a->size() - 1) + numJoints, target.begin());
+            if(connect(*b, target.data()) == REACHED){
+                // both trees end in the node where they met
+                for(int i = trees[0].size() - 1; i >= 0; i = trees[0].parent[i]){
+                    waypoints.emplace_back(trees[0].at(i), trees[0].at(i) + numJoints);
+                }
+                std::reverse(waypoints.begin(), waypoints.end());
+                for(int i = trees[1].parent.back(); i >= 0; i = trees[1].parent[i]){
+                    waypoints.emplace_back(trees[1].at(i), trees[1].at(i) + numJoints);
+                }
+                return true;
+            }
+        }
+        std::swap(a, b);
+    }
+    return false;
+}
+
+void MotionPlanner::shortcut(){
+    RA_TRACE_SCOPE("planner.shortcut");
+    // greedy pass, from each waypoint straight to the furthest one it can see
+    vector<vector<double>> path;
+    path.push_back(waypoints[0]);
+    int last = waypoints.size() - 1;
+    int i = 0;
+    while(i < last){
+        int j = last;
+        for(; j > i + 1; j--){
+            if(isExpired()){
+                j = i + 1;
+                break;
+            }
+            if(isEdgeValid(waypoints[i].data(), waypoints[j].data())){
+                break;
+            }
+        }
+        path.push_back(waypoints[j]);
+        i = j;
+    }
+    waypoints.swap(path);
+
+    // then random shortcuts between points anywhere along the segments
+    vector<double> lengths;
+    vector<double> p0(numJoints), p1(numJoints);
+    for(int it = 0; it < shortcutIterations && waypoints.size() > 2 && !isExpired(); it++){
+        lengths.assign(1, 0);
+        for(size_t k = 0; k + 1 < waypoints.size(); k++){
+            lengths.push_back(lengths.back() + distance(waypoints[k].data(), waypoints[k + 1].data(), numJoints));
+        }
+        std::uniform_real_distribution<double> along(0, lengths.back());
+        double d0 = along(rng);
+        double d1 = along(rng);
+        if(d0 > d1){
+            std::swap(d0, d1);
+        }
+        int s0 = std::upper_bound(lengths.begin(), lengths.end(), d0) - lengths.begin() - 1;
+        int s1 = std::upper_bound(lengths.begin(), lengths.end(), d1) - lengths.begin() - 1;
+        s0 = ofClamp(s0, 0, (int)waypoints.size() - 2);
+        s1 = ofClamp(s1, 0, (int)waypoints.size() - 2);
+        if(s0 == s1){
+            continue;
+        }
+        double t0 = (d0 - lengths[s0]) / MAX(lengths[s0 + 1] - lengths[s0], 1e-12);
+        double t1 = (d1 - lengths[s1]) / MAX(lengths[s1 + 1] - lengths[s1], 1e-12);
+        for(int j = 0; j < numJoints; j++){
+            p0[j] = waypoints[s0][j] + (waypoints[s0 + 1][j] - waypoints[s0][j]) * t0;
+            p1[j] = waypoints[s1][j] + (waypoints[s1 + 1][j] - waypoints[s1][j]) * t1;
+        }
+        if(!isEdgeValid(p0.data(), p1.data())){
+            continue;
+        }
+        // waypoints s0 + 1 .. s1 are cut, the points on either side take their place
+        waypoints.erase(waypoints.begin() + s0 + 1, waypoints.begin() + s1 + 1);
+        waypoints.insert(waypoints.begin() + s0 + 1, {p0, p1});
+    }
+}
+
+void MotionPlanner::timeParameterize(JointTrajectory & out){
+    // the path parameter is the Euclidean joint distance along the waypoints,
+    // each segment turns the joint limits into limits on its own speed
+    vector<const vector<double> *> knots;
+    for(const auto & w : waypoints){
+        if(knots.empty() || distance(knots.back()->data(), w.data(), numJoints) > 1e-9){
+            knots.push_back(&w);
+        }
+    }
+    out.reserve(knots.size() * 4);
+    out.addSample(0, *knots[0]);
+    size_t n = knots.size();
+    if(n < 2){
+        return;
+    }
+
+    vector<double> lengths(n - 1), caps(n - 1), accels(n - 1);
+    vector<vector<double>> directions(n - 1, vector<double>(numJoints));
+    for(size_t i = 0; i + 1 < n; i++){
+        const vector<double> & a = *knots[i];
+        const vector<double> & b = *knots[i + 1];
+        lengths[i] = distance(a.data(), b.data(), numJoints);
+        caps[i] = std::numeric_limits<double>::max();
+        double largest = 0;
+        for(int j = 0; j < numJoints; j++){
+            double u = (b[j] - a[j]) / lengths[i];
+            directions[i][j] = u;
+            if(fabs(u) > 1e-9){
+                caps[i] = MIN(caps[i], maxJointSpeeds[j] * speed / fabs(u));
+            }
+            largest = MAX(largest, fabs(u));
+        }
+        accels[i] = acceleration / largest;
+    }
+
+    // a corner changes the joint velocities at once, keep that jump within one sample's acceleration
+    vector<double> knotSpeeds(n, 0);
+    for(size_t i = 1; i + 1 < n; i++){
+        double v = MIN(caps[i - 1], caps[i]);
+        for(int j = 0; j < numJoints; j++){
+            double du = fabs(directions[i][j] - directions[i - 1][j]);
+            if(du > 1e-9){
+                v = MIN(v, acceleration * sampleTime / du);
+            }
+        }
+        knotSpeeds[i] = v;
+    }
+    for(size_t i = 0; i + 1 < n; i++){
+        knotSpeeds[i + 1] = MIN(knotSpeeds[i + 1], sqrt(knotSpeeds[i] * knotSpeeds[i] + 2 * accels[i] * lengths[i]));
+    }
+    for(size_t i = n - 1; i > 0; i--){
+        knotSpeeds[i - 1] = MIN(knotSpeeds[i - 1], sqrt(knotSpeeds[i] * knotSpeeds[i] + 2 * accels[i - 1] * lengths[i - 1]));
+    }
+
+    vector<double> q(numJoints);
+    auto addSample = [&](size_t i, double time, double d){
+        for(int j = 0; j < numJoints; j++){
+            q[j] = (*knots[i])[j] + directions[i][j] * ofClamp(d, 0, lengths[i]);
+        }
+        out.addSample(time, q);
+    };
+
+    double time = 0;
+    for(size_t i = 0; i + 1 < n; i++){
+        auto sample = [&](double t, double d){ addSample(i, t, d); };
+        if(JointTrajectory::sampleTrapezoid(time, lengths[i], knotSpeeds[i], knotSpeeds[i + 1], caps[i], accels[i], sampleTime, sample)){
+            out.addSample(time, *knots[i + 1]);
+        }
+    }
+}
@@ -0,0 +1,121 @@
+//
+//  MotionPlanner.h
+//  ofxRobotArm
+//
+//  Collision free joint space moves, for transits between toolpaths and
+//  going home where a straight joint lerp could sweep through a fixture.
+//
+//  plan() first tries the straight move. If that collides it grows two
+//  RRT-Connect trees from the start and the goal until they meet, then
+//  shortcuts the path, all within the time budget. The result is time
+//  parameterized into a JointTrajectory for TrajectoryPlayer. The joint
+//  speeds come from the URDF limits, and corners slow down to what the
+//  acceleration allows in one sample.
+//
+//  Edges are checked at setResolution() steps, bisecting so a collision in
+//  the middle shows up early. Long edges (the straight move, shortcuts) are
+//  split across the thread pool. The short tree extensions stay on the
+//  calling thread, where they're cheaper than waking the pool.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "CollisionChecker.h"
+#include "JointTrajectory.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <chrono>
+#include <random>
+
+namespace ofxRobotArm{
+    class MotionPlanner{
+    public:
+        MotionPlanner();
+        ~MotionPlanner();
+
+        /// \brief checker (and its chain) has to outlive the planner, pool
+        /// defaults to ThreadPool::getDefault()
+        void setup(const CollisionChecker * checker, RobotType type = UR5, ThreadPool * pool = nullptr);
+
+        /// \brief wall time for a whole plan() call, the search and the shortcutting
+        void setTimeBudget(double seconds);
+        /// \brief longest tree extension, Euclidean in joint space
+        void setMaxStep(double radians);
+        /// \brief largest single joint change between two checks along an edge,
+        /// the checker's margin has to cover how far the arm moves in between
+        void setResolution(double radians);
+        /// \brief random shortcut attempts after the search, while there is budget left
+        void setShortcutIterations(int iterations);
+        /// \brief fraction of the URDF joint velocity limits, joints without one get PI rad/s
+        void setSpeed(double fraction);
+        void setAcceleration(double radiansPerSecond2);
+        /// \brief spacing of the trajectory samples on the ramps
+        void setSampleTime(double seconds);
+        void setRandomSeed(uint32_t seed);
+
+        /// \brief false if start or goal collides or no path was found in the budget
+        bool plan(const vector<double> & start, const vector<double> & goal, JointTrajectory & out);
+
+        /// \brief of the last plan: the shortcut waypoints, tree sizes, checks and time taken
+        const vector<vector<double>> & getWaypoints();
+        int getNumNodes();
+        int getNumChecks();
+        double getPlanningTime();
+
+    protected:
+        struct Tree{
+            /// \brief numJoints values per node
+            vector<double> q;
+            vector<int> parent;
+            int size() const { return parent.size(); }
+            const double * at(int i) const { return &q[i * numJoints]; }
+            int numJoints = 0;
+        };
+
+        enum ExtendResult{
+            TRAPPED,
+            ADVANCED,
+            REACHED
+        };
+
+        bool isEdgeValid(const double * a, const double * b);
+        bool isExpired();
+        void sample(vector<double> & q);
+        int nearest(const Tree & tree, const double * q);
+        ExtendResult extend(Tree & tree, const double * target);
+        ExtendResult connect(Tree & tree, const double * target);
+        bool search(const vector<double> & start, const vector<double> & goal);
+        void shortcut();
+        void timeParameterize(JointTrajectory & out);
+
+        const CollisionChecker * checker = nullptr;
+        ThreadPool * pool = nullptr;
+        RobotType robotType = UR5;
+        int numJoints = 0;
+        vector<double> lower;
+        vector<double> upper;
+        vector<double> maxJointSpeeds;
+
+        double timeBudget = 0.05;
+        double maxStep = 0.5;
+        double resolution = 0.02;
+        int shortcutIterations = 100;
+        double speed = 0.5;
+        double acceleration = 2.0;
+        double sampleTime = 0.008;
+        uint32_t randomSeed = 1;
+
+        std::mt19937 rng;
+        std::chrono::steady_clock::time_point deadline;
+        vector<CollisionChecker::Scratch> scratch;
+        vector<vector<double>> interpolated;
+        vector<int> order;
+        vector<double> step;
+        Tree trees[2];
+
+        vector<vector<double>> waypoints;
+        std::atomic<int> numChecks;
+        double planningTime = 0;
+    };
+}
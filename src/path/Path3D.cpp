@@ -2,6 +2,7 @@
 // Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
 ////
 #include "Path3D.h"
+#include "Trace.h"
 using namespace ofxRobotArm;
 void Path3D::setup(){
     // set the Z axis as the forward axis by default
@@ -87,6 +88,7 @@ void Path3D::keyPressed(int key){
 
 
 ofMatrix4x4 Path3D::getNextPose(){
+    RA_TRACE_SCOPE("path.sample");
     
     reverse = true;
     if(ptf.framesSize()>0){
@@ -0,0 +1,254 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "AsyncLog.h"
+#include "TickMemory.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+using namespace ofxRobotArm;
+using namespace ofxRobotArm::asynclog;
+
+namespace{
+    // single producer (the owning thread), single consumer (the writer)
+    struct Queue{
+        Queue() : head(0), tail(0){
+            records.resize(QUEUE_CAPACITY);
+        }
+        std::vector<Record> records;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+    };
+
+    class Writer{
+    public:
+        Writer() : bRunning(true), dropped(0), reportedDropped(0), written(0), requested(0){
+            memory::HeapAllowed allow;
+            thread = std::thread(&Writer::run, this);
+        }
+        ~Writer(){
+            bRunning = false;
+            if(thread.joinable()){
+                thread.join();
+            }
+        }
+
+        Queue & queue(){
+            // the registry keeps the queue alive after the thread exits so it still gets drained
+            thread_local std::shared_ptr<Queue> local;
+            if(!local){
+                memory::HeapAllowed allow;
+                std::lock_guard<std::mutex> lock(registryMutex);
+                local = std::make_shared<Queue>();
+                queues.push_back(local);
+            }
+            return *local;
+        }
+
+        void flush(){
+            uint64_t target = requested.load();
+            while(bRunning && written.load() < target){
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        std::atomic<bool> bRunning;
+        std::atomic<uint64_t> dropped;
+        uint64_t reportedDropped;
+        std::atomic<uint64_t> written;
+        std::atomic<uint64_t> requested;
+
+    private:
+        void run(){
+            std::vector<std::shared_ptr<Queue>> local;
+            std::string line;
+            while(true){
+                bool bStop = !bRunning;
+                {
+                    std::lock_guard<std::mutex> lock(registryMutex);
+                    local = queues;
+                }
+                size_t count = 0;
+                for(auto & q : local){
+                    count += drain(*q, line, bStop);
+                }
+                uint64_t d = dropped.load();
+                if(d != reportedDropped){
+                    emit(OF_LOG_WARNING, "AsyncLog", ofToString(d - reportedDropped) + " messages dropped, queue full", bStop);
+                    reportedDropped = d;
+                }
+                if(bStop){
+                    break;
+                }
+                if(count == 0){
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+            }
+        }
+
+        size_t drain(Queue & q, std::string & line, bool bStop){
+            size_t count = 0;
+            uint64_t tail = q.tail.load(std::memory_order_relaxed);
+            uint64_t head = q.head.load(std::memory_order_acquire);
+            while(tail != head){
+                const Record & r = q.records[tail % QUEUE_CAPACITY];
+                format(r, line);
+                emit(r.level, r.module, line, bStop);
+                tail++;
+                q.tail.store(tail, std::memory_order_release);
+                written++;
+                count++;
+            }
+            return count;
+        }
+
+        void emit(ofLogLevel level, const char * module, const std::string & line, bool bStop){
+            if(bStop){
+                // OF's logger may already be torn down at static destruction
+                fprintf(stderr, "[%s] %s\n", module, line.c_str());
+            }else{
+                ofLog(level, module) << line;
+            }
+        }
+
+        static void format(const Record & r, std::string & out){
+            out.clear();
+            const char * f = r.format;
+            int argIndex = 0;
+            char spec[32];
+            char buffer[TEXT_SIZE + 64];
+            while(*f){
+                if(*f != '%'){
+                    out += *f++;
+                    continue;
+                }
+                if(f[1] == '%'){
+                    out += '%';
+                    f += 2;
+                    continue;
+                }
+                // flags, width and precision are kept, length modifiers are replaced
+                const char * start = f++;
+                while(*f && strchr("-+ #0123456789.", *f)) f++;
+                size_t keep = f - start;
+                while(*f && strchr("hlLqjzt", *f)) f++;
+                char conversion = *f;
+                if(!conversion || keep > sizeof(spec) - 4) break;
+                f++;
+
+                if(argIndex >= r.numArgs){
+                    out += "<?>";
+                    continue;
+                }
+                const Arg & a = r.args[argIndex++];
+                memcpy(spec, start, keep);
+                size_t n = keep;
+                int len = 0;
+                switch(conversion){
+                    case 'd': case 'i': case 'c':
+                    case 'u': case 'x': case 'X': case 'o':{
+                        unsigned long long v = a.type == Arg::DOUBLE ? (unsigned long long)(long long)a.d : a.u;
+                        if(conversion == 'c'){
+                            spec[n++] = 'c';
+                            spec[n] = '\0';
+                            len = snprintf(buffer, sizeof(buffer), spec, (int)v);
+                        }else{
+                            spec[n++] = 'l';
+                            spec[n++] = 'l';
+                            spec[n++] = conversion;
+                            spec[n] = '\0';
+                            len = snprintf(buffer, sizeof(buffer), spec, v);
+                        }
+                        break;
+                    }
+                    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':{
+                        double v = a.type == Arg::DOUBLE ? a.d : (a.type == Arg::INT ? (double)a.i : (double)a.u);
+                        spec[n++] = conversion;
+                        spec[n] = '\0';
+                        len = snprintf(buffer, sizeof(buffer), spec, v);
+                        break;
+                    }
+                    case 's':{
+                        spec[n++] = 's';
+                        spec[n] = '\0';
+                        const char * s = a.type == Arg::TEXT ? r.text + a.text : "<?>";
+                        len = snprintf(buffer, sizeof(buffer), spec, s);
+                        break;
+                    }
+                    case 'p':{
+                        len = snprintf(buffer, sizeof(buffer), "%p", a.p);
+                        break;
+                    }
+                    default:
+                        break;
+                }
+                if(len > 0){
+                    out.append(buffer, std::min((size_t)len, sizeof(buffer) - 1));
+                }
+            }
+            if(r.suppressed){
+                out += " (+" + ofToString(r.suppressed) + " suppressed)";
+            }
+        }
+
+        std::thread thread;
+        std::mutex registryMutex;
+        std::vector<std::shared_ptr<Queue>> queues;
+    };
+
+    Writer & writer(){
+        static Writer instance;
+        return instance;
+    }
+}
+
+uint64_t asynclog::nowMicros(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool asynclog::allow(Site & site, uint64_t now, uint32_t intervalMs, uint32_t & suppressed){
+    if(intervalMs == 0){
+        // not rate limited, two threads logging at once both get through
+        suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    uint64_t last = site.lastMicros.load(std::memory_order_relaxed);
+    if(last != 0 && now - last < (uint64_t)intervalMs * 1000){
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if(!site.lastMicros.compare_exchange_strong(last, now, std::memory_order_relaxed)){
+        // another thread took this slot
+        site.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool asynclog::enqueue(Record & record){
+    Writer & w = writer();
+    Queue & q = w.queue();
+    uint64_t head = q.head.load(std::memory_order_relaxed);
+    if(head - q.tail.load(std::memory_order_acquire) >= QUEUE_CAPACITY){
+        w.dropped++;
+        return false;
+    }
+    // only the used part of the text buffer is copied
+    Record & slot = q.records[head % QUEUE_CAPACITY];
+    memcpy(&slot, &record, offsetof(Record, text) + record.textUsed);
+    q.head.store(head + 1, std::memory_order_release);
+    w.requested++;
+    return true;
+}
+
+void asynclog::flush(){
+    writer().flush();
+}
+
+uint64_t asynclog::getNumDropped(){
+    return writer().dropped.load();
+}
@@ -0,0 +1,147 @@
+//
+//  AsyncLog.h
+//  ofxRobotArm
+//
+//  Logging for driver and solver threads. A call only copies the format
+//  string pointer and the raw arguments into the calling thread's queue;
+//  formatting and the actual ofLog happen on a background writer thread,
+//  so a slow terminal can't stall the robot loop.
+//
+//  RA_LOG_NOTICE("URDriver", "uploaded program, %d bytes", size);
+//
+//  The format string must be a literal. Each call site is rate limited
+//  (RA_LOG_RATE_MS, default 100ms, RA_LOG_RATE for a per site interval);
+//  suppressed repeats are counted and reported with the next message from
+//  that site. When a thread's queue is
+//  full the message is dropped and counted, never blocked on.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include <atomic>
+#include <type_traits>
+
+#ifndef RA_LOG_RATE_MS
+#define RA_LOG_RATE_MS 100
+#endif
+
+namespace ofxRobotArm{
+    namespace asynclog{
+        static const int MAX_ARGS = 8;
+        static const int TEXT_SIZE = 192;
+        /// \brief records queued per thread before new ones are dropped
+        static const size_t QUEUE_CAPACITY = 512;
+
+        struct Arg{
+            enum Type : uint8_t { INT, UINT, DOUBLE, TEXT, POINTER };
+            Type type;
+            union{
+                long long i;
+                unsigned long long u;
+                double d;
+                uint16_t text;
+                const void * p;
+            };
+        };
+
+        struct Record{
+            uint64_t micros;
+            ofLogLevel level;
+            const char * module;
+            const char * format;
+            uint32_t suppressed;
+            uint8_t numArgs;
+            uint16_t textUsed;
+            Arg args[MAX_ARGS];
+            char text[TEXT_SIZE];
+        };
+
+        /// \brief per call site state for rate limiting
+        struct Site{
+            std::atomic<uint64_t> lastMicros;
+            std::atomic<uint32_t> suppressed;
+        };
+
+        bool enqueue(Record & record);
+        /// \brief true if the call should go out, folds the suppressed count into suppressed.
+        /// An intervalMs of 0 always goes out.
+        bool allow(Site & site, uint64_t now, uint32_t intervalMs, uint32_t & suppressed);
+        uint64_t nowMicros();
+
+        /// \brief blocks until everything queued so far has been written
+        void flush();
+        uint64_t getNumDropped();
+
+        inline void addText(Record & r, const char * s, size_t len){
+            Arg & a = r.args[r.numArgs++];
+            a.type = Arg::TEXT;
+            a.text = r.textUsed;
+            size_t room = TEXT_SIZE - r.textUsed - 1;
+            if(len > room) len = room;
+            memcpy(r.text + r.textUsed, s, len);
+            r.textUsed += len;
+            r.text[r.textUsed++] = '\0';
+            if(r.textUsed >= TEXT_SIZE) r.textUsed = TEXT_SIZE - 1;
+        }
+
+        inline void capture(Record & r, const char * s){ addText(r, s ? s : "(null)", s ? strlen(s) : 6); }
+        inline void capture(Record & r, char * s){ capture(r, (const char *)s); }
+        inline void capture(Record & r, const std::string & s){ addText(r, s.data(), s.size()); }
+
+        template<class T>
+        inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type capture(Record & r, T v){
+            Arg & a = r.args[r.numArgs++];
+            if(std::is_signed<T>::value){ a.type = Arg::INT; a.i = (long long)v; }
+            else{ a.type = Arg::UINT; a.u = (unsigned long long)v; }
+        }
+        template<class T>
+        inline typename std::enable_if<std::is_floating_point<T>::value>::type capture(Record & r, T v){
+            Arg & a = r.args[r.numArgs++];
+            a.type = Arg::DOUBLE;
+            a.d = v;
+        }
+        template<class T>
+        inline void capture(Record & r, T * p){
+            Arg & a = r.args[r.numArgs++];
+            a.type = Arg::POINTER;
+            a.p = p;
+        }
+
+        inline void captureAll(Record &){}
+        template<class T, class... Rest>
+        inline void captureAll(Record & r, const T & first, const Rest &... rest){
+            if(r.numArgs < MAX_ARGS) capture(r, first);
+            captureAll(r, rest...);
+        }
+
+        template<class... Args>
+        inline void log(Site & site, uint32_t intervalMs, ofLogLevel level, const char * module, const char * format, const Args &... args){
+            if(level < ofGetLogLevel()) return;
+            uint64_t now = nowMicros();
+            uint32_t suppressed = 0;
+            if(!allow(site, now, intervalMs, suppressed)) return;
+            Record r;
+            r.micros = now;
+            r.level = level;
+            r.module = module;
+            r.format = format;
+            r.suppressed = suppressed;
+            r.numArgs = 0;
+            r.textUsed = 0;
+            captureAll(r, args...);
+            enqueue(r);
+        }
+    }
+}
+
+#define RA_LOG_RATE(intervalMs, level, module, ...) do{ \
+    static ofxRobotArm::asynclog::Site raLogSite_{ {0}, {0} }; \
+    ofxRobotArm::asynclog::log(raLogSite_, intervalMs, level, module, __VA_ARGS__); \
+}while(0)
+#define RA_LOG(level, module, ...) RA_LOG_RATE(RA_LOG_RATE_MS, level, module, __VA_ARGS__)
+
+#define RA_LOG_VERBOSE(module, ...) RA_LOG(OF_LOG_VERBOSE, module, __VA_ARGS__)
+#define RA_LOG_NOTICE(module, ...) RA_LOG(OF_LOG_NOTICE, module, __VA_ARGS__)
+#define RA_LOG_WARNING(module, ...) RA_LOG(OF_LOG_WARNING, module, __VA_ARGS__)
+#define RA_LOG_ERROR(module, ...) RA_LOG(OF_LOG_ERROR, module, __VA_ARGS__)
@@ -21,6 +21,7 @@ namespace ofxRobotArm{
     enum IKType{
         SW,
         HK,
-        RELAXED
+        RELAXED,
+        NUMERIC
     };
 }
@@ -0,0 +1,45 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "SimClock.h"
+#include "ofMain.h"
+#include <atomic>
+
+using namespace ofxRobotArm;
+
+namespace{
+    std::atomic<bool> bVirtual(false);
+    std::atomic<uint64_t> virtualMicros(0);
+}
+
+void simclock::setVirtual(bool enabled, uint64_t startMicros){
+    virtualMicros = startMicros;
+    bVirtual = enabled;
+}
+
+bool simclock::isVirtual(){
+    return bVirtual;
+}
+
+void simclock::advance(uint64_t micros){
+    if(bVirtual){
+        virtualMicros += micros;
+    }
+}
+
+void simclock::set(uint64_t micros){
+    if(bVirtual){
+        virtualMicros = micros;
+    }
+}
+
+uint64_t simclock::nowMicros(){
+    if(bVirtual){
+        return virtualMicros;
+    }
+    return ofGetElapsedTimeMicros();
+}
+
+double simclock::nowSeconds(){
+    return nowMicros() / 1000000.0;
+}
@@ -0,0 +1,30 @@
+//
+//  SimClock.h
+//  ofxRobotArm
+//
+//  Time source for code whose timing should follow a lockstep simulation
+//  (see LockstepScheduler). By default it is the openFrameworks clock. In
+//  virtual mode it stands still and only moves when advance() is called,
+//  so recordings and playback line up tick for tick between runs.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include <cstdint>
+
+namespace ofxRobotArm{
+    namespace simclock{
+        /// \brief switches to virtual time starting at startMicros, or back to the real clock
+        void setVirtual(bool enabled, uint64_t startMicros = 0);
+        bool isVirtual();
+
+        /// \brief moves virtual time forward, ignored on the real clock
+        void advance(uint64_t micros);
+        /// \brief sets virtual time, ignored on the real clock
+        void set(uint64_t micros);
+
+        /// \brief ofGetElapsedTimeMicros(), or the virtual time
+        uint64_t nowMicros();
+        double nowSeconds();
+    }
+}
@@ -0,0 +1,124 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "StateBus.h"
+
+using namespace ofxRobotArm;
+
+StateBus::StateBus(){
+    memset(&state, 0, sizeof(state));
+}
+
+StateBus::~StateBus(){
+    close();
+}
+
+bool StateBus::create(string name, int numJoints){
+    close();
+    int ret = ofxra_bus_create(name.c_str(), numJoints, &bus);
+    if(ret != OFXRA_BUS_OK){
+        ofLogError("StateBus") << "could not create " << name << ": " << (ret == OFXRA_BUS_ERROR ? strerror(errno) : "bad layout");
+        bus = nullptr;
+        return false;
+    }
+    this->name = name;
+    this->numJoints = numJoints;
+    bOwner = true;
+    memset(&state, 0, sizeof(state));
+    state.num_joints = numJoints;
+    // a command left from a previous run must not move the arm
+    ofxra_command stale;
+    ofxra_bus_read_command(bus, &stale, &lastCommandId);
+    return true;
+}
+
+bool StateBus::open(string name){
+    close();
+    int ret = ofxra_bus_open(name.c_str(), &bus);
+    if(ret != OFXRA_BUS_OK){
+        ofLogError("StateBus") << "could not open " << name << ": " << (ret == OFXRA_BUS_ERROR ? strerror(errno) : "no driver has created it");
+        bus = nullptr;
+        return false;
+    }
+    this->name = name;
+    numJoints = ofxra_bus_num_joints(bus);
+    bOwner = false;
+    ofxra_command stale;
+    ofxra_bus_read_command(bus, &stale, &lastCommandId);
+    return true;
+}
+
+void StateBus::close(){
+    if(!bus){
+        return;
+    }
+    ofxra_bus_close(bus);
+    bus = nullptr;
+    if(bOwner){
+        ofxra_bus_unlink(name.c_str());
+    }
+    bOwner = false;
+}
+
+void StateBus::publish(const double * joints, int count, bool connected){
+    if(!bus){
+        return;
+    }
+    uint64_t now = ofxra_bus_now_us();
+    count = std::min(count, numJoints);
+    double dt = state.timestamp_us && now > state.timestamp_us ? (now - state.timestamp_us) / 1000000.0 : 0;
+    for(int i = 0; i < count; i++){
+        state.velocity[i] = dt > 0 ? (joints[i] - state.position[i]) / dt : 0;
+        state.position[i] = joints[i];
+    }
+    state.timestamp_us = now;
+    state.flags = connected ? (state.flags | OFXRA_STATE_CONNECTED) : (state.flags & ~OFXRA_STATE_CONNECTED);
+    ofxra_bus_write_state(bus, &state);
+}
+
+void StateBus::publish(const vector<double> & joints, bool connected){
+    publish(joints.data(), joints.size(), connected);
+}
+
+void StateBus::publish(const vector<double> & joints, const Pose & tool, bool connected){
+    state.tool_position[0] = tool.position.x;
+    state.tool_position[1] = tool.position.y;
+    state.tool_position[2] = tool.position.z;
+    state.tool_orientation[0] = tool.orientation.x();
+    state.tool_orientation[1] = tool.orientation.y();
+    state.tool_orientation[2] = tool.orientation.z();
+    state.tool_orientation[3] = tool.orientation.w();
+    state.flags |= OFXRA_STATE_TOOL_VALID;
+    publish(joints.data(), joints.size(), connected);
+}
+
+bool StateBus::readState(ofxra_state & out) const{
+    return bus && ofxra_bus_read_state(bus, &out) == OFXRA_BUS_OK;
+}
+
+bool StateBus::pollCommand(ofxra_command & command){
+    return bus && ofxra_bus_read_command(bus, &command, &lastCommandId) == 1;
+}
+
+bool StateBus::sendPosition(const vector<double> & joints){
+    return send(OFXRA_COMMAND_POSITION, joints, 0);
+}
+
+bool StateBus::sendSpeed(const vector<double> & speeds, double acceleration){
+    return send(OFXRA_COMMAND_SPEED, speeds, acceleration);
+}
+
+bool StateBus::send(uint32_t mode, const vector<double> & values, double acceleration){
+    if(!bus){
+        return false;
+    }
+    ofxra_command command;
+    memset(&command, 0, sizeof(command));
+    command.mode = mode;
+    command.num_joints = std::min((int)values.size(), OFXRA_BUS_MAX_JOINTS);
+    for(uint32_t i = 0; i < command.num_joints; i++){
+        command.values[i] = values[i];
+    }
+    command.acceleration = acceleration;
+    return ofxra_bus_write_command(bus, &command) == OFXRA_BUS_OK;
+}
@@ -0,0 +1,55 @@
+//
+//  StateBus.h
+//  ofxRobotArm
+//
+//  C++ side of the shared-memory state bus (state_bus.h). A driver given a
+//  bus with RobotDriver::setStateBus publishes every joint update on it and
+//  applies the commands other processes leave in its mailbox.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "Pose.h"
+#include "state_bus.h"
+
+namespace ofxRobotArm{
+    class StateBus{
+    public:
+        StateBus();
+        ~StateBus();
+        StateBus(const StateBus &) = delete;
+        StateBus & operator=(const StateBus &) = delete;
+
+        /// \brief creates (or takes over) the segment, it is unlinked on close
+        bool create(string name, int numJoints);
+        /// \brief attaches to a segment some other process created
+        bool open(string name);
+        void close();
+        bool isOpen() const { return bus != nullptr; }
+        int getNumJoints() const { return numJoints; }
+
+        /// \brief publishes joint positions (radians), velocities are differenced
+        /// from the last publish. Allocation free, safe on a driver tick.
+        void publish(const double * joints, int count, bool connected = true);
+        void publish(const vector<double> & joints, bool connected = true);
+        void publish(const vector<double> & joints, const Pose & tool, bool connected = true);
+
+        bool readState(ofxra_state & state) const;
+
+        /// \brief true once per new command in the mailbox
+        bool pollCommand(ofxra_command & command);
+        bool sendPosition(const vector<double> & joints);
+        bool sendSpeed(const vector<double> & speeds, double acceleration);
+
+    protected:
+        bool send(uint32_t mode, const vector<double> & values, double acceleration);
+
+        ofxra_bus * bus = nullptr;
+        string name;
+        bool bOwner = false;
+        int numJoints = 0;
+        ofxra_state state;
+        uint64_t lastCommandId = 0;
+    };
+}
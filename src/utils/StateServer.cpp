@@ -0,0 +1,315 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "StateServer.h"
+#include "RobotDriver.h"
+#include "AsyncLog.h"
+#include "Trace.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "StateServer writes its frames in host order, which has to be little-endian"
+#endif
+
+using namespace ofxRobotArm;
+
+namespace{
+    template<class T>
+    void put(char *& out, T value){
+        memcpy(out, &value, sizeof(T));
+        out += sizeof(T);
+    }
+    template<class T>
+    T get(const char *& in){
+        T value;
+        memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+
+    size_t sampleSize(int joints){
+        return 16 + 8 * joints;
+    }
+    size_t targetSize(int joints){
+        return StateServer::HEADER_SIZE + 8 + 8 * joints + 8;
+    }
+}
+
+StateServer::StateServer() : batchSize(1), maxBatchDelay(2000), bAcceptTargets(false), head(0), tail(0), dropped(0), framesSent(0){
+}
+
+StateServer::~StateServer(){
+    close();
+}
+
+bool StateServer::setup(RobotDriver * driver, int numJoints, int port, Transport transport){
+    close();
+    if(numJoints <= 0 || numJoints > MAX_JOINTS){
+        ofLogError("StateServer") << "numJoints must be 1 to " << (int)MAX_JOINTS;
+        return false;
+    }
+    this->driver = driver;
+    this->numJoints = numJoints;
+    this->port = port;
+    this->transport = transport;
+
+    ring.assign(RING_CAPACITY, Sample());
+    head = 0;
+    tail = 0;
+    frame.assign(HEADER_SIZE + sampleSize(numJoints) * MAX_BATCH, 0);
+    incoming.assign(2048, 0);
+    pending = 0;
+
+    bool ok;
+    if(transport == UDP){
+        ok = udp.Create() && udp.SetReuseAddress(true) && udp.Bind(port) && udp.SetNonBlocking(true);
+    }else{
+        ok = tcp.setup(port, false);
+    }
+    if(!ok){
+        ofLogError("StateServer") << "could not bind port " << port;
+        return false;
+    }
+    ofLogNotice("StateServer") << "streaming " << numJoints << " joints on " << (transport == UDP ? "udp " : "tcp ") << port;
+    startThread();
+    return true;
+}
+
+void StateServer::close(){
+    if(isThreadRunning()){
+        stopThread();
+        waitForThread(false);
+    }
+    if(transport == UDP){
+        udp.Close();
+    }else{
+        tcp.close();
+    }
+    std::lock_guard<std::mutex> lock(clientMutex);
+    udpClients.clear();
+    tcpBuffers.clear();
+}
+
+void StateServer::setBatchSize(int samples){
+    batchSize = std::max(1, std::min(samples, (int)MAX_BATCH));
+}
+
+void StateServer::setMaxBatchDelay(int micros){
+    maxBatchDelay = micros;
+}
+
+void StateServer::setAcceptTargets(bool accept){
+    bAcceptTargets = accept;
+}
+
+void StateServer::setClientTimeout(float seconds){
+    clientTimeout = seconds * 1000000;
+}
+
+int StateServer::getNumClients(){
+    if(transport == TCP){
+        return tcp.getNumClients();
+    }
+    std::lock_guard<std::mutex> lock(clientMutex);
+    return udpClients.size();
+}
+
+void StateServer::push(const double * joints, int count, uint32_t flags){
+    uint64_t h = head.load(std::memory_order_relaxed);
+    uint32_t sequence = pushed++;
+    if(ring.empty() || h - tail.load(std::memory_order_acquire) >= RING_CAPACITY){
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Sample & s = ring[h % RING_CAPACITY];
+    s.timestamp = ofGetElapsedTimeMicros();
+    s.sequence = sequence;
+    s.flags = flags;
+    count = std::min(count, numJoints);
+    for(int i = 0; i < count; i++){
+        s.joints[i] = joints[i];
+    }
+    head.store(h + 1, std::memory_order_release);
+}
+
+void StateServer::push(const vector<double> & joints, uint32_t flags){
+    push(joints.data(), joints.size(), flags);
+}
+
+void StateServer::threadedFunction(){
+    RA_TRACE_THREAD_NAME("StateServer");
+    const size_t bytes = sampleSize(numJoints);
+    while(isThreadRunning()){
+        if(transport == UDP){
+            receiveUdp();
+        }else{
+            receiveTcp();
+        }
+
+        uint64_t now = ofGetElapsedTimeMicros();
+        uint64_t t = tail.load(std::memory_order_relaxed);
+        uint64_t h = head.load(std::memory_order_acquire);
+        while(t != h){
+            const Sample & s = ring[t % RING_CAPACITY];
+            char * out = frame.data() + HEADER_SIZE + bytes * pending;
+            put(out, s.timestamp);
+            put(out, s.sequence);
+            put(out, s.flags);
+            for(int i = 0; i < numJoints; i++){
+                put(out, s.joints[i]);
+            }
+            if(pending++ == 0){
+                oldestPending = s.timestamp;
+            }
+            t++;
+            tail.store(t, std::memory_order_release);
+            if(pending >= batchSize){
+                sendBatch(now);
+            }
+        }
+        if(pending > 0 && now - oldestPending >= (uint64_t)maxBatchDelay.load()){
+            sendBatch(now);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(250));
+    }
+}
+
+void StateServer::writeHeader(char * out, uint8_t type, uint16_t count, uint32_t sequence, uint64_t timestamp){
+    put(out, MAGIC);
+    put(out, VERSION);
+    put(out, type);
+    put(out, count);
+    put(out, (uint16_t)numJoints);
+    put(out, sequence);
+    put(out, timestamp);
+}
+
+void StateServer::sendBatch(uint64_t now){
+    RA_TRACE_SCOPE("server.send");
+    writeHeader(frame.data(), STATE, pending, frameSequence++, now);
+    int size = HEADER_SIZE + sampleSize(numJoints) * pending;
+    pending = 0;
+
+    if(transport == UDP){
+        std::lock_guard<std::mutex> lock(clientMutex);
+        for(size_t i = 0; i < udpClients.size();){
+            if(now - udpClients[i].lastSeen > clientTimeout){
+                RA_LOG_NOTICE("StateServer", "client %s:%d timed out", udpClients[i].address.c_str(), udpClients[i].port);
+                udpClients.erase(udpClients.begin() + i);
+                continue;
+            }
+            // Connect only sets the destination on an unconnected udp socket
+            udp.Connect(udpClients[i].address.c_str(), udpClients[i].port);
+            udp.Send(frame.data(), size);
+            i++;
+        }
+    }else{
+        for(int i = 0; i <= tcp.getLastID(); i++){
+            if(tcp.isClientConnected(i)){
+                tcp.sendRawBytes(i, frame.data(), size);
+            }
+        }
+    }
+    framesSent++;
+}
+
+void StateServer::receiveUdp(){
+    int size;
+    while((size = udp.Receive(incoming.data(), incoming.size())) > 0){
+        string address;
+        int remotePort = 0;
+        udp.GetRemoteAddr(address, remotePort);
+        handleMessage(incoming.data(), size, address, remotePort);
+    }
+}
+
+void StateServer::receiveTcp(){
+    if((int)tcpBuffers.size() <= tcp.getLastID()){
+        tcpBuffers.resize(tcp.getLastID() + 1);
+    }
+    for(int i = 0; i <= tcp.getLastID(); i++){
+        if(!tcp.isClientConnected(i)){
+            tcpBuffers[i].clear();
+            continue;
+        }
+        // the stream splits and joins frames, so bytes collect until a whole one is there
+        string & buffer = tcpBuffers[i];
+        int size;
+        while((size = tcp.receiveRawBytes(i, incoming.data(), incoming.size())) > 0){
+            buffer.append(incoming.data(), size);
+        }
+        while(buffer.size() >= HEADER_SIZE){
+            const char * in = buffer.data();
+            uint16_t magic = get<uint16_t>(in);
+            in += 1;
+            uint8_t type = get<uint8_t>(in);
+            in += 2;
+            uint16_t joints = get<uint16_t>(in);
+            size_t needed = type == TARGET ? targetSize(joints) : HEADER_SIZE;
+            if(magic != MAGIC || joints > MAX_JOINTS){
+                RA_LOG_WARNING("StateServer", "bad frame from tcp client %d, dropping its buffer", i);
+                buffer.clear();
+                break;
+            }
+            if(buffer.size() < needed){
+                break;
+            }
+            handleMessage(buffer.data(), needed, "", 0);
+            buffer.erase(0, needed);
+        }
+    }
+}
+
+void StateServer::handleMessage(const char * data, size_t size, const string & address, int remotePort){
+    if(size < HEADER_SIZE){
+        return;
+    }
+    const char * in = data;
+    uint16_t magic = get<uint16_t>(in);
+    uint8_t version = get<uint8_t>(in);
+    uint8_t type = get<uint8_t>(in);
+    uint16_t count = get<uint16_t>(in);
+    uint16_t joints = get<uint16_t>(in);
+    if(magic != MAGIC || version != VERSION){
+        RA_LOG_WARNING("StateServer", "ignoring frame, magic %x version %d", magic, version);
+        return;
+    }
+
+    if(type == SUBSCRIBE && transport == UDP){
+        uint64_t now = ofGetElapsedTimeMicros();
+        std::lock_guard<std::mutex> lock(clientMutex);
+        for(auto & c : udpClients){
+            if(c.address == address && c.port == remotePort){
+                c.lastSeen = now;
+                return;
+            }
+        }
+        udpClients.push_back({address, remotePort, now});
+        RA_LOG_NOTICE("StateServer", "client %s:%d subscribed", address.c_str(), remotePort);
+    }else if(type == TARGET){
+        handleTarget(data, size, count, joints);
+    }
+}
+
+void StateServer::handleTarget(const char * data, size_t size, int count, int joints){
+    if(!bAcceptTargets){
+        RA_LOG_WARNING("StateServer", "target ignored, call setAcceptTargets(true) to allow remote control");
+        return;
+    }
+    if(count != 1 || joints != numJoints || size < targetSize(joints) || !driver){
+        RA_LOG_WARNING("StateServer", "target ignored, expected %d joints", numJoints);
+        return;
+    }
+    const char * in = data + HEADER_SIZE;
+    uint32_t mode = get<uint32_t>(in);
+    in += 4;
+    vector<double> values(joints);
+    for(int i = 0; i < joints; i++){
+        values[i] = get<double>(in);
+    }
+    double acceleration = get<double>(in);
+    if(mode == 1){
+        driver->setPose(values);
+    }else if(mode == 2){
+        driver->setSpeed(values, acceleration);
+    }
+}
@@ -0,0 +1,141 @@
+//
+//  StateServer.h
+//  ofxRobotArm
+//
+//  Streams driver state to remote clients and, optionally, takes joint
+//  targets back, over UDP or TCP with a small binary framing.
+//
+//  The driver thread pushes every joint update into a lock-free ring (see
+//  RobotDriver::setStateServer); the server thread drains it, batches the
+//  samples and sends them. Nothing on the driver side waits on a socket.
+//
+//  All fields little-endian, no padding:
+//
+//    header   uint16 magic 0x5241 ("RA")   uint8 version   uint8 type
+//             uint16 count   uint16 numJoints
+//             uint32 sequence   uint64 timestamp (us, server clock)      20 bytes
+//
+//    STATE    server -> client, count samples of
+//             uint64 timestamp (us)   uint32 sequence   uint32 flags
+//             double joints[numJoints] (radians)
+//             header sequence counts frames, sample sequences count pushes,
+//             a gap in either means something was dropped
+//
+//    TARGET   client -> server, count 1
+//             uint32 mode (1 position, 2 speed)   uint32 reserved
+//             double values[numJoints]   double acceleration
+//
+//    SUBSCRIBE  client -> server, header only. UDP clients send it at least
+//             every few seconds to keep receiving; TCP clients are
+//             subscribed once connected.
+//
+//  Python: struct.unpack('<HBBHHIQ', data[:20]), then '<QII%dd' % numJoints per sample.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "ofxNetwork.h"
+#include <atomic>
+
+namespace ofxRobotArm{
+    class RobotDriver;
+
+    class StateServer : public ofThread{
+    public:
+        enum Transport{
+            UDP,
+            TCP
+        };
+
+        enum MessageType : uint8_t{
+            STATE = 1,
+            TARGET = 2,
+            SUBSCRIBE = 3
+        };
+
+        static const uint16_t MAGIC = 0x5241;
+        static const uint8_t VERSION = 1;
+        static const int MAX_JOINTS = 8;
+        static const size_t HEADER_SIZE = 20;
+        static const int MAX_BATCH = 64;
+        /// \brief samples buffered between the driver and the server thread
+        static const size_t RING_CAPACITY = 1024;
+
+        struct Sample{
+            uint64_t timestamp;
+            uint32_t sequence;
+            uint32_t flags;
+            double joints[MAX_JOINTS];
+        };
+
+        StateServer();
+        ~StateServer();
+
+        /// \brief binds port and starts the server thread
+        bool setup(RobotDriver * driver, int numJoints, int port = 30010, Transport transport = UDP);
+        void close();
+
+        /// \brief samples per STATE frame (up to MAX_BATCH), 1 sends every update as it comes
+        void setBatchSize(int samples);
+        /// \brief longest a sample waits for its batch to fill
+        void setMaxBatchDelay(int micros);
+        /// \brief off by default: TARGET frames are dropped unless enabled
+        void setAcceptTargets(bool accept);
+        /// \brief UDP clients that haven't sent SUBSCRIBE for this long are dropped
+        void setClientTimeout(float seconds);
+
+        /// \brief called on the driver thread, never blocks or allocates
+        void push(const double * joints, int count, uint32_t flags = 0);
+        void push(const vector<double> & joints, uint32_t flags = 0);
+
+        uint64_t getNumDropped(){ return dropped.load(); }
+        uint64_t getNumSent(){ return framesSent.load(); }
+        int getNumClients();
+
+        void threadedFunction();
+
+    protected:
+        struct UdpClient{
+            string address;
+            int port;
+            uint64_t lastSeen;
+        };
+
+        void receiveUdp();
+        void receiveTcp();
+        void handleMessage(const char * data, size_t size, const string & address, int port);
+        void handleTarget(const char * data, size_t size, int count, int joints);
+        void sendBatch(uint64_t now);
+        void writeHeader(char * out, uint8_t type, uint16_t count, uint32_t sequence, uint64_t timestamp);
+
+        RobotDriver * driver = nullptr;
+        Transport transport = UDP;
+        int numJoints = 6;
+        int port = 0;
+        std::atomic<int> batchSize;
+        std::atomic<int> maxBatchDelay;
+        std::atomic<bool> bAcceptTargets;
+        uint64_t clientTimeout = 5000000;
+
+        // single producer ring, the driver thread writes, the server thread reads
+        vector<Sample> ring;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> tail;
+        std::atomic<uint64_t> dropped;
+        uint32_t pushed = 0;
+
+        ofxUDPManager udp;
+        ofxTCPServer tcp;
+        vector<UdpClient> udpClients;
+        std::mutex clientMutex;
+        vector<string> tcpBuffers;
+
+        vector<char> frame;
+        vector<char> incoming;
+        int pending = 0;
+        uint64_t oldestPending = 0;
+        uint32_t frameSequence = 0;
+        std::atomic<uint64_t> framesSent;
+    };
+}
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "ThreadPool.h"
+#include "Trace.h"
+#include <string>
+
+using namespace ofxRobotArm;
+
+ThreadPool::ThreadPool(int numThreads) : next(0){
+    if(numThreads < 0){
+        numThreads = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+    }
+    for(int i = 0; i < numThreads; i++){
+        threads.emplace_back(&ThreadPool::work, this, i + 1);
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bStop = true;
+    }
+    wake.notify_all();
+    for(auto & t : threads){
+        t.join();
+    }
+}
+
+ThreadPool & ThreadPool::getDefault(){
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int)> & fn){
+    if(count <= 0){
+        return;
+    }
+    if(threads.empty() || count == 1){
+        for(int i = 0; i < count; i++){
+            fn(i, 0);
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> call(callMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &fn;
+        this->count = count;
+        next = 0;
+        active = threads.size();
+        generation++;
+    }
+    wake.notify_all();
+    runJob(0);
+
+    // fn lives on this stack frame, every worker has to be done with it before returning
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]{ return active == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::runJob(int worker){
+    int i;
+    while((i = next.fetch_add(1)) < count){
+        (*job)(i, worker);
+    }
+}
+
+void ThreadPool::work(int worker){
+    RA_TRACE_THREAD_NAME("ThreadPool " + std::to_string(worker));
+    uint64_t seen = 0;
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]{ return bStop || generation != seen; });
+            if(bStop){
+                return;
+            }
+            seen = generation;
+        }
+        runJob(worker);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            active--;
+        }
+        finished.notify_one();
+    }
+}
@@ -0,0 +1,59 @@
+//
+//  ThreadPool.h
+//  ofxRobotArm
+//
+//  Fixed set of worker threads for splitting planning work (IK restarts,
+//  collision checks) across cores. parallelFor blocks until every index is
+//  done, the calling thread works along, so a pool of n threads runs n + 1
+//  indices at a time.
+//
+//  Not for the driver threads: it wakes workers through a condition
+//  variable and the callback is a std::function.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ofxRobotArm{
+    class ThreadPool{
+    public:
+        /// \brief numThreads workers, -1 for one less than the hardware threads
+        ThreadPool(int numThreads = -1);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool & operator=(const ThreadPool &) = delete;
+
+        /// \brief calls fn(index, worker) for index in [0, count), worker in
+        /// [0, getNumWorkers()) is unique among the calls running at once, for
+        /// per worker scratch. One parallelFor at a time per pool.
+        void parallelFor(int count, const std::function<void(int index, int worker)> & fn);
+
+        /// \brief worker threads plus the calling thread
+        int getNumWorkers() const { return threads.size() + 1; }
+
+        /// \brief shared pool sized to the machine, created on first use
+        static ThreadPool & getDefault();
+
+    protected:
+        void work(int worker);
+        void runJob(int worker);
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::mutex callMutex;
+        std::condition_variable wake;
+        std::condition_variable finished;
+        const std::function<void(int, int)> * job = nullptr;
+        std::atomic<int> next;
+        int count = 0;
+        int active = 0;
+        uint64_t generation = 0;
+        bool bStop = false;
+    };
+}
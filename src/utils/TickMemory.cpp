@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "TickMemory.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace ofxRobotArm;
+using namespace ofxRobotArm::memory;
+
+namespace{
+    std::atomic<int> warmupTicks(10);
+    std::atomic<bool> abortOnHeap(true);
+    std::atomic<uint64_t> heapViolations(0);
+
+    // plain ints, these are read from inside operator new
+    thread_local int heapForbidden = 0;
+    thread_local int ticksSeen = 0;
+}
+
+void memory::setHeapCheckWarmupTicks(int ticks){
+    warmupTicks = ticks;
+}
+
+void memory::setAbortOnHeap(bool abort){
+    abortOnHeap = abort;
+}
+
+uint64_t memory::getNumHeapViolations(){
+    return heapViolations.load();
+}
+
+bool memory::isHeapForbidden(){
+    return heapForbidden > 0;
+}
+
+void memory::countHeapViolation(size_t bytes){
+    heapViolations.fetch_add(1, std::memory_order_relaxed);
+    if(abortOnHeap.load(std::memory_order_relaxed)){
+        heapForbidden = 0;
+        fprintf(stderr, "ofxRobotArm: %zu byte heap allocation inside a control tick\n", bytes);
+        abort();
+    }
+}
+
+TickScope::TickScope(){
+    bChecked = ticksSeen >= warmupTicks.load(std::memory_order_relaxed);
+    if(bChecked){
+        heapForbidden++;
+    }else{
+        ticksSeen++;
+    }
+}
+
+TickScope::~TickScope(){
+    if(bChecked){
+        heapForbidden--;
+    }
+}
+
+HeapAllowed::HeapAllowed() : saved(heapForbidden){
+    heapForbidden = 0;
+}
+
+HeapAllowed::~HeapAllowed(){
+    heapForbidden = saved;
+}
+
+#ifdef OFXROBOTARM_HEAP_CHECK
+void * operator new(size_t size){
+    if(heapForbidden > 0){
+        memory::countHeapViolation(size);
+    }
+    void * p = malloc(size ? size : 1);
+    if(!p) throw std::bad_alloc();
+    return p;
+}
+void * operator new[](size_t size){
+    return operator new(size);
+}
+void * operator new(size_t size, const std::nothrow_t &) noexcept{
+    if(heapForbidden > 0){
+        memory::countHeapViolation(size);
+    }
+    return malloc(size ? size : 1);
+}
+void * operator new[](size_t size, const std::nothrow_t & tag) noexcept{
+    return operator new(size, tag);
+}
+void operator delete(void * p) noexcept{
+    free(p);
+}
+void operator delete[](void * p) noexcept{
+    free(p);
+}
+void operator delete(void * p, size_t) noexcept{
+    free(p);
+}
+void operator delete[](void * p, size_t) noexcept{
+    free(p);
+}
+#endif
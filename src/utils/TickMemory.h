@@ -0,0 +1,56 @@
+//
+//  TickMemory.h
+//  ofxRobotArm
+//
+//  Heap checking for the driver control ticks.
+//
+//  A TickScope marks one tick on the calling thread. Per tick scratch lives
+//  on the stack or in buffers the drivers size outside the tick, so nothing
+//  inside a TickScope should reach malloc.
+//
+//  Build with OFXROBOTARM_HEAP_CHECK defined to replace the global operator
+//  new. It then aborts on any heap allocation inside a TickScope, once the
+//  thread has finished its warm up ticks. This replaces operator new for the
+//  whole app, so don't combine it with an app that defines its own.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace ofxRobotArm{
+    namespace memory{
+        /// \brief ticks per thread before the heap check engages, lazily created
+        /// per thread buffers (trace, log queues, first vector sizing) land there
+        void setHeapCheckWarmupTicks(int ticks);
+        /// \brief with false, violations are only counted
+        void setAbortOnHeap(bool abort);
+        uint64_t getNumHeapViolations();
+        /// \brief true inside a checked TickScope, used by the checking operator new
+        bool isHeapForbidden();
+        void countHeapViolation(size_t bytes);
+
+        /// \brief marks one control tick on the calling thread
+        class TickScope{
+        public:
+            TickScope();
+            ~TickScope();
+            TickScope(const TickScope &) = delete;
+            TickScope & operator=(const TickScope &) = delete;
+        private:
+            bool bChecked;
+        };
+
+        /// \brief lifts the heap check for a known, rare path (error reporting, reconnects)
+        class HeapAllowed{
+        public:
+            HeapAllowed();
+            ~HeapAllowed();
+            HeapAllowed(const HeapAllowed &) = delete;
+            HeapAllowed & operator=(const HeapAllowed &) = delete;
+        private:
+            int saved;
+        };
+    }
+}
@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "TimingProfile.h"
+#include "ofxYAML.h"
+
+using namespace ofxRobotArm;
+
+namespace{
+    void read(const YAML::Node & node, const char * key, double & value){
+        if(node[key]){
+            value = node[key].as<double>();
+        }
+    }
+    void read(const YAML::Node & node, const char * key, int & value){
+        if(node[key]){
+            value = node[key].as<int>();
+        }
+    }
+
+    void apply(const YAML::Node & node, TimingProfile & p){
+        read(node, "control_rate", p.controlRate);
+        read(node, "command_rate", p.commandRate);
+        read(node, "move_time_step", p.moveTimeStep);
+        read(node, "max_joint_accel", p.maxJointAccel);
+        read(node, "accel_ramp", p.accelRamp);
+        read(node, "decel_steps", p.decelSteps);
+        read(node, "servo_time", p.servoTime);
+        read(node, "servo_lookahead", p.servoLookahead);
+        read(node, "servo_gain", p.servoGain);
+        read(node, "joint_smoothing", p.jointSmoothing);
+        read(node, "position_noise", p.positionNoise);
+        read(node, "jerk_noise", p.jerkNoise);
+    }
+}
+
+string TimingProfile::getRobotName(RobotType type){
+    switch(type){
+        case UR3: return "UR3";
+        case UR5: return "UR5";
+        case UR10: return "UR10";
+        case IRB120: return "IRB120";
+        case IRB4600: return "IRB4600";
+        case IRB6700: return "IRB6700";
+        case XARM7: return "XARM7";
+        case PANDA: return "PANDA";
+    }
+    return "default";
+}
+
+TimingProfile TimingProfile::getDefault(RobotType type){
+    TimingProfile p;
+    p.name = getRobotName(type);
+    switch(type){
+        case UR3:
+        case UR5:
+        case UR10:
+            p.controlRate = 125;
+            p.decelSteps = 120;
+            break;
+        case IRB120:
+        case IRB4600:
+        case IRB6700:
+            // EGM rate, set by the EGMActJoint/EGMActPose RAPID instruction
+            p.controlRate = 250;
+            p.decelSteps = 120;
+            break;
+        case XARM7:
+            p.controlRate = 250;
+            p.decelSteps = 120;
+            break;
+        case PANDA:
+            p.controlRate = 1000;
+            break;
+    }
+    return p;
+}
+
+bool TimingProfile::load(string path, RobotType type){
+    return load(path, getRobotName(type));
+}
+
+bool TimingProfile::load(string path, string robotName){
+    ofxYAML yaml;
+    if(!yaml.load(ofToDataPath(path))){
+        ofLogError("TimingProfile") << "could not load " << path;
+        return false;
+    }
+    TimingProfile p = *this;
+    if(yaml["default"]){
+        apply(yaml["default"], p);
+    }
+    if(yaml[robotName]){
+        apply(yaml[robotName], p);
+    }else{
+        ofLogNotice("TimingProfile") << path << " has no " << robotName << " section, using defaults";
+    }
+    if(p.controlRate <= 0 || p.commandRate <= 0 || p.moveTimeStep <= 0 || p.decelSteps < 2){
+        ofLogError("TimingProfile") << path << ": rates and move_time_step must be > 0, decel_steps >= 2, keeping the current " << robotName << " profile";
+        return false;
+    }
+    *this = p;
+    name = robotName;
+    return true;
+}
+
+bool TimingProfile::save(string path){
+    ofFile file(ofToDataPath(path), ofFile::WriteOnly);
+    if(!file.is_open()){
+        return false;
+    }
+    file << name << ":" << endl;
+    file << "  control_rate: " << controlRate << endl;
+    file << "  command_rate: " << commandRate << endl;
+    file << "  move_time_step: " << moveTimeStep << endl;
+    file << "  max_joint_accel: " << maxJointAccel << endl;
+    file << "  accel_ramp: " << accelRamp << endl;
+    file << "  decel_steps: " << decelSteps << endl;
+    file << "  servo_time: " << servoTime << endl;
+    file << "  servo_lookahead: " << servoLookahead << endl;
+    file << "  servo_gain: " << servoGain << endl;
+    file << "  joint_smoothing: " << jointSmoothing << endl;
+    file << "  position_noise: " << positionNoise << endl;
+    file << "  jerk_noise: " << jerkNoise << endl;
+    return true;
+}
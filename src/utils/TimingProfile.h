@@ -0,0 +1,65 @@
+//
+//  TimingProfile.h
+//  ofxRobotArm
+//
+//  Loop rates, servo parameters and motion limits for one robot, so a cell
+//  can be tuned from a YAML file instead of constants in the drivers.
+//
+//  getDefault(type) reproduces the values the drivers have always used.
+//  load() starts from those and overrides whatever the file sets, first
+//  from a "default" section, then from the robot's own section:
+//
+//    default:
+//      command_rate: 60
+//    UR5:
+//      servo_lookahead: 0.05
+//      decel_steps: 90
+//
+//  see data/timing_profiles.yaml for every key.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "RobotConstants.hpp"
+
+namespace ofxRobotArm{
+    struct TimingProfile{
+        string name = "default";
+
+        /// \brief Hz the arm reports state at (EGM rate, UR RTDE/realtime rate, xArm loop)
+        double controlRate = 125;
+        /// \brief Hz a pose is re-sent at while decelerating with no new target
+        double commandRate = 60;
+
+        /// \brief s, time step makeAchievable assumes between targets until the
+        /// joint state estimator has measured the real one
+        double moveTimeStep = 1.0 / 120.0;
+        /// \brief deg/s^2, per joint acceleration makeAchievable limits to
+        double maxJointAccel = 500;
+        /// \brief added to the speed scale on every moving tick, 0.02 reaches full speed in 50 ticks
+        double accelRamp = 0.02;
+        /// \brief ticks to decelerate over once targets stop
+        int decelSteps = 60;
+
+        /// \brief UR servoj t, lookahead time and gain. A gain of 0 leaves it to the controller (300)
+        double servoTime = 0.08;
+        double servoLookahead = 0.01;
+        double servoGain = 0;
+
+        /// \brief default per joint lerp weight of the controller's pose smoothing
+        double jointSmoothing = 0.1;
+
+        /// \brief joint state estimator, rad encoder noise and rad/s^3 jerk noise, see JointStateEstimator
+        double positionNoise = 1e-4;
+        double jerkNoise = 50;
+
+        static TimingProfile getDefault(RobotType type);
+        static string getRobotName(RobotType type);
+
+        /// \brief overrides from path, keeps the current values for missing keys
+        bool load(string path, RobotType type);
+        bool load(string path, string robotName);
+        bool save(string path);
+    };
+}
@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "Trace.h"
+#include "TickMemory.h"
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace ofxRobotArm;
+
+namespace{
+    // single writer (the owning thread), any number of exporters
+    struct ThreadBuffer{
+        ThreadBuffer(int tid) : tid(tid), head(0), clearedAt(0){
+            events.resize(trace::THREAD_CAPACITY);
+        }
+        int tid;
+        std::string name;
+        std::vector<trace::Event> events;
+        std::atomic<uint64_t> head;
+        std::atomic<uint64_t> clearedAt;
+    };
+
+    std::atomic<bool> traceEnabled(true);
+    std::mutex registryMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+    ThreadBuffer & threadBuffer(){
+        // the registry keeps the buffer alive after the thread exits, so it can still be exported
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if(!buffer){
+            memory::HeapAllowed allow;
+            std::lock_guard<std::mutex> lock(registryMutex);
+            buffer = std::make_shared<ThreadBuffer>((int)registry.size() + 1);
+            registry.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    void writeEscaped(std::ofstream & out, const std::string & s){
+        for(char c : s){
+            if(c == '"' || c == '\\') out << '\\';
+            out << c;
+        }
+    }
+}
+
+void trace::setEnabled(bool enabled){
+    traceEnabled = enabled;
+}
+
+bool trace::isEnabled(){
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+
+void trace::setThreadName(const std::string & name){
+    ThreadBuffer & buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffer.name = name;
+}
+
+void trace::record(const char * name, uint64_t beginMicros, uint64_t endMicros){
+    ThreadBuffer & buffer = threadBuffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    Event & e = buffer.events[head & (THREAD_CAPACITY - 1)];
+    e.name = name;
+    e.beginMicros = beginMicros;
+    e.endMicros = endMicros;
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void trace::clear(){
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for(auto & buffer : registry){
+        // only moves what the next export sees, the writer never notices
+        buffer->clearedAt = buffer->head.load(std::memory_order_acquire);
+    }
+}
+
+bool trace::exportChromeTrace(const std::string & path){
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers = registry;
+    }
+
+    std::ofstream out(path);
+    if(!out.is_open()){
+        return false;
+    }
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    std::vector<Event> copy;
+    for(auto & buffer : buffers){
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            if(!buffer->name.empty()){
+                out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":\"";
+                writeEscaped(out, buffer->name);
+                out << "\"}}";
+                first = false;
+            }
+        }
+
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t available = head - std::min(head, buffer->clearedAt.load());
+        uint64_t count = available < THREAD_CAPACITY ? available : THREAD_CAPACITY;
+        copy.resize(count);
+        for(uint64_t i = 0; i < count; i++){
+            copy[i] = buffer->events[(head - count + i) & (THREAD_CAPACITY - 1)];
+        }
+        // slots the writer reached while we copied (plus the one it may be
+        // writing now) can be torn, drop them
+        uint64_t headAfter = buffer->head.load(std::memory_order_acquire);
+        uint64_t reused = headAfter - head + 1 + count;
+        uint64_t start = reused > THREAD_CAPACITY ? std::min(reused - THREAD_CAPACITY, count) : 0;
+
+        for(uint64_t i = start; i < count; i++){
+            const Event & e = copy[i];
+            out << (first ? "" : ",\n") << "{\"name\":\"";
+            writeEscaped(out, e.name);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << e.beginMicros << ",\"dur\":" << (e.endMicros - e.beginMicros) << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+    return out.good();
+}
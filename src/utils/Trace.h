@@ -0,0 +1,74 @@
+//
+//  Trace.h
+//  ofxRobotArm
+//
+//  Scoped timing spans for the control hot path, exported as Chrome trace
+//  JSON (chrome://tracing or ui.perfetto.dev).
+//
+//  Build with OFXROBOTARM_TRACE defined (e.g. ADDON_CFLAGS += -DOFXROBOTARM_TRACE)
+//  to compile the RA_TRACE_* macros in; without it they expand to nothing.
+//  Each thread writes into its own ring buffer, no locks on the record path.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+
+namespace ofxRobotArm{
+    namespace trace{
+        struct Event{
+            const char * name;
+            uint64_t beginMicros;
+            uint64_t endMicros;
+        };
+
+        /// \brief events kept per thread, older ones are overwritten
+        static const size_t THREAD_CAPACITY = 1 << 14;
+
+        inline uint64_t nowMicros(){
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        /// \brief runtime switch on top of the compile time one, on by default
+        void setEnabled(bool enabled);
+        bool isEnabled();
+
+        /// \brief name shown for the calling thread in the trace viewer
+        void setThreadName(const std::string & name);
+
+        /// \brief name must be a string literal (or otherwise outlive the export)
+        void record(const char * name, uint64_t beginMicros, uint64_t endMicros);
+
+        /// \brief writes every thread's buffered events, safe while threads keep recording
+        bool exportChromeTrace(const std::string & path);
+        void clear();
+
+        class Scope{
+        public:
+            Scope(const char * name) : name(name), begin(isEnabled() ? nowMicros() : 0){}
+            ~Scope(){
+                if(begin){
+                    record(name, begin, nowMicros());
+                }
+            }
+        private:
+            const char * name;
+            uint64_t begin;
+        };
+    }
+}
+
+#define RA_TRACE_CONCAT_INNER(a, b) a##b
+#define RA_TRACE_CONCAT(a, b) RA_TRACE_CONCAT_INNER(a, b)
+
+#ifdef OFXROBOTARM_TRACE
+#define RA_TRACE_SCOPE(name) ofxRobotArm::trace::Scope RA_TRACE_CONCAT(raTraceScope, __LINE__)(name)
+#define RA_TRACE_THREAD_NAME(name) ofxRobotArm::trace::setThreadName(name)
+#else
+#define RA_TRACE_SCOPE(name)
+#define RA_TRACE_THREAD_NAME(name)
+#endif
@@ -0,0 +1,248 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "state_bus.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <new>
+#include <string>
+
+namespace{
+    const uint32_t MAGIC = 0x52414255; // "RABU"
+    const int READ_TRIES = 1000;
+    const int LOCK_TRIES = 100000;
+
+    // each slot on its own cache line so state and command writers don't share one
+    struct Segment{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;
+        uint32_t numJoints;
+
+        alignas(64) uint32_t stateSeq;
+        ofxra_state state;
+
+        alignas(64) uint32_t commandSeq;
+        uint32_t commandLock;
+        uint64_t nextCommandId;
+        ofxra_command command;
+    };
+
+    std::string shmName(const char * name){
+        std::string s = name ? name : "";
+        if(s.empty() || s[0] != '/'){
+            s = "/" + s;
+        }
+        return s;
+    }
+
+    void writeSeq(uint32_t * seq, void * dst, const void * src, size_t bytes){
+        uint32_t s = __atomic_load_n(seq, __ATOMIC_RELAXED);
+        __atomic_store_n(seq, s + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memcpy(dst, src, bytes);
+        __atomic_store_n(seq, s + 2, __ATOMIC_RELEASE);
+    }
+
+    int readSeq(const uint32_t * seq, void * dst, const void * src, size_t bytes){
+        for(int i = 0; i < READ_TRIES; i++){
+            uint32_t before = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+            if(before & 1){
+                sched_yield();
+                continue;
+            }
+            memcpy(dst, src, bytes);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if(__atomic_load_n(seq, __ATOMIC_RELAXED) == before){
+                return OFXRA_BUS_OK;
+            }
+        }
+        return OFXRA_BUS_BUSY;
+    }
+
+    bool sameLayout(const Segment * s, uint32_t numJoints){
+        return __atomic_load_n(&s->magic, __ATOMIC_ACQUIRE) == MAGIC &&
+               s->version == OFXRA_BUS_VERSION &&
+               s->size == sizeof(Segment) &&
+               (numJoints == 0 || s->numJoints == numJoints);
+    }
+}
+
+struct ofxra_bus{
+    Segment * segment;
+    int fd;
+};
+
+static int mapSegment(int fd, ofxra_bus ** bus){
+    void * p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED){
+        close(fd);
+        return OFXRA_BUS_ERROR;
+    }
+    ofxra_bus * b = new (std::nothrow) ofxra_bus;
+    if(!b){
+        munmap(p, sizeof(Segment));
+        close(fd);
+        return OFXRA_BUS_ERROR;
+    }
+    b->segment = static_cast<Segment *>(p);
+    b->fd = fd;
+    *bus = b;
+    return OFXRA_BUS_OK;
+}
+
+int ofxra_bus_create(const char * name, uint32_t numJoints, ofxra_bus ** bus){
+    if(!bus || numJoints == 0 || numJoints > OFXRA_BUS_MAX_JOINTS){
+        errno = EINVAL;
+        return OFXRA_BUS_ERROR;
+    }
+    int fd = shm_open(shmName(name).c_str(), O_CREAT | O_RDWR, 0660);
+    if(fd < 0){
+        return OFXRA_BUS_ERROR;
+    }
+    // osx refuses to resize an existing segment, so only grow a new one
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (st.st_size < (off_t)sizeof(Segment) && ftruncate(fd, sizeof(Segment)) != 0)){
+        close(fd);
+        return OFXRA_BUS_ERROR;
+    }
+    int ret = mapSegment(fd, bus);
+    if(ret != OFXRA_BUS_OK){
+        return ret;
+    }
+
+    Segment * s = (*bus)->segment;
+    if(sameLayout(s, numJoints)){
+        // left by a previous run, a writer that died mid write leaves a sequence odd
+        s->stateSeq += s->stateSeq & 1;
+        s->commandSeq += s->commandSeq & 1;
+        __atomic_store_n(&s->commandLock, 0, __ATOMIC_RELEASE);
+        return OFXRA_BUS_OK;
+    }
+    __atomic_store_n(&s->magic, 0, __ATOMIC_RELEASE);
+    memset(reinterpret_cast<char *>(s) + sizeof(s->magic), 0, sizeof(Segment) - sizeof(s->magic));
+    s->version = OFXRA_BUS_VERSION;
+    s->size = sizeof(Segment);
+    s->numJoints = numJoints;
+    s->state.num_joints = numJoints;
+    // readers check the magic first, so it goes in last
+    __atomic_store_n(&s->magic, MAGIC, __ATOMIC_RELEASE);
+    return OFXRA_BUS_OK;
+}
+
+int ofxra_bus_open(const char * name, ofxra_bus ** bus){
+    if(!bus){
+        errno = EINVAL;
+        return OFXRA_BUS_ERROR;
+    }
+    int fd = shm_open(shmName(name).c_str(), O_RDWR, 0);
+    if(fd < 0){
+        return errno == ENOENT ? OFXRA_BUS_NOT_READY : OFXRA_BUS_ERROR;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Segment)){
+        close(fd);
+        return OFXRA_BUS_NOT_READY;
+    }
+    int ret = mapSegment(fd, bus);
+    if(ret != OFXRA_BUS_OK){
+        return ret;
+    }
+    if(!sameLayout((*bus)->segment, 0)){
+        ofxra_bus_close(*bus);
+        *bus = nullptr;
+        return OFXRA_BUS_NOT_READY;
+    }
+    return OFXRA_BUS_OK;
+}
+
+void ofxra_bus_close(ofxra_bus * bus){
+    if(!bus){
+        return;
+    }
+    munmap(bus->segment, sizeof(Segment));
+    close(bus->fd);
+    delete bus;
+}
+
+int ofxra_bus_unlink(const char * name){
+    return shm_unlink(shmName(name).c_str()) == 0 ? OFXRA_BUS_OK : OFXRA_BUS_ERROR;
+}
+
+uint32_t ofxra_bus_num_joints(const ofxra_bus * bus){
+    return bus ? bus->segment->numJoints : 0;
+}
+
+uint64_t ofxra_bus_now_us(void){
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int ofxra_bus_write_state(ofxra_bus * bus, ofxra_state * state){
+    if(!bus || !state){
+        return OFXRA_BUS_ERROR;
+    }
+    Segment * s = bus->segment;
+    // only the writer touches state.sequence, a plain read is fine
+    state->sequence = s->state.sequence + 1;
+    writeSeq(&s->stateSeq, &s->state, state, sizeof(ofxra_state));
+    return OFXRA_BUS_OK;
+}
+
+int ofxra_bus_read_state(const ofxra_bus * bus, ofxra_state * state){
+    if(!bus || !state){
+        return OFXRA_BUS_ERROR;
+    }
+    const Segment * s = bus->segment;
+    return readSeq(&s->stateSeq, state, &s->state, sizeof(ofxra_state));
+}
+
+int ofxra_bus_write_command(ofxra_bus * bus, ofxra_command * command){
+    if(!bus || !command || command->num_joints > OFXRA_BUS_MAX_JOINTS){
+        return OFXRA_BUS_ERROR;
+    }
+    Segment * s = bus->segment;
+    int tries = 0;
+    while(__atomic_exchange_n(&s->commandLock, 1, __ATOMIC_ACQUIRE)){
+        if(++tries > LOCK_TRIES){
+            return OFXRA_BUS_BUSY;
+        }
+        sched_yield();
+    }
+    command->id = __atomic_add_fetch(&s->nextCommandId, 1, __ATOMIC_RELEASE);
+    if(command->timestamp_us == 0){
+        command->timestamp_us = ofxra_bus_now_us();
+    }
+    writeSeq(&s->commandSeq, &s->command, command, sizeof(ofxra_command));
+    __atomic_store_n(&s->commandLock, 0, __ATOMIC_RELEASE);
+    return OFXRA_BUS_OK;
+}
+
+int ofxra_bus_read_command(const ofxra_bus * bus, ofxra_command * command, uint64_t * lastId){
+    if(!bus || !command || !lastId){
+        return OFXRA_BUS_ERROR;
+    }
+    const Segment * s = bus->segment;
+    // most polls find nothing new, check the id before copying the slot
+    if(__atomic_load_n(&s->nextCommandId, __ATOMIC_ACQUIRE) == *lastId){
+        return 0;
+    }
+    ofxra_command c;
+    int ret = readSeq(&s->commandSeq, &c, &s->command, sizeof(ofxra_command));
+    if(ret != OFXRA_BUS_OK){
+        return ret;
+    }
+    if(c.id == 0 || c.id == *lastId){
+        return 0;
+    }
+    *command = c;
+    *lastId = c.id;
+    return 1;
+}
@@ -0,0 +1,90 @@
+/*
+ *  state_bus.h
+ *  ofxRobotArm
+ *
+ *  Robot state and a command mailbox on a POSIX shared-memory segment, for
+ *  processes on the same machine (vision, dashboards, cell bridges). Plain C
+ *  with no openFrameworks dependency: build state_bus.cpp into the other
+ *  process (C++11 compiler, link -lrt on older glibc).
+ *
+ *  Each slot is guarded by a seqlock. A writer never waits for readers and a
+ *  reader never blocks a writer; a read that overlaps a write is retried.
+ *  The state has one writer, the driver. Command writers take a spin lock in
+ *  the segment, so several may share a bus. The latest command wins, ids
+ *  let the reader tell a new one from the last one.
+ *
+ *  Timestamps are CLOCK_MONOTONIC microseconds, comparable across processes.
+ *
+ * Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+ */
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OFXRA_BUS_MAX_JOINTS 8
+#define OFXRA_BUS_VERSION 1
+
+/* return codes */
+#define OFXRA_BUS_OK 0
+#define OFXRA_BUS_ERROR -1      /* shm_open/mmap failed, see errno */
+#define OFXRA_BUS_NOT_READY -2  /* segment missing, not initialized or a different layout */
+#define OFXRA_BUS_BUSY -3       /* kept overlapping a write, try again */
+
+/* ofxra_state.flags */
+#define OFXRA_STATE_CONNECTED 1u
+#define OFXRA_STATE_TOOL_VALID 2u
+
+/* ofxra_command.mode */
+#define OFXRA_COMMAND_NONE 0u
+#define OFXRA_COMMAND_POSITION 1u /* values are joint positions, radians */
+#define OFXRA_COMMAND_SPEED 2u    /* values are joint speeds, radians/s */
+
+typedef struct ofxra_state{
+    uint64_t timestamp_us;
+    uint64_t sequence;          /* counts publishes, gaps mean missed updates */
+    uint32_t num_joints;
+    uint32_t flags;
+    double position[OFXRA_BUS_MAX_JOINTS];
+    double velocity[OFXRA_BUS_MAX_JOINTS];
+    double tool_position[3];    /* meters, base frame */
+    double tool_orientation[4]; /* quaternion x, y, z, w */
+} ofxra_state;
+
+typedef struct ofxra_command{
+    uint64_t timestamp_us;
+    uint64_t id;                /* set by ofxra_bus_write_command */
+    uint32_t mode;
+    uint32_t num_joints;
+    double values[OFXRA_BUS_MAX_JOINTS];
+    double acceleration;        /* OFXRA_COMMAND_SPEED only */
+} ofxra_command;
+
+typedef struct ofxra_bus ofxra_bus;
+
+/* creates the segment, or takes over one left by a previous run. name is a
+   shm name such as "/ofxra_ur5", the leading slash is added if missing */
+int ofxra_bus_create(const char * name, uint32_t num_joints, ofxra_bus ** bus);
+/* maps an existing segment created by a driver */
+int ofxra_bus_open(const char * name, ofxra_bus ** bus);
+/* unmaps, the segment stays until ofxra_bus_unlink */
+void ofxra_bus_close(ofxra_bus * bus);
+int ofxra_bus_unlink(const char * name);
+
+uint32_t ofxra_bus_num_joints(const ofxra_bus * bus);
+uint64_t ofxra_bus_now_us(void);
+
+/* single writer, sets sequence */
+int ofxra_bus_write_state(ofxra_bus * bus, ofxra_state * state);
+int ofxra_bus_read_state(const ofxra_bus * bus, ofxra_state * state);
+
+/* sets id and, when 0, timestamp_us */
+int ofxra_bus_write_command(ofxra_bus * bus, ofxra_command * command);
+/* 1 and fills command if its id differs from *last_id (updated), 0 if not */
+int ofxra_bus_read_command(const ofxra_bus * bus, ofxra_command * command, uint64_t * last_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,332 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "BasePlacement.h"
+#include "WorkSurface.h"
+#include "RobotMathOF.h"
+#include "Trace.h"
+#include <chrono>
+
+using namespace ofxRobotArm;
+
+namespace{
+    // a pattern search rarely needs more, this only bounds a slow creep
+    const int MAX_REFINE_EVALUATIONS = 200;
+
+    int getSteps(double min, double max, double step){
+        return step > 0 && max > min ? (int)floor((max - min) / step + 1e-9) + 1 : 1;
+    }
+}
+
+math::Transformd BasePlacement::Candidate::getTransform() const{
+    return math::Transformd(math::Quatd::fromAxisAngle(math::Vec3d(0, 0, 1), yaw), position);
+}
+
+ofQuaternion BasePlacement::Candidate::getOrientation() const{
+    return math::toOF(getTransform().rotation);
+}
+
+BasePlacement::BasePlacement(){
+}
+
+BasePlacement::~BasePlacement(){
+}
+
+void BasePlacement::setup(const KinematicChain * chain, ThreadPool * pool){
+    this->chain = chain;
+    this->pool = pool ? pool : &ThreadPool::getDefault();
+    solver.setup(chain, this->pool);
+    numJoints = chain ? chain->getNumJoints() : 0;
+    seed.assign(numJoints, 0);
+    reach = 0;
+    if(!chain){
+        return;
+    }
+    chain->getLimits(lower, upper);
+    for(int j = 0; j < numJoints; j++){
+        if(std::isfinite(lower[j]) && std::isfinite(upper[j])){
+            seed[j] = (lower[j] + upper[j]) * 0.5;
+        }
+    }
+    // no target further from the base than every link laid end to end
+    for(const auto & joint : chain->getJoints()){
+        reach += joint.origin.translation.length();
+        if(joint.type == KinematicChain::PRISMATIC){
+            reach += MAX(fabs(joint.lower), fabs(joint.upper));
+        }
+    }
+    axes.resize(numJoints);
+    origins.resize(numJoints);
+}
+
+NumericIK & BasePlacement::getSolver(){
+    return solver;
+}
+
+void BasePlacement::setToolFrame(const math::Transformd & pathToTip){
+    toolFrame = pathToTip;
+}
+
+void BasePlacement::setTargets(const vector<math::Transformd> & targets){
+    this->targets = targets;
+}
+
+void BasePlacement::setTargets(const vector<Path *> & paths, int stride){
+    targets.clear();
+    stride = MAX(1, stride);
+    for(Path * path : paths){
+        for(int i = 0; i < path->size(); i += stride){
+            targets.push_back(math::Transformd::fromMatrix(math::toMath(path->getPoseAt(i))));
+        }
+    }
+}
+
+void BasePlacement::setTargets(WorkSurface & surface, int stride){
+    setTargets(surface.getPaths(), stride);
+}
+
+void BasePlacement::setSeed(const vector<double> & seed){
+    this->seed = seed;
+}
+
+void BasePlacement::setSearchArea(const math::Vec3d & min, const math::Vec3d & max, double step){
+    searchMin = min;
+    searchMax = max;
+    searchStep = step;
+}
+
+void BasePlacement::setYawRange(double min, double max, double step){
+    yawMin = min;
+    yawMax = max;
+    yawStep = step;
+}
+
+void BasePlacement::setWeights(double reachability, double manipulability, double limitMargin){
+    reachabilityWeight = reachability;
+    manipulabilityWeight = manipulability;
+    limitMarginWeight = limitMargin;
+}
+
+void BasePlacement::setRefinement(int count, double minStep){
+    refineCount = count;
+    refineMinStep = minStep;
+}
+
+BasePlacement::Candidate BasePlacement::evaluate(const math::Vec3d & position, double yaw){
+    Candidate candidate;
+    candidate.position = position;
+    candidate.yaw = yaw;
+    candidate.total = targets.size();
+    if(!solver.isSetup()){
+        ofLogError("BasePlacement") << "evaluate: no chain, call setup first";
+        return candidate;
+    }
+
+    // targets out of reach are skipped before they cost a solve
+    math::Transformd base = candidate.getTransform().inverse();
+    local.clear();
+    for(const auto & target : targets){
+        math::Transformd t = base * target * toolFrame;
+        if(t.translation.length() <= reach){
+            local.push_back(t);
+        }
+    }
+    solver.solve(local, seed, solutions);
+
+    double manipulability = 0;
+    double margin = 0;
+    candidate.minManipulability = std::numeric_limits<double>::max();
+    for(const auto & q : solutions){
+        if(q.empty()){
+            continue;
+        }
+        candidate.reached++;
+        double m = getManipulability(q);
+        manipulability += m;
+        candidate.minManipulability = MIN(candidate.minManipulability, m);
+        margin += getLimitMargin(q);
+    }
+    if(candidate.reached > 0){
+        candidate.manipulability = manipulability / candidate.reached;
+        candidate.limitMargin = margin / candidate.reached;
+    }else{
+        candidate.minManipulability = 0;
+    }
+    candidate.reachability = candidate.total > 0 ? (double)candidate.reached / candidate.total : 0;
+    score(candidate);
+    return candidate;
+}
+
+void BasePlacement::score(Candidate & candidate){
+    // reachability scales the rest, a well conditioned base that misses half the job is no good
+    double weights = reachabilityWeight + manipulabilityWeight + limitMarginWeight;
+    double quality = reachabilityWeight +
+                     manipulabilityWeight * MIN(1.0, candidate.manipulability / manipulabilityScale) +
+                     limitMarginWeight * candidate.limitMargin;
+    candidate.score = weights > 0 ? candidate.reachability * quality / weights : candidate.reachability;
+}
+
+vector<BasePlacement::Candidate> BasePlacement::run(){
+    RA_TRACE_SCOPE("baseplacement.run");
+    vector<Candidate> candidates;
+    if(!solver.isSetup()){
+        ofLogError("BasePlacement") << "run: no chain, call setup first";
+        return candidates;
+    }
+    if(targets.empty()){
+        ofLogError("BasePlacement") << "run: no targets";
+        return candidates;
+    }
+    auto begin = std::chrono::steady_clock::now();
+
+    int nx = getSteps(searchMin.x, searchMax.x, searchStep);
+    int ny = getSteps(searchMin.y, searchMax.y, searchStep);
+    int nz = getSteps(searchMin.z, searchMax.z, searchStep);
+    // a full turn would count -PI and PI twice
+    bool fullTurn = yawMax - yawMin >= TWO_PI - 1e-6;
+    int nyaw = fullTurn && yawStep > 0 ? MAX(1, (int)round((yawMax - yawMin) / yawStep)) : getSteps(yawMin, yawMax, yawStep);
+    candidates.reserve(nx * ny * nz * nyaw + refineCount);
+    for(int z = 0; z < nz; z++){
+        for(int y = 0; y < ny; y++){
+            for(int x = 0; x < nx; x++){
+                math::Vec3d position(searchMin.x + x * searchStep, searchMin.y + y * searchStep, searchMin.z + z * searchStep);
+                for(int k = 0; k < nyaw; k++){
+                    candidates.push_back(evaluate(position, yawMin + k * yawStep));
+                }
+            }
+        }
+    }
+
+    // manipulability has the robot's own scale, the grid's best is the reference
+    manipulabilityScale = 0;
+    for(const auto & c : candidates){
+        manipulabilityScale = MAX(manipulabilityScale, c.manipulability);
+    }
+    if(manipulabilityScale <= 0){
+        manipulabilityScale = 1.0;
+    }
+    for(auto & c : candidates){
+        score(c);
+    }
+    auto byScore = [](const Candidate & a, const Candidate & b){ return a.score > b.score; };
+    std::sort(candidates.begin(), candidates.end(), byScore);
+
+    // neighbouring grid candidates often climb to the same spot, only the first one keeps it
+    for(int i = 0; i < refineCount && i < (int)candidates.size(); i++){
+        Candidate refined = refine(candidates[i]);
+        bool duplicate = false;
+        for(int k = 0; k < i; k++){
+            if((candidates[k].position - refined.position).length() < refineMinStep &&
+               fabs(math::wrapAngle(candidates[k].yaw - refined.yaw)) < 1e-3){
+                duplicate = true;
+            }
+        }
+        if(!duplicate){
+            candidates[i] = refined;
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), byScore);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    const Candidate & best = candidates[0];
+    ofLogNotice("BasePlacement") << candidates.size() << " candidates x " << targets.size() << " targets in " << seconds << " s, best at "
+                                 << best.position.x << ", " << best.position.y << ", " << best.position.z << " yaw " << ofRadToDeg(best.yaw)
+                                 << " reaching " << (best.reachability * 100) << "%";
+    return candidates;
+}
+
+BasePlacement::Candidate BasePlacement::refine(Candidate candidate){
+    // pattern search: step each axis both ways, halve the steps once nothing improves
+    double step = searchStep * 0.5;
+    double angleStep = yawStep * 0.5;
+    int evaluations = 0;
+    while(step >= refineMinStep && evaluations < MAX_REFINE_EVALUATIONS){
+        bool improved = false;
+        for(int axis = 0; axis < 4 && !improved; axis++){
+            if(axis < 3 && searchMax[axis] <= searchMin[axis]){
+                continue;
+            }
+            for(int sign = -1; sign <= 1 && !improved; sign += 2){
+                math::Vec3d position = candidate.position;
+                double yaw = candidate.yaw;
+                if(axis < 3){
+                    position[axis] = ofClamp(position[axis] + sign * step, searchMin[axis], searchMax[axis]);
+                }else{
+                    yaw = math::wrapAngle(yaw + sign * angleStep);
+                }
+                Candidate next = evaluate(position, yaw);
+                evaluations++;
+                if(next.score > candidate.score){
+                    candidate = next;
+                    improved = true;
+                }
+            }
+        }
+        if(!improved){
+            step *= 0.5;
+            angleStep *= 0.5;
+        }
+    }
+    return candidate;
+}
+
+double BasePlacement::getManipulability(const vector<double> & q){
+    // sqrt(det(J J^T)), from the Cholesky factor of J J^T
+    math::Vec3d tip = chain->forward(q.data(), axes.data(), origins.data()).translation;
+    double j[6][16] = {};
+    int n = MIN(numJoints, 16);
+    for(const auto & joint : chain->getJoints()){
+        int i = joint.index;
+        if(i < 0 || i >= n){
+            continue;
+        }
+        math::Vec3d linear = joint.type == KinematicChain::PRISMATIC ? axes[i] : axes[i].cross(tip - origins[i]);
+        math::Vec3d angular = joint.type == KinematicChain::PRISMATIC ? math::Vec3d() : axes[i];
+        for(int r = 0; r < 3; r++){
+            j[r][i] = linear[r];
+            j[r + 3][i] = angular[r];
+        }
+    }
+    double a[6][6];
+    for(int r = 0; r < 6; r++){
+        for(int c = 0; c <= r; c++){
+            double s = 0;
+            for(int i = 0; i < n; i++){
+                s += j[r][i] * j[c][i];
+            }
+            a[r][c] = s;
+        }
+    }
+    double product = 1;
+    for(int c = 0; c < 6; c++){
+        double d = a[c][c];
+        for(int k = 0; k < c; k++){
+            d -= a[c][k] * a[c][k];
+        }
+        if(d <= 1e-18){
+            return 0;
+        }
+        d = sqrt(d);
+        product *= d;
+        for(int r = c + 1; r < 6; r++){
+            double s = a[r][c];
+            for(int k = 0; k < c; k++){
+                s -= a[r][k] * a[c][k];
+            }
+            a[r][c] = s / d;
+        }
+    }
+    return product;
+}
+
+double BasePlacement::getLimitMargin(const vector<double> & q){
+    double margin = 1.0;
+    for(int j = 0; j < numJoints; j++){
+        if(!std::isfinite(lower[j]) || !std::isfinite(upper[j]) || upper[j] <= lower[j]){
+            continue;
+        }
+        double half = (upper[j] - lower[j]) * 0.5;
+        margin = MIN(margin, MIN(q[j] - lower[j], upper[j] - q[j]) / half);
+    }
+    return MAX(margin, 0.0);
+}
@@ -0,0 +1,120 @@
+//
+//  BasePlacement.h
+//  ofxRobotArm
+//
+//  Searches robot base positions and yaws for a set of tool targets, e.g.
+//  every path frame of a WorkSurface3D. The idea is to pick the cell layout
+//  before installing it.
+//
+//  Every candidate solves all targets in the candidate's base frame with
+//  the NumericIK batch, which spreads them over the thread pool. It is
+//  scored by the fraction reached, the mean manipulability (Yoshikawa,
+//  normalized by the best candidate of the grid) and the mean joint limit
+//  margin. run() evaluates a grid over the search area, then polishes the
+//  best few with a pattern search and returns everything ranked.
+//
+//  Targets and results are in meters in the surface's frame. To apply a
+//  result, call LegacyRobotController::setRobotOrigin(position * 1000,
+//  getOrientation()), since the models are drawn in mm.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "KinematicChain.h"
+#include "NumericIK.h"
+#include "Path.h"
+#include "RobotMath.h"
+
+namespace ofxRobotArm{
+    class WorkSurface;
+
+    class BasePlacement{
+    public:
+        struct Candidate{
+            math::Vec3d position;
+            /// \brief rad about z
+            double yaw = 0;
+            int reached = 0;
+            int total = 0;
+            /// \brief fraction of the targets reached
+            double reachability = 0;
+            /// \brief mean and worst over the reached targets
+            double manipulability = 0;
+            double minManipulability = 0;
+            /// \brief mean over the reached targets of the joint closest to a
+            /// limit, 1 at the middle of the range, 0 at the limit
+            double limitMargin = 0;
+            double score = 0;
+
+            math::Transformd getTransform() const;
+            ofQuaternion getOrientation() const;
+        };
+
+        BasePlacement();
+        ~BasePlacement();
+
+        /// \brief chain has to outlive the optimizer, pool defaults to ThreadPool::getDefault()
+        void setup(const KinematicChain * chain, ThreadPool * pool = nullptr);
+        /// \brief the solver, to change its tolerance, iterations or starts
+        NumericIK & getSolver();
+
+        /// \brief where the chain's tip sits in a path frame, tool offset included
+        void setToolFrame(const math::Transformd & pathToTip);
+        void setTargets(const vector<math::Transformd> & targets);
+        /// \brief every stride-th frame of each path
+        void setTargets(const vector<Path *> & paths, int stride = 1);
+        void setTargets(WorkSurface & surface, int stride = 1);
+        /// \brief joints every target starts from, defaults to the middle of the limits
+        void setSeed(const vector<double> & seed);
+
+        /// \brief base positions on a grid of step from min to max, set
+        /// min.z = max.z for a base on the floor
+        void setSearchArea(const math::Vec3d & min, const math::Vec3d & max, double step);
+        void setYawRange(double min, double max, double step);
+        void setWeights(double reachability, double manipulability, double limitMargin);
+        /// \brief best grid candidates polished further, stops below minStep
+        void setRefinement(int count, double minStep = 0.005);
+
+        /// \brief scores a single base placement
+        Candidate evaluate(const math::Vec3d & position, double yaw);
+        /// \brief every grid candidate, best first
+        vector<Candidate> run();
+
+    protected:
+        void score(Candidate & candidate);
+        Candidate refine(Candidate candidate);
+        double getManipulability(const vector<double> & q);
+        double getLimitMargin(const vector<double> & q);
+
+        const KinematicChain * chain = nullptr;
+        ThreadPool * pool = nullptr;
+        NumericIK solver;
+        int numJoints = 0;
+        vector<double> lower;
+        vector<double> upper;
+        vector<double> seed;
+        double reach = 0;
+
+        math::Transformd toolFrame;
+        vector<math::Transformd> targets;
+
+        math::Vec3d searchMin = math::Vec3d(-1, -1, 0);
+        math::Vec3d searchMax = math::Vec3d(1, 1, 0);
+        double searchStep = 0.1;
+        double yawMin = -PI;
+        double yawMax = PI;
+        double yawStep = PI / 6;
+        double reachabilityWeight = 1.0;
+        double manipulabilityWeight = 0.5;
+        double limitMarginWeight = 0.5;
+        int refineCount = 3;
+        double refineMinStep = 0.005;
+        double manipulabilityScale = 1.0;
+
+        vector<math::Transformd> local;
+        vector<vector<double>> solutions;
+        vector<math::Vec3d> axes;
+        vector<math::Vec3d> origins;
+    };
+}
@@ -0,0 +1,245 @@
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#include "CollisionChecker.h"
+#include "RobotMathOF.h"
+
+using namespace ofxRobotArm;
+
+CollisionChecker::CollisionChecker(){
+}
+
+CollisionChecker::~CollisionChecker(){
+}
+
+void CollisionChecker::setup(const KinematicChain * chain, double linkRadius){
+    this->chain = chain;
+    numJoints = chain ? chain->getNumJoints() : 0;
+    linkRadii.assign(numJoints + 1, linkRadius);
+    tool.clear();
+    bSelfCollision = false;
+    layout();
+}
+
+const KinematicChain * CollisionChecker::getChain() const{
+    return chain;
+}
+
+void CollisionChecker::setLinkRadius(int link, double radius){
+    if(link < 0 || link >= (int)linkRadii.size()){
+        ofLogError("CollisionChecker") << "setLinkRadius: no link " << link;
+        return;
+    }
+    linkRadii[link] = radius;
+    layout();
+}
+
+void CollisionChecker::addToolSphere(const math::Vec3d & center, double radius){
+    Sphere s;
+    s.center = center;
+    s.radius = radius;
+    tool.push_back(s);
+    layout();
+}
+
+void CollisionChecker::clearTool(){
+    tool.clear();
+    layout();
+}
+
+void CollisionChecker::setMargin(double meters){
+    margin = meters;
+}
+
+void CollisionChecker::addBox(const math::Transformd & pose, const math::Vec3d & size){
+    Box box;
+    box.pose = pose;
+    box.halfSize = size * 0.5;
+    boxes.push_back(box);
+}
+
+void CollisionChecker::addBox(const ofVec3f & center, const ofVec3f & size, const ofQuaternion & orientation){
+    addBox(math::Transformd(math::toMath(orientation), math::toMath(center)), math::toMath(size));
+}
+
+void CollisionChecker::addSphere(const math::Vec3d & center, double radius){
+    Sphere s;
+    s.center = center;
+    s.radius = radius;
+    spheres.push_back(s);
+}
+
+void CollisionChecker::clearObstacles(){
+    boxes.clear();
+    spheres.clear();
+}
+
+const vector<CollisionChecker::Box> & CollisionChecker::getBoxes() const{
+    return boxes;
+}
+
+const vector<CollisionChecker::Sphere> & CollisionChecker::getSpheres() const{
+    return spheres;
+}
+
+void CollisionChecker::layout(){
+    // the segment between two joint origins is rigid in its link, so the
+    // number of spheres per link doesn't depend on q
+    int numGroups = numJoints + 2;
+    groupStart.assign(numGroups, 0);
+    groupCount.assign(numGroups, 0);
+    numSpheres = 0;
+    if(!chain || numJoints == 0){
+        return;
+    }
+    vector<double> zero(numJoints, 0);
+    vector<math::Vec3d> axes(numJoints), origins(numJoints);
+    math::Vec3d tip = chain->forward(zero.data(), axes.data(), origins.data()).translation;
+    for(int link = 0; link <= numJoints; link++){
+        math::Vec3d from = link == 0 ? math::Vec3d() : origins[link - 1];
+        math::Vec3d to = link == numJoints ? tip : origins[link];
+        double radius = linkRadii[link];
+        double length = (to - from).length();
+        groupStart[link] = numSpheres;
+        groupCount[link] = radius > 0 ? (int)ceil(length / radius) + 1 : 0;
+        numSpheres += groupCount[link];
+    }
+    groupStart[numJoints + 1] = numSpheres;
+    groupCount[numJoints + 1] = tool.size();
+    numSpheres += tool.size();
+    selfPairs.assign(numGroups * numGroups, false);
+    bSelfCollision = false;
+}
+
+void CollisionChecker::placeSpheres(const double * q, Scratch & scratch) const{
+    scratch.axes.resize(numJoints);
+    scratch.origins.resize(numJoints);
+    scratch.spheres.resize(numSpheres);
+    math::Transformd tip = chain->forward(q, scratch.axes.data(), scratch.origins.data());
+    for(int link = 0; link <= numJoints; link++){
+        int count = groupCount[link];
+        if(count == 0){
+            continue;
+        }
+        math::Vec3d from = link == 0 ? math::Vec3d() : scratch.origins[link - 1];
+        math::Vec3d to = link == numJoints ? tip.translation : scratch.origins[link];
+        Sphere * s = &scratch.spheres[groupStart[link]];
+        for(int i = 0; i < count; i++){
+            s[i].center = count > 1 ? from + (to - from) * ((double)i / (count - 1)) : from;
+            s[i].radius = linkRadii[link];
+        }
+    }
+    Sphere * s = &scratch.spheres[groupStart[numJoints + 1]];
+    for(size_t i = 0; i < tool.size(); i++){
+        s[i].center = tip.transformPoint(tool[i].center);
+        s[i].radius = tool[i].radius;
+    }
+}
+
+bool CollisionChecker::touches(const Scratch & scratch, int a, int b) const{
+    for(int i = groupStart[a]; i < groupStart[a] + groupCount[a]; i++){
+        const Sphere & s = scratch.spheres[i];
+        for(int j = groupStart[b]; j < groupStart[b] + groupCount[b]; j++){
+            const Sphere & t = scratch.spheres[j];
+            double r = s.radius + t.radius;
+            if((s.center - t.center).lengthSquared() < r * r){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void CollisionChecker::setSelfCollision(bool enabled, const vector<double> & reference){
+    bSelfCollision = false;
+    int numGroups = numJoints + 2;
+    selfPairs.assign(numGroups * numGroups, false);
+    if(!enabled || !chain){
+        return;
+    }
+    if((int)reference.size() < numJoints){
+        ofLogError("CollisionChecker") << "setSelfCollision: reference has " << reference.size() << " joints, the chain " << numJoints;
+        return;
+    }
+    Scratch scratch;
+    placeSpheres(reference.data(), scratch);
+    int skipped = 0;
+    for(int a = 0; a < numGroups; a++){
+        for(int b = a + 2; b < numGroups; b++){
+            if(groupCount[a] == 0 || groupCount[b] == 0){
+                continue;
+            }
+            if(touches(scratch, a, b)){
+                skipped++;
+                continue;
+            }
+            selfPairs[a * numGroups + b] = true;
+            bSelfCollision = true;
+        }
+    }
+    if(skipped > 0){
+        ofLogNotice("CollisionChecker") << skipped << " link pairs touch at the reference pose, not checking them against each other";
+    }
+}
+
+bool CollisionChecker::isValid(const double * q, Scratch & scratch) const{
+    if(!chain || numJoints == 0){
+        return true;
+    }
+    placeSpheres(q, scratch);
+
+    // link 0 never moves, it sits on whatever the arm is mounted to
+    for(int i = groupCount[0]; i < numSpheres; i++){
+        const Sphere & s = scratch.spheres[i];
+        for(const Box & box : boxes){
+            // closest point of the box, in the box frame
+            math::Vec3d local = box.pose.rotation.conjugate().rotate(s.center - box.pose.translation);
+            math::Vec3d d;
+            for(int k = 0; k < 3; k++){
+                double v = fabs(local[k]) - box.halfSize[k];
+                d[k] = v > 0 ? v : 0;
+            }
+            double r = s.radius + margin;
+            if(d.lengthSquared() < r * r){
+                return false;
+            }
+        }
+        for(const Sphere & o : spheres){
+            double r = s.radius + o.radius + margin;
+            if((s.center - o.center).lengthSquared() < r * r){
+                return false;
+            }
+        }
+    }
+
+    if(bSelfCollision){
+        int numGroups = numJoints + 2;
+        for(int a = 0; a < numGroups; a++){
+            for(int b = a + 2; b < numGroups; b++){
+                if(selfPairs[a * numGroups + b] && touches(scratch, a, b)){
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool CollisionChecker::isValid(const vector<double> & q) const{
+    if((int)q.size() < numJoints){
+        ofLogError("CollisionChecker") << "isValid: got " << q.size() << " joints, the chain has " << numJoints;
+        return false;
+    }
+    Scratch scratch;
+    return isValid(q.data(), scratch);
+}
+
+void CollisionChecker::getArmSpheres(const vector<double> & q, vector<Sphere> & out) const{
+    out.clear();
+    if(!chain || (int)q.size() < numJoints){
+        return;
+    }
+    Scratch scratch;
+    placeSpheres(q.data(), scratch);
+    out = scratch.spheres;
+}
@@ -0,0 +1,101 @@
+//
+//  CollisionChecker.h
+//  ofxRobotArm
+//
+//  Checks joint configurations of a KinematicChain against box and sphere
+//  obstacles, and optionally against the arm itself.
+//
+//  Each link is modelled by spheres along the straight segment from its
+//  joint to the next one (the first link starts at the base, the last one
+//  ends at the tip). Each sphere's radius is the link's radius and the
+//  spheres are spaced one radius apart. The model is coarse, so give the
+//  radii some slack. Tools and grippers are added as spheres in the tip
+//  frame. The base link doesn't move, so it's only checked against the
+//  rest of the arm, never against obstacles.
+//
+//  Everything is in meters, in the chain's base frame.
+//
+// Copyright (c) 2016, 2021 Daniel Moore, Madeline Gannon, and The Frank-Ratchye STUDIO for Creative Inquiry All rights reserved.
+////
+#pragma once
+#include "ofMain.h"
+#include "KinematicChain.h"
+#include "RobotMath.h"
+
+namespace ofxRobotArm{
+    class CollisionChecker{
+    public:
+        struct Sphere{
+            math::Vec3d center;
+            double radius = 0;
+        };
+
+        struct Box{
+            /// \brief center and orientation
+            math::Transformd pose;
+            math::Vec3d halfSize;
+        };
+
+        /// \brief per thread buffers for isValid, so checks can run in parallel
+        struct Scratch{
+            vector<math::Vec3d> axes;
+            vector<math::Vec3d> origins;
+            vector<Sphere> spheres;
+        };
+
+        CollisionChecker();
+        ~CollisionChecker();
+
+        /// \brief chain has to outlive the checker
+        void setup(const KinematicChain * chain, double linkRadius = 0.05);
+        const KinematicChain * getChain() const;
+        /// \brief link 0 runs from the base to the first joint, link getNumJoints() ends at the tip
+        void setLinkRadius(int link, double radius);
+        /// \brief center in the tip frame
+        void addToolSphere(const math::Vec3d & center, double radius);
+        void clearTool();
+
+        /// \brief extra clearance kept from obstacles
+        void setMargin(double meters);
+        /// \brief size is the full edge lengths
+        void addBox(const math::Transformd & pose, const math::Vec3d & size);
+        void addBox(const ofVec3f & center, const ofVec3f & size, const ofQuaternion & orientation = ofQuaternion());
+        void addSphere(const math::Vec3d & center, double radius);
+        void clearObstacles();
+        const vector<Box> & getBoxes() const;
+        const vector<Sphere> & getSpheres() const;
+
+        /// \brief checks links two or more apart against each other. Pairs that
+        /// already touch at reference are left out, the skeleton overlaps at
+        /// compact joints like the UR wrist. Changing the radii or the tool
+        /// turns it off again, call it last.
+        void setSelfCollision(bool enabled, const vector<double> & reference);
+
+        /// \brief false if the arm at q hits an obstacle or itself
+        bool isValid(const double * q, Scratch & scratch) const;
+        bool isValid(const vector<double> & q) const;
+        /// \brief the arm's spheres at q, for drawing
+        void getArmSpheres(const vector<double> & q, vector<Sphere> & out) const;
+
+    protected:
+        void layout();
+        void placeSpheres(const double * q, Scratch & scratch) const;
+        bool touches(const Scratch & scratch, int a, int b) const;
+
+        const KinematicChain * chain = nullptr;
+        int numJoints = 0;
+        vector<double> linkRadii;
+        vector<Sphere> tool;
+        /// \brief first sphere of each link, the tool is the last group
+        vector<int> groupStart;
+        vector<int> groupCount;
+        int numSpheres = 0;
+        /// \brief groups x groups, true where the pair is checked
+        vector<bool> selfPairs;
+        bool bSelfCollision = false;
+
+        vector<Box> boxes;
+        vector<Sphere> spheres;
+        double margin = 0.01;
+    };
+}